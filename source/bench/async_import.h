@@ -0,0 +1,81 @@
+#pragma once
+
+#include <teximp/teximp.h>
+
+#include <concepts>
+#include <coroutine>
+#include <exception>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <utility>
+
+// Anything tasks can be posted to, like ThreadPool.
+template<class T>
+concept ImportExecutor = requires(T& executor, std::function<void()> task) {
+    executor.post(std::move(task));
+};
+
+// Imports the file on the executor. The calling thread only pays for queuing the task.
+template<ImportExecutor Executor>
+std::future<teximp::TextureImportResult> importTextureAsync(std::filesystem::path filePath, Executor& executor)
+{
+    // std::function needs a copyable callable, packaged_task is move only
+    auto task = std::make_shared<std::packaged_task<teximp::TextureImportResult()>>(
+        [filePath = std::move(filePath)]() { return teximp::importTexture(filePath); });
+
+    std::future<teximp::TextureImportResult> future = task->get_future();
+    executor.post([task]() { (*task)(); });
+
+    return future;
+}
+
+// co_await importTextureAwaitable(path, executor) suspends the coroutine, imports on the executor and resumes
+// the coroutine on the executor thread that ran the import.
+template<ImportExecutor Executor>
+class ImportTextureAwaitable
+{
+public:
+    ImportTextureAwaitable(std::filesystem::path filePath, Executor& executor)
+        : mFilePath(std::move(filePath))
+        , mExecutor(executor)
+    {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> coroutine)
+    {
+        mExecutor.post([this, coroutine]()
+            {
+                try
+                {
+                    mResult = teximp::importTexture(mFilePath);
+                }
+                catch(...)
+                {
+                    mException = std::current_exception();
+                }
+
+                coroutine.resume();
+            });
+    }
+
+    teximp::TextureImportResult await_resume()
+    {
+        if(mException) { std::rethrow_exception(mException); }
+        return std::move(mResult);
+    }
+
+private:
+    std::filesystem::path mFilePath;
+    Executor& mExecutor;
+    teximp::TextureImportResult mResult;
+    std::exception_ptr mException;
+};
+
+template<ImportExecutor Executor>
+ImportTextureAwaitable<Executor> importTextureAwaitable(std::filesystem::path filePath, Executor& executor)
+{
+    return ImportTextureAwaitable<Executor>(std::move(filePath), executor);
+}
@@ -0,0 +1,16 @@
+#include "cache_file.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+std::filesystem::path temporaryPathFor(const std::filesystem::path& path)
+{
+    std::random_device device;
+    char suffix[17];
+    std::snprintf(suffix, sizeof(suffix), "%08x%08x", device(), device());
+
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += "." + std::string(suffix) + ".tmp";
+    return temporaryPath;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+
+// Helpers shared by the files the texture cache and the thumbnail pack write.
+
+// alignment must be a power of two
+inline uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// A sibling of path to write to before renaming it over path. Writers in other threads or processes sharing the
+// directory get different names, the suffix is 64 random bits.
+std::filesystem::path temporaryPathFor(const std::filesystem::path& path);
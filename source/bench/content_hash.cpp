@@ -0,0 +1,55 @@
+#include "content_hash.h"
+
+#include <bit>
+#include <cstring>
+
+namespace
+{
+uint64_t mix64(uint64_t value)
+{
+    // splitmix64 finalizer
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ull;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebull;
+    value ^= value >> 31;
+    return value;
+}
+}
+
+// Two independent 64 bit lanes over 8 byte words, finalized together. Runs at memory speed, which matters because
+// every lookup hashes the whole source file.
+std::array<uint64_t, 2> hashBytes(std::span<const std::byte> bytes, std::array<uint64_t, 2> seed)
+{
+    uint64_t lane0 = seed[0] ^ 0x9e3779b97f4a7c15ull;
+    uint64_t lane1 = seed[1] ^ 0xc2b2ae3d27d4eb4full;
+
+    const size_t wordCount = bytes.size() / 8;
+
+    for(size_t i = 0; i < wordCount; ++i)
+    {
+        uint64_t word;
+        std::memcpy(&word, bytes.data() + i * 8, 8);
+
+        lane0 = std::rotl((lane0 ^ word) * 0x87c37b91114253d5ull, 31);
+        lane1 = std::rotl((lane1 + word) * 0x4cf5ad432745937full, 29) ^ lane0;
+    }
+
+    // Empty files map to a null data pointer, which memcpy must not be given even for 0 bytes
+    uint64_t tail = 0;
+    const size_t tailSize = bytes.size() - wordCount * 8;
+    if(tailSize > 0)
+    {
+        std::memcpy(&tail, bytes.data() + wordCount * 8, tailSize);
+    }
+
+    lane0 = mix64(lane0 ^ tail ^ (uint64_t)bytes.size());
+    lane1 = mix64(lane1 + tail + lane0);
+
+    return {lane0, lane1};
+}
+
+std::array<uint64_t, 2> hashString(std::string_view value, std::array<uint64_t, 2> seed)
+{
+    return hashBytes(std::as_bytes(std::span(value.data(), value.size())), seed);
+}
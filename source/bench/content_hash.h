@@ -0,0 +1,12 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// 128 bit hash for content addressing. Not cryptographic, it only has to make accidental collisions practically
+// impossible. Pass the result of a previous call as the seed to continue a hash over more data.
+std::array<uint64_t, 2> hashBytes(std::span<const std::byte> bytes, std::array<uint64_t, 2> seed = {});
+std::array<uint64_t, 2> hashString(std::string_view value, std::array<uint64_t, 2> seed = {});
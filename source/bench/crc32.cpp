@@ -0,0 +1,203 @@
+#include "crc32.h"
+
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define TEXIMP_BENCH_HAS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace
+{
+using Crc32Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+// Table n advances a byte through n further zero bytes, so eight bytes are folded with eight independent lookups
+const Crc32Tables& crc32Tables()
+{
+    static const Crc32Tables tables = []()
+    {
+        Crc32Tables values;
+
+        for(uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+            for(int bit = 0; bit < 8; ++bit)
+            {
+                crc = (crc & 1) ? 0xedb88320u ^ (crc >> 1) : crc >> 1;
+            }
+            values[0][i] = crc;
+        }
+
+        for(size_t table = 1; table < values.size(); ++table)
+        {
+            for(size_t i = 0; i < 256; ++i)
+            {
+                values[table][i] = values[0][values[table - 1][i] & 0xff] ^ (values[table - 1][i] >> 8);
+            }
+        }
+
+        return values;
+    }();
+
+    return tables;
+}
+
+// The CRC is passed in and out inverted, as the register holds it
+uint32_t crc32Scalar(const std::byte* data, size_t size, uint32_t crc)
+{
+    static_assert(std::endian::native == std::endian::little, "words are folded as little endian");
+
+    const Crc32Tables& tables = crc32Tables();
+
+    for(; size >= 8; size -= 8, data += 8)
+    {
+        uint32_t low;
+        uint32_t high;
+        std::memcpy(&low, data, sizeof(low));
+        std::memcpy(&high, data + 4, sizeof(high));
+        low ^= crc;
+
+        crc = tables[7][low & 0xff] ^ tables[6][(low >> 8) & 0xff] ^ tables[5][(low >> 16) & 0xff] ^ tables[4][low >> 24] ^
+              tables[3][high & 0xff] ^ tables[2][(high >> 8) & 0xff] ^ tables[1][(high >> 16) & 0xff] ^ tables[0][high >> 24];
+    }
+
+    for(; size > 0; --size, ++data)
+    {
+        crc = tables[0][(crc ^ (uint32_t)*data) & 0xff] ^ (crc >> 8);
+    }
+
+    return crc;
+}
+
+#ifdef TEXIMP_BENCH_HAS_X86
+#ifdef _MSC_VER
+#define TEXIMP_BENCH_TARGET_PCLMUL
+#else
+#define TEXIMP_BENCH_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#endif
+
+TEXIMP_BENCH_TARGET_PCLMUL inline __m128i load(const std::byte* bytes)
+{
+    return _mm_loadu_si128((const __m128i*)bytes);
+}
+
+// Multiplies both halves of a lane by the matching constant, which moves it that far along the message
+TEXIMP_BENCH_TARGET_PCLMUL inline __m128i fold(__m128i lane, __m128i constants, __m128i next)
+{
+    const __m128i low = _mm_clmulepi64_si128(lane, constants, 0x00);
+    const __m128i high = _mm_clmulepi64_si128(lane, constants, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(low, high), next);
+}
+
+// Folding with carry-less multiplication, from Intel's "Fast CRC Computation for Generic Polynomials Using
+// PCLMULQDQ Instruction". Four 128 bit lanes are folded 64 bytes at a time, then into one lane, then reduced to
+// 32 bits with Barrett reduction. The constants are powers of x modulo the bit reflected polynomial.
+TEXIMP_BENCH_TARGET_PCLMUL uint32_t crc32Pclmul(const std::byte* data, size_t size, uint32_t crc)
+{
+    if(size < 64) { return crc32Scalar(data, size, crc); }
+
+    const __m128i k1k2 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+    const __m128i k3k4 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+    const __m128i k5 = _mm_set_epi64x(0, 0x0163cd6124);
+    const __m128i polynomial = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+    const __m128i low32Mask = _mm_setr_epi32(-1, 0, -1, 0);
+
+    __m128i lane0 = _mm_xor_si128(load(data), _mm_cvtsi32_si128((int)crc));
+    __m128i lane1 = load(data + 16);
+    __m128i lane2 = load(data + 32);
+    __m128i lane3 = load(data + 48);
+    data += 64;
+    size -= 64;
+
+    for(; size >= 64; size -= 64, data += 64)
+    {
+        lane0 = fold(lane0, k1k2, load(data));
+        lane1 = fold(lane1, k1k2, load(data + 16));
+        lane2 = fold(lane2, k1k2, load(data + 32));
+        lane3 = fold(lane3, k1k2, load(data + 48));
+    }
+
+    __m128i folded = fold(lane0, k3k4, lane1);
+    folded = fold(folded, k3k4, lane2);
+    folded = fold(folded, k3k4, lane3);
+
+    for(; size >= 16; size -= 16, data += 16)
+    {
+        folded = fold(folded, k3k4, load(data));
+    }
+
+    // 128 to 64 bits, then 64 to 32 bits
+    folded = _mm_xor_si128(_mm_srli_si128(folded, 8), _mm_clmulepi64_si128(folded, k3k4, 0x10));
+    folded = _mm_xor_si128(_mm_srli_si128(folded, 4), _mm_clmulepi64_si128(_mm_and_si128(folded, low32Mask), k5, 0x00));
+
+    __m128i reduced = _mm_clmulepi64_si128(_mm_and_si128(folded, low32Mask), polynomial, 0x10);
+    reduced = _mm_clmulepi64_si128(_mm_and_si128(reduced, low32Mask), polynomial, 0x00);
+    crc = (uint32_t)_mm_extract_epi32(_mm_xor_si128(folded, reduced), 1);
+
+    return crc32Scalar(data, size, crc);
+}
+
+bool cpuHasPclmul()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) != 0 && (info[2] & (1 << 19)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("sse4.1");
+#endif
+}
+#elif defined(__ARM_FEATURE_CRC32)
+uint32_t crc32Arm(const std::byte* data, size_t size, uint32_t crc)
+{
+    for(; size >= 8; size -= 8, data += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc = __crc32d(crc, word);
+    }
+
+    for(; size > 0; --size, ++data)
+    {
+        crc = __crc32b(crc, (uint8_t)*data);
+    }
+
+    return crc;
+}
+#endif
+
+using Crc32Function = uint32_t (*)(const std::byte*, size_t, uint32_t);
+
+Crc32Function crc32Function()
+{
+    static const Crc32Function function = []() -> Crc32Function
+    {
+#if defined(TEXIMP_BENCH_HAS_X86)
+        if(cpuHasPclmul()) { return crc32Pclmul; }
+#elif defined(__ARM_FEATURE_CRC32)
+        return crc32Arm;
+#endif
+        return crc32Scalar;
+    }();
+
+    return function;
+}
+}
+
+uint32_t crc32(std::span<const std::byte> bytes, uint32_t crc)
+{
+    return ~crc32Function()(bytes.data(), bytes.size(), ~crc);
+}
+
+bool crc32IsAccelerated()
+{
+    return crc32Function() != crc32Scalar;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// CRC-32 as used by zlib and PNG (reflected polynomial 0xedb88320). Pass the result of a previous call to continue
+// a checksum over more data. Folds with PCLMULQDQ on x86 CPUs that have it, checked once at run time, uses the
+// ARMv8 CRC32 instructions when the build targets them and slicing by 8 tables otherwise.
+uint32_t crc32(std::span<const std::byte> bytes, uint32_t crc = 0);
+
+// Whether crc32 runs on PCLMULQDQ or the ARMv8 CRC32 instructions
+bool crc32IsAccelerated();
@@ -0,0 +1,184 @@
+#include "half_float.h"
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define TEXIMP_BENCH_HAS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace
+{
+void floatsToHalvesScalar(const float* source, std::byte* destination, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        const uint16_t half = floatToHalf(source[i]);
+        std::memcpy(destination + i * 2, &half, sizeof(half));
+    }
+}
+
+void halvesToFloatsScalar(const std::byte* source, float* destination, size_t count)
+{
+    for(size_t i = 0; i < count; ++i)
+    {
+        uint16_t half;
+        std::memcpy(&half, source + i * 2, sizeof(half));
+        destination[i] = halfToFloat(half);
+    }
+}
+
+#ifdef TEXIMP_BENCH_HAS_X86
+// MSVC compiles the intrinsics without flags, GCC and clang only inside functions that target the extension
+#ifdef _MSC_VER
+#define TEXIMP_BENCH_TARGET_F16C
+#else
+#define TEXIMP_BENCH_TARGET_F16C __attribute__((target("avx,f16c")))
+#endif
+
+TEXIMP_BENCH_TARGET_F16C void floatsToHalvesF16c(const float* source, std::byte* destination, size_t count)
+{
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        const __m128i halves = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT);
+        _mm_storeu_si128((__m128i*)(destination + i * 2), halves);
+    }
+
+    floatsToHalvesScalar(source + i, destination + i * 2, count - i);
+}
+
+TEXIMP_BENCH_TARGET_F16C void halvesToFloatsF16c(const std::byte* source, float* destination, size_t count)
+{
+    size_t i = 0;
+    for(; i + 8 <= count; i += 8)
+    {
+        const __m128i halves = _mm_loadu_si128((const __m128i*)(source + i * 2));
+        _mm256_storeu_ps(destination + i, _mm256_cvtph_ps(halves));
+    }
+
+    halvesToFloatsScalar(source + i * 2, destination + i, count - i);
+}
+
+bool cpuHasF16c()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+
+    // The 256 bit forms also need the OS to save the YMM registers
+    const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    return osSavesYmm && (info[2] & (1 << 28)) != 0 && (info[2] & (1 << 29)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx") && __builtin_cpu_supports("f16c");
+#endif
+}
+#endif
+
+struct HalfKernels
+{
+    void (*floatsToHalves)(const float*, std::byte*, size_t);
+    void (*halvesToFloats)(const std::byte*, float*, size_t);
+    bool vectorized;
+};
+
+const HalfKernels& halfKernels()
+{
+    static const HalfKernels kernels = []() -> HalfKernels
+    {
+#ifdef TEXIMP_BENCH_HAS_X86
+        if(cpuHasF16c()) { return {floatsToHalvesF16c, halvesToFloatsF16c, true}; }
+#endif
+        return {floatsToHalvesScalar, halvesToFloatsScalar, false};
+    }();
+
+    return kernels;
+}
+}
+
+uint16_t floatToHalf(float value)
+{
+    const uint32_t bits = std::bit_cast<uint32_t>(value);
+    const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    const uint32_t magnitude = bits & 0x7fffffff;
+
+    if(magnitude == 0x7f800000) { return sign | 0x7c00; }
+
+    // NaNs are quieted and keep the top of their payload
+    if(magnitude > 0x7f800000) { return sign | 0x7e00 | (uint16_t)((magnitude >> 13) & 0x3ff); }
+
+    // Rounds to infinity, 65520 and above
+    if(magnitude >= 0x477ff000) { return sign | 0x7c00; }
+
+    // Below the smallest normal half, 2^-14
+    if(magnitude < 0x38800000)
+    {
+        // Rounds to zero, below half of the smallest subnormal
+        if(magnitude <= 0x33000000) { return sign; }
+
+        const uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+        const uint32_t shift = 126 - (magnitude >> 23);
+        uint32_t halfBits = mantissa >> shift;
+
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if(remainder > halfway || (remainder == halfway && (halfBits & 1) != 0)) { ++halfBits; }
+
+        return sign | (uint16_t)halfBits;
+    }
+
+    // Rebias the exponent from 127 to 15 and round the mantissa to nearest even. A carry out of the mantissa
+    // correctly moves to the next exponent.
+    uint32_t halfBits = (magnitude - 0x38000000) >> 13;
+    const uint32_t remainder = magnitude & 0x1fff;
+    if(remainder > 0x1000 || (remainder == 0x1000 && (halfBits & 1) != 0)) { ++halfBits; }
+
+    return sign | (uint16_t)halfBits;
+}
+
+float halfToFloat(uint16_t value)
+{
+    const uint32_t sign = (uint32_t)(value & 0x8000) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1f;
+    const uint32_t mantissa = value & 0x3ff;
+
+    if(exponent == 0)
+    {
+        const float magnitude = std::ldexp((float)mantissa, -24);
+        return (sign != 0) ? -magnitude : magnitude;
+    }
+
+    if(exponent == 31)
+    {
+        if(mantissa == 0) { return std::bit_cast<float>(sign | 0x7f800000); }
+
+        return std::bit_cast<float>(sign | 0x7fc00000 | (mantissa << 13));
+    }
+
+    return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+}
+
+void floatsToHalves(std::span<const float> source, std::span<std::byte> destination)
+{
+    if(destination.size() != source.size() * 2) { return; }
+
+    halfKernels().floatsToHalves(source.data(), destination.data(), source.size());
+}
+
+void halvesToFloats(std::span<const std::byte> source, std::span<float> destination)
+{
+    if(source.size() != destination.size() * 2) { return; }
+
+    halfKernels().halvesToFloats(source.data(), destination.data(), destination.size());
+}
+
+bool halfConversionIsVectorized()
+{
+    return halfKernels().vectorized;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// IEEE 754 half precision, rounding to nearest even. Denormals are converted exactly, infinities stay
+// infinities and NaNs become quiet NaNs that keep the top bits of their payload. That is what the F16C
+// instructions do, so the scalar and the vector conversions give bit identical results.
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+
+// Bulk conversions of unaligned, tightly packed halves. The destination must hold exactly as many values as the
+// source. They use F16C when the CPU has it, checked once at run time, and the scalar conversions otherwise.
+void floatsToHalves(std::span<const float> source, std::span<std::byte> destination);
+void halvesToFloats(std::span<const std::byte> source, std::span<float> destination);
+
+// Whether the bulk conversions run on F16C on this CPU
+bool halfConversionIsVectorized();
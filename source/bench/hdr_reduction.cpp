@@ -0,0 +1,351 @@
+#include "hdr_reduction.h"
+
+#include "half_float.h"
+#include "staging_format.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+constexpr float kInfinity = std::numeric_limits<float>::infinity();
+// Pixels darker than this are measured as if they were this bright, relative errors of near black are meaningless
+constexpr float kErrorFloor = 1.0f / 1024.0f;
+
+struct HdrSourceLayout
+{
+    bool half;
+    size_t componentCount;
+};
+
+bool describeHdrSource(gpufmt::Format format, HdrSourceLayout& layout)
+{
+    switch(format)
+    {
+    case gpufmt::Format::R32G32B32A32_SFLOAT: layout = {false, 4}; return true;
+    case gpufmt::Format::R32G32B32_SFLOAT: layout = {false, 3}; return true;
+    case gpufmt::Format::R16G16B16A16_SFLOAT: layout = {true, 4}; return true;
+    default: return false;
+    }
+}
+
+// Pixels are handled a block at a time, so halves are widened and narrowed by the vector kernels
+constexpr size_t kBlockPixels = 256;
+using PixelBlock = std::array<float, kBlockPixels * 4>;
+
+// Loads pixels as RGBA floats, a missing alpha reads as 1
+void loadPixels(const std::byte* pixels, size_t pixelCount, const HdrSourceLayout& layout, PixelBlock& block)
+{
+    if(layout.half)
+    {
+        halvesToFloats(std::span(pixels, pixelCount * 8), std::span(block).first(pixelCount * 4));
+        return;
+    }
+
+    if(layout.componentCount == 4)
+    {
+        std::memcpy(block.data(), pixels, pixelCount * 4 * sizeof(float));
+        return;
+    }
+
+    for(size_t i = 0; i < pixelCount; ++i)
+    {
+        std::memcpy(block.data() + i * 4, pixels + i * 3 * sizeof(float), 3 * sizeof(float));
+        block[i * 4 + 3] = 1.0f;
+    }
+}
+
+// Unsigned floats with a 5 bit exponent and no sign, the components of B10G11R11
+uint32_t floatToUnsignedSmallFloat(float value, int mantissaBits)
+{
+    if(std::isnan(value) || value <= 0.0f) { return 0; }
+    if(std::isinf(value)) { return 31u << mantissaBits; }
+
+    const uint32_t bits = std::bit_cast<uint32_t>(value);
+    int exponent = (int)((bits >> 23) & 0xff) - 127 + 15;
+    const uint32_t mantissa = (bits & 0x7fffff) | 0x800000;
+    int shift = 23 - mantissaBits;
+
+    // Below the smallest normal the implicit bit is shifted into the mantissa
+    if(exponent <= 0)
+    {
+        shift += 1 - exponent;
+        exponent = 0;
+    }
+
+    if(shift > 24) { return 0; }
+
+    uint32_t rounded = mantissa >> shift;
+    const uint32_t remainder = mantissa & ((1u << shift) - 1);
+    const uint32_t halfway = 1u << (shift - 1);
+
+    if(remainder > halfway || (remainder == halfway && (rounded & 1) != 0))
+    {
+        ++rounded;
+    }
+
+    // Normals keep the implicit bit in rounded, adding it on top of exponent - 1 carries a rounded up mantissa
+    // into the exponent. Overflow ends at infinity.
+    const uint32_t result = (exponent == 0) ? rounded : ((uint32_t)(exponent - 1) << mantissaBits) + rounded;
+    return std::min(result, 31u << mantissaBits);
+}
+
+float unsignedSmallFloatToFloat(uint32_t value, int mantissaBits)
+{
+    const uint32_t exponent = value >> mantissaBits;
+    const uint32_t mantissa = value & ((1u << mantissaBits) - 1);
+
+    if(exponent == 31) { return (mantissa == 0) ? kInfinity : std::numeric_limits<float>::quiet_NaN(); }
+    if(exponent == 0) { return std::ldexp((float)mantissa, -14 - mantissaBits); }
+
+    return std::ldexp((float)(mantissa | (1u << mantissaBits)), (int)exponent - 15 - mantissaBits);
+}
+
+struct CandidateError
+{
+    float maxRelativeError = 0.0f;
+    float maxAbsoluteError = 0.0f;
+
+    void add(float original, float reduced, float pixelMagnitude)
+    {
+        float error = std::abs(reduced - original);
+
+        if(!std::isfinite(original) || !std::isfinite(reduced))
+        {
+            // Matching infinities and NaNs are exact, anything else is unbounded
+            const bool same = (std::isnan(original) && std::isnan(reduced)) || original == reduced;
+            error = same ? 0.0f : kInfinity;
+        }
+
+        // NaN must not slip through std::max, unbounded errors stay unbounded relative to anything
+        const float magnitude = std::isfinite(pixelMagnitude) ? std::max(pixelMagnitude, kErrorFloor) : kInfinity;
+        const float relativeError = std::isfinite(error) ? error / magnitude : kInfinity;
+
+        maxAbsoluteError = std::max(maxAbsoluteError, error);
+        maxRelativeError = std::max(maxRelativeError, relativeError);
+    }
+};
+
+enum Candidate
+{
+    kCandidateE5B9G9R9,
+    kCandidateB10G11R11,
+    kCandidateRgba16Float,
+    kCandidateCount
+};
+
+constexpr std::array<gpufmt::Format, kCandidateCount> kCandidateFormats = {gpufmt::Format::E5B9G9R9_UFLOAT_PACK32,
+                                                                           gpufmt::Format::B10G11R11_UFLOAT_PACK32,
+                                                                           gpufmt::Format::R16G16B16A16_SFLOAT};
+}
+
+uint32_t packB10G11R11(const std::array<float, 3>& rgb)
+{
+    return floatToUnsignedSmallFloat(rgb[0], 6) | (floatToUnsignedSmallFloat(rgb[1], 6) << 11) | (floatToUnsignedSmallFloat(rgb[2], 5) << 22);
+}
+
+std::array<float, 3> unpackB10G11R11(uint32_t packed)
+{
+    return {unsignedSmallFloatToFloat(packed & 0x7ff, 6),
+            unsignedSmallFloatToFloat((packed >> 11) & 0x7ff, 6),
+            unsignedSmallFloatToFloat(packed >> 22, 5)};
+}
+
+uint32_t packE5B9G9R9(const std::array<float, 3>& rgb)
+{
+    constexpr int kMantissaBits = 9;
+    constexpr int kExponentBias = 15;
+    constexpr float kMaxValue = (511.0f / 512.0f) * 65536.0f;
+
+    std::array<float, 3> clamped;
+    for(size_t component = 0; component < 3; ++component)
+    {
+        // Also maps NaN to 0
+        clamped[component] = (rgb[component] > 0.0f) ? std::min(rgb[component], kMaxValue) : 0.0f;
+    }
+
+    const float maxComponent = std::max({clamped[0], clamped[1], clamped[2]});
+    if(maxComponent == 0.0f) { return 0; }
+
+    // frexp gives maxComponent = fraction * 2^exponent with the fraction in [0.5, 1), so floor(log2) is exponent - 1
+    int exponent = 0;
+    std::frexp(maxComponent, &exponent);
+
+    int sharedExponent = std::max(-kExponentBias - 1, exponent - 1) + 1 + kExponentBias;
+    float scale = std::ldexp(1.0f, sharedExponent - kExponentBias - kMantissaBits);
+
+    if(std::floor(maxComponent / scale + 0.5f) == (float)(1 << kMantissaBits))
+    {
+        scale *= 2.0f;
+        ++sharedExponent;
+    }
+
+    uint32_t packed = (uint32_t)sharedExponent << 27;
+    for(size_t component = 0; component < 3; ++component)
+    {
+        packed |= (uint32_t)std::floor(clamped[component] / scale + 0.5f) << (component * kMantissaBits);
+    }
+
+    return packed;
+}
+
+std::array<float, 3> unpackE5B9G9R9(uint32_t packed)
+{
+    const int exponent = (int)(packed >> 27) - 15 - 9;
+
+    return {std::ldexp((float)(packed & 0x1ff), exponent),
+            std::ldexp((float)((packed >> 9) & 0x1ff), exponent),
+            std::ldexp((float)((packed >> 18) & 0x1ff), exponent)};
+}
+
+std::optional<HdrReduction> chooseHdrReduction(const cputex::TextureView& texture, const HdrReductionOptions& options)
+{
+    HdrSourceLayout layout;
+    if(!describeHdrSource(texture.format(), layout)) { return std::nullopt; }
+
+    const size_t pixelBytes = gpufmt::formatInfo(texture.format()).blockByteSize;
+
+    std::array<CandidateError, kCandidateCount> errors;
+    // The packed formats have no alpha
+    bool opaque = true;
+
+    PixelBlock pixels;
+    // The RGBA16 float candidate, converted to half and back
+    std::array<std::byte, kBlockPixels * 8> halves;
+    PixelBlock roundTripped;
+
+    for(cputex::CountType arraySlice = 0; arraySlice < texture.arraySize(); ++arraySlice)
+    {
+        for(cputex::CountType face = 0; face < texture.faces(); ++face)
+        {
+            for(cputex::CountType mip = 0; mip < texture.mips(); ++mip)
+            {
+                const std::span<const std::byte> surface = texture.getMipSurfaceData(arraySlice, face, mip);
+                const size_t pixelCount = surface.size() / pixelBytes;
+
+                for(size_t firstPixel = 0; firstPixel < pixelCount; firstPixel += kBlockPixels)
+                {
+                    const size_t blockPixels = std::min(kBlockPixels, pixelCount - firstPixel);
+                    loadPixels(surface.data() + firstPixel * pixelBytes, blockPixels, layout, pixels);
+
+                    if(!layout.half)
+                    {
+                        const std::span<const float> blockComponents = std::span(pixels).first(blockPixels * 4);
+                        const std::span<std::byte> blockHalves = std::span(halves).first(blockPixels * 8);
+                        floatsToHalves(blockComponents, blockHalves);
+                        halvesToFloats(blockHalves, std::span(roundTripped).first(blockPixels * 4));
+                    }
+
+                    for(size_t i = 0; i < blockPixels; ++i)
+                    {
+                        const float* const pixel = pixels.data() + i * 4;
+                        const std::array<float, 3> rgb = {pixel[0], pixel[1], pixel[2]};
+                        const float pixelMagnitude = std::max({std::abs(pixel[0]), std::abs(pixel[1]), std::abs(pixel[2])});
+
+                        opaque = opaque && pixel[3] == 1.0f;
+
+                        const std::array<float, 3> e5b9g9r9 = unpackE5B9G9R9(packE5B9G9R9(rgb));
+                        const std::array<float, 3> b10g11r11 = unpackB10G11R11(packB10G11R11(rgb));
+
+                        for(size_t component = 0; component < 3; ++component)
+                        {
+                            errors[kCandidateE5B9G9R9].add(rgb[component], e5b9g9r9[component], pixelMagnitude);
+                            errors[kCandidateB10G11R11].add(rgb[component], b10g11r11[component], pixelMagnitude);
+                        }
+
+                        if(!layout.half)
+                        {
+                            for(size_t component = 0; component < 4; ++component)
+                            {
+                                errors[kCandidateRgba16Float].add(pixel[component], roundTripped[i * 4 + component], pixelMagnitude);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Half sources are already 8 bytes per pixel, for them the packed formats are the only reduction
+    const Candidate fallback = layout.half ? kCandidateE5B9G9R9 : kCandidateRgba16Float;
+
+    HdrReduction reduction;
+    reduction.maxRelativeError = errors[fallback].maxRelativeError;
+    reduction.maxAbsoluteError = errors[fallback].maxAbsoluteError;
+
+    const auto choose = [&](Candidate candidate)
+    {
+        const CandidateError& error = errors[candidate];
+        if(!(error.maxRelativeError <= options.maxRelativeError)) { return; }
+
+        // The packed formats are the same size, the more accurate one wins
+        if(reduction.format == gpufmt::Format::UNDEFINED || error.maxRelativeError < reduction.maxRelativeError)
+        {
+            reduction.format = kCandidateFormats[candidate];
+            reduction.maxRelativeError = error.maxRelativeError;
+            reduction.maxAbsoluteError = error.maxAbsoluteError;
+        }
+    };
+
+    if(opaque)
+    {
+        choose(kCandidateE5B9G9R9);
+        choose(kCandidateB10G11R11);
+    }
+
+    if(reduction.format == gpufmt::Format::UNDEFINED && !layout.half)
+    {
+        choose(kCandidateRgba16Float);
+    }
+
+    return reduction;
+}
+
+bool reduceHdrPixels(std::span<const std::byte> source, gpufmt::Format sourceFormat,
+                     std::span<std::byte> destination, gpufmt::Format destinationFormat)
+{
+    HdrSourceLayout layout;
+    if(!describeHdrSource(sourceFormat, layout)) { return false; }
+
+    const size_t sourcePixelBytes = gpufmt::formatInfo(sourceFormat).blockByteSize;
+    const size_t destinationPixelBytes = gpufmt::formatInfo(destinationFormat).blockByteSize;
+    const size_t pixelCount = source.size() / sourcePixelBytes;
+
+    if(destination.size() != pixelCount * destinationPixelBytes) { return false; }
+
+    std::byte* const destinationPixels = destination.data();
+
+    switch(destinationFormat)
+    {
+    case gpufmt::Format::E5B9G9R9_UFLOAT_PACK32:
+    case gpufmt::Format::B10G11R11_UFLOAT_PACK32:
+    {
+        const bool sharedExponent = (destinationFormat == gpufmt::Format::E5B9G9R9_UFLOAT_PACK32);
+
+        PixelBlock pixels;
+
+        for(size_t firstPixel = 0; firstPixel < pixelCount; firstPixel += kBlockPixels)
+        {
+            const size_t blockPixels = std::min(kBlockPixels, pixelCount - firstPixel);
+            loadPixels(source.data() + firstPixel * sourcePixelBytes, blockPixels, layout, pixels);
+
+            for(size_t i = 0; i < blockPixels; ++i)
+            {
+                const std::array<float, 3> rgb = {pixels[i * 4 + 0], pixels[i * 4 + 1], pixels[i * 4 + 2]};
+                const uint32_t packed = sharedExponent ? packE5B9G9R9(rgb) : packB10G11R11(rgb);
+                std::memcpy(destinationPixels + (firstPixel + i) * 4, &packed, sizeof(packed));
+            }
+        }
+
+        return true;
+    }
+    case gpufmt::Format::R16G16B16A16_SFLOAT:
+        // Missing alpha is filled in as 1
+        return convertPixels(source, sourceFormat, destination, destinationFormat);
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cputex/definitions.h>
+#include <gpufmt/format.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+struct HdrReductionOptions
+{
+    // Largest error a reduced format may introduce in any component, relative to the brightest component of the
+    // pixel it is in
+    float maxRelativeError = 1.0f / 256.0f;
+};
+
+struct HdrReduction
+{
+    // UNDEFINED when no format stays within the error bound and the texture is kept as it is
+    gpufmt::Format format = gpufmt::Format::UNDEFINED;
+    // Worst errors of the chosen format, or of R16G16B16A16_SFLOAT when nothing was chosen. Relative errors are
+    // relative to the pixel's brightest component, pixels darker than 1/1024 count as 1/1024 bright.
+    float maxRelativeError = 0.0f;
+    float maxAbsoluteError = 0.0f;
+};
+
+// Picks the smallest format that holds a floating point texture within the error bound. E5B9G9R9 and B10G11R11
+// (4 bytes per pixel) need opaque, non-negative content, R16G16B16A16_SFLOAT (8 bytes) is the fallback for
+// 32 bit float sources. Every candidate is measured on every pixel. Returns nullopt for formats other than
+// R32G32B32A32_SFLOAT, R32G32B32_SFLOAT and R16G16B16A16_SFLOAT.
+std::optional<HdrReduction> chooseHdrReduction(const cputex::TextureView& texture, const HdrReductionOptions& options);
+
+// Converts tightly packed pixels to a format chooseHdrReduction picks. The destination must be exactly large
+// enough for the same number of pixels in that format.
+bool reduceHdrPixels(std::span<const std::byte> source, gpufmt::Format sourceFormat,
+                     std::span<std::byte> destination, gpufmt::Format destinationFormat);
+
+// B10G11R11_UFLOAT_PACK32 and E5B9G9R9_UFLOAT_PACK32, rounding to nearest. Negative values and NaN become 0.
+uint32_t packB10G11R11(const std::array<float, 3>& rgb);
+std::array<float, 3> unpackB10G11R11(uint32_t packed);
+uint32_t packE5B9G9R9(const std::array<float, 3>& rgb);
+std::array<float, 3> unpackE5B9G9R9(uint32_t packed);
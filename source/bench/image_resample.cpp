@@ -0,0 +1,202 @@
+#include "image_resample.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXIMP_BENCH_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+// One RGBA pixel per vector register. SSE2 is part of every x86-64 CPU, so unlike the F16C and PCLMUL kernels
+// there is nothing to check at run time.
+#ifdef TEXIMP_BENCH_HAS_SSE2
+using Pixel = __m128;
+
+inline Pixel zeroPixel() { return _mm_setzero_ps(); }
+inline Pixel loadPixel(const float* pixel) { return _mm_loadu_ps(pixel); }
+inline void storePixel(float* pixel, Pixel value) { _mm_storeu_ps(pixel, value); }
+
+inline Pixel addWeighted(Pixel sum, Pixel value, float weight)
+{
+    return _mm_add_ps(sum, _mm_mul_ps(value, _mm_set1_ps(weight)));
+}
+#else
+struct Pixel
+{
+    float components[4];
+};
+
+inline Pixel zeroPixel() { return {}; }
+inline Pixel loadPixel(const float* pixel) { return {pixel[0], pixel[1], pixel[2], pixel[3]}; }
+inline void storePixel(float* pixel, Pixel value) { std::copy_n(value.components, 4, pixel); }
+
+inline Pixel addWeighted(Pixel sum, Pixel value, float weight)
+{
+    for(int i = 0; i < 4; ++i)
+    {
+        sum.components[i] += value.components[i] * weight;
+    }
+    return sum;
+}
+#endif
+
+float filterRadius(ResampleFilter filter)
+{
+    return (filter == ResampleFilter::Box) ? 0.5f : 3.0f;
+}
+
+float filterWeight(ResampleFilter filter, float x)
+{
+    if(filter == ResampleFilter::Box)
+    {
+        // Half open, so a source pixel exactly on the edge between two destination pixels is only counted once
+        return (x >= -0.5f && x < 0.5f) ? 1.0f : 0.0f;
+    }
+
+    if(x == 0.0f) { return 1.0f; }
+    if(std::abs(x) >= 3.0f) { return 0.0f; }
+
+    const float piX = std::numbers::pi_v<float> * x;
+    return 3.0f * std::sin(piX) * std::sin(piX / 3.0f) / (piX * piX);
+}
+}
+
+std::string_view toString(ResampleFilter filter)
+{
+    switch(filter)
+    {
+    case ResampleFilter::Box:
+        return "box";
+    case ResampleFilter::Lanczos3:
+        return "lanczos3";
+    default:
+        return "unknown";
+    }
+}
+
+ImageResampler::ImageResampler(int sourceWidth, int sourceHeight, int width, int height, ResampleFilter filter)
+    : mSourceWidth(std::max(sourceWidth, 1))
+    , mWidth(std::max(width, 1))
+    , mHeight(std::max(height, 1))
+    , mColumnWeights(computeWeights(mSourceWidth, mWidth, filter))
+    , mRow((size_t)mWidth * 4)
+    , mPixels((size_t)mWidth * mHeight * 4)
+{
+    sourceHeight = std::max(sourceHeight, 1);
+
+    const Weights rowWeights = computeWeights(sourceHeight, mHeight, filter);
+
+    mRowTargetsBegin.assign((size_t)sourceHeight + 1, 0);
+
+    for(int row = 0; row < mHeight; ++row)
+    {
+        for(int i = 0; i < rowWeights.count[row]; ++i)
+        {
+            ++mRowTargetsBegin[rowWeights.first[row] + i + 1];
+        }
+    }
+
+    for(size_t sourceRow = 0; sourceRow < (size_t)sourceHeight; ++sourceRow)
+    {
+        mRowTargetsBegin[sourceRow + 1] += mRowTargetsBegin[sourceRow];
+    }
+
+    mRowTargets.resize(mRowTargetsBegin.back());
+    std::vector<int> filled(mRowTargetsBegin.begin(), mRowTargetsBegin.end() - 1);
+
+    for(int row = 0; row < mHeight; ++row)
+    {
+        for(int i = 0; i < rowWeights.count[row]; ++i)
+        {
+            const int sourceRow = rowWeights.first[row] + i;
+            mRowTargets[filled[sourceRow]++] = RowTarget{row, rowWeights.weights[(size_t)row * rowWeights.stride + i]};
+        }
+    }
+}
+
+void ImageResampler::addRow(std::span<const float> row)
+{
+    if(mNextRow + 1 >= (int)mRowTargetsBegin.size() || row.size() < (size_t)mSourceWidth * 4) { return; }
+
+    for(int x = 0; x < mWidth; ++x)
+    {
+        const float* const weights = mColumnWeights.weights.data() + (size_t)x * mColumnWeights.stride;
+        const float* const sourcePixels = row.data() + (size_t)mColumnWeights.first[x] * 4;
+
+        Pixel sum = zeroPixel();
+        for(int i = 0; i < mColumnWeights.count[x]; ++i)
+        {
+            sum = addWeighted(sum, loadPixel(sourcePixels + i * 4), weights[i]);
+        }
+
+        storePixel(mRow.data() + (size_t)x * 4, sum);
+    }
+
+    for(int target = mRowTargetsBegin[mNextRow]; target < mRowTargetsBegin[mNextRow + 1]; ++target)
+    {
+        const RowTarget& rowTarget = mRowTargets[target];
+        float* const destination = mPixels.data() + (size_t)rowTarget.row * mWidth * 4;
+
+        for(size_t i = 0; i < (size_t)mWidth * 4; i += 4)
+        {
+            storePixel(destination + i, addWeighted(loadPixel(destination + i), loadPixel(mRow.data() + i), rowTarget.weight));
+        }
+    }
+
+    ++mNextRow;
+}
+
+ImageResampler::Weights ImageResampler::computeWeights(int sourceSize, int size, ResampleFilter filter)
+{
+    const float scale = (float)sourceSize / (float)size;
+    // Scaling down widens the filter to cover every source pixel, scaling up samples it at its own width
+    const float filterScale = std::max(scale, 1.0f);
+    const float radius = filterRadius(filter) * filterScale;
+
+    Weights weights;
+    weights.stride = (int)std::ceil(radius * 2.0f) + 2;
+    weights.first.resize(size);
+    weights.count.resize(size);
+    weights.weights.assign((size_t)size * weights.stride, 0.0f);
+
+    for(int i = 0; i < size; ++i)
+    {
+        // Pixel centers are at half integers in both images
+        const float center = ((float)i + 0.5f) * scale;
+        const int first = std::max((int)std::floor(center - radius), 0);
+        const int last = std::min((int)std::ceil(center + radius), sourceSize);
+
+        float* const pixelWeights = weights.weights.data() + (size_t)i * weights.stride;
+        float sum = 0.0f;
+
+        for(int sourcePixel = first; sourcePixel < last; ++sourcePixel)
+        {
+            const float weight = filterWeight(filter, ((float)sourcePixel + 0.5f - center) / filterScale);
+            pixelWeights[sourcePixel - first] = weight;
+            sum += weight;
+        }
+
+        weights.first[i] = first;
+        weights.count[i] = last - first;
+
+        if(sum == 0.0f)
+        {
+            // Cannot happen with either filter, but a pixel without any weight would come out black
+            weights.first[i] = std::clamp((int)center, 0, sourceSize - 1);
+            weights.count[i] = 1;
+            pixelWeights[0] = 1.0f;
+            continue;
+        }
+
+        for(int sourcePixel = 0; sourcePixel < last - first; ++sourcePixel)
+        {
+            pixelWeights[sourcePixel] /= sum;
+        }
+    }
+
+    return weights;
+}
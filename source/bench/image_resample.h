@@ -0,0 +1,65 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+#include <vector>
+
+enum class ResampleFilter
+{
+    // Average of the source pixels each destination pixel covers
+    Box,
+    // Windowed sinc with 3 lobes, sharper than box when scaling down by fractional factors
+    Lanczos3
+};
+
+std::string_view toString(ResampleFilter filter);
+
+// Separable resampler for linear RGBA float pixels, fed one source row at a time. Every row is resampled
+// horizontally as it arrives and added into the destination rows it contributes to, so memory use is the
+// destination plus one row whatever the size of the source. Weights are computed once per destination column and
+// row. Pixels are filtered as they are given, callers linearize sRGB and premultiply alpha first.
+class ImageResampler
+{
+public:
+    ImageResampler(int sourceWidth, int sourceHeight, int width, int height, ResampleFilter filter);
+
+    // Rows have to be added in order, each sourceWidth pixels
+    void addRow(std::span<const float> row);
+
+    // Complete once every source row was added
+    std::span<const float> pixels() const { return mPixels; }
+
+    int width() const { return mWidth; }
+    int height() const { return mHeight; }
+
+private:
+    // The source pixels destination pixel i is made from are first[i] to first[i] + count[i], with the weights at
+    // weights[i * stride]. Ranges are clipped to the source and the weights renormalized, so edges are not darkened.
+    struct Weights
+    {
+        std::vector<int> first;
+        std::vector<int> count;
+        std::vector<float> weights;
+        int stride = 0;
+    };
+
+    // A destination row a source row contributes to
+    struct RowTarget
+    {
+        int row;
+        float weight;
+    };
+
+    static Weights computeWeights(int sourceSize, int size, ResampleFilter filter);
+
+    int mSourceWidth;
+    int mWidth;
+    int mHeight;
+    int mNextRow = 0;
+    Weights mColumnWeights;
+    // mRowTargets[mRowTargetsBegin[r]] to mRowTargets[mRowTargetsBegin[r + 1]] are the targets of source row r
+    std::vector<int> mRowTargetsBegin;
+    std::vector<RowTarget> mRowTargets;
+    std::vector<float> mRow;
+    std::vector<float> mPixels;
+};
@@ -0,0 +1,35 @@
+#include "import_limits.h"
+
+ImportLimitError checkImportLimits(const TextureProbe& probe, const ImportLimits& limits)
+{
+    if(limits.maxPixels > 0 && probe.pixelCount() > limits.maxPixels)
+    {
+        return ImportLimitError::TooManyPixels;
+    }
+
+    if(limits.maxBytes > 0 && probe.decodedBytes > limits.maxBytes)
+    {
+        return ImportLimitError::TooManyBytes;
+    }
+
+    if(limits.maxDecompressedRatio > 0.0 && probe.fileBytes > 0 &&
+       (double)probe.decodedBytes / (double)probe.fileBytes > limits.maxDecompressedRatio)
+    {
+        return ImportLimitError::DecompressedRatioTooHigh;
+    }
+
+    return ImportLimitError::None;
+}
+
+std::string_view toString(ImportLimitError error)
+{
+    switch(error)
+    {
+    case ImportLimitError::None: return "None";
+    case ImportLimitError::TooManyPixels: return "TooManyPixels";
+    case ImportLimitError::TooManyBytes: return "TooManyBytes";
+    case ImportLimitError::DecompressedRatioTooHigh: return "DecompressedRatioTooHigh";
+    }
+
+    return "Unknown";
+}
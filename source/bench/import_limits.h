@@ -0,0 +1,30 @@
+#pragma once
+
+#include "texture_probe.h"
+
+#include <cstdint>
+#include <string_view>
+
+// Limits checked against the sizes a file declares in its header, before the importer is given a chance to
+// allocate anything. A value of 0 disables that limit.
+struct ImportLimits
+{
+    uint64_t maxPixels = 0;
+    uint64_t maxBytes = 0;
+    // Decoded bytes divided by file bytes
+    double maxDecompressedRatio = 0.0;
+
+    bool enabled() const { return maxPixels > 0 || maxBytes > 0 || maxDecompressedRatio > 0.0; }
+};
+
+enum class ImportLimitError
+{
+    None,
+    TooManyPixels,
+    TooManyBytes,
+    DecompressedRatioTooHigh
+};
+
+ImportLimitError checkImportLimits(const TextureProbe& probe, const ImportLimits& limits);
+
+std::string_view toString(ImportLimitError error);
@@ -0,0 +1,386 @@
+#include "import_pipeline.h"
+
+#include "hdr_reduction.h"
+#include "page_cache.h"
+#include "palette_texture.h"
+
+#include <cputex/definitions.h>
+#include <teximp/teximp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace
+{
+// D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, every surface in an upload buffer starts on this boundary
+constexpr size_t kStagingPlacementAlignment = 512;
+
+template<class T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity)
+        : mCapacity(capacity)
+    {}
+
+    void push(T value)
+    {
+        std::unique_lock lock(mMutex);
+        mNotFull.wait(lock, [this]() { return mItems.size() < mCapacity; });
+        mItems.push_back(std::move(value));
+        lock.unlock();
+
+        mNotEmpty.notify_one();
+    }
+
+    // Returns nullopt once the queue is closed and empty
+    std::optional<T> pop()
+    {
+        std::unique_lock lock(mMutex);
+        mNotEmpty.wait(lock, [this]() { return !mItems.empty() || mClosed; });
+
+        if(mItems.empty()) { return std::nullopt; }
+
+        T value = std::move(mItems.front());
+        mItems.pop_front();
+        lock.unlock();
+
+        mNotFull.notify_one();
+        return value;
+    }
+
+    void close()
+    {
+        {
+            std::scoped_lock lock(mMutex);
+            mClosed = true;
+        }
+
+        mNotEmpty.notify_all();
+    }
+
+private:
+    const size_t mCapacity;
+
+    std::mutex mMutex;
+    std::condition_variable mNotEmpty;
+    std::condition_variable mNotFull;
+    std::deque<T> mItems;
+    bool mClosed = false;
+};
+
+// Per stage counters, updated by every thread of the stage
+struct StageCounters
+{
+    std::atomic<int> itemCount = 0;
+    std::atomic<int64_t> busyNanoseconds = 0;
+    // Threads of the stage still running, the last one out closes the stage's output queue
+    std::atomic<int> runningThreads = 0;
+
+    void addBusyTime(std::chrono::steady_clock::time_point start)
+    {
+        busyNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+// The stage step reports per file results, so the file travels with its import
+struct DecodedFile
+{
+    size_t fileIndex;
+    teximp::TextureImportResult result;
+};
+
+// Packs every surface into the staging buffer with upload heap alignment. copySurface writes one surface in the
+// destination format. Returns the bytes staged.
+template<class CopySurface>
+uint64_t stageSurfaces(const cputex::TextureView& texture, gpufmt::Format destinationFormat, std::vector<std::byte>& stagingBuffer, CopySurface&& copySurface)
+{
+    const size_t sourcePixelBytes = gpufmt::formatInfo(texture.format()).blockByteSize;
+    const size_t destinationPixelBytes = gpufmt::formatInfo(destinationFormat).blockByteSize;
+
+    size_t offset = 0;
+
+    for(cputex::CountType arraySlice = 0; arraySlice < texture.arraySize(); ++arraySlice)
+    {
+        for(cputex::CountType face = 0; face < texture.faces(); ++face)
+        {
+            for(cputex::CountType mip = 0; mip < texture.mips(); ++mip)
+            {
+                const std::span<const std::byte> surface = texture.getMipSurfaceData(arraySlice, face, mip);
+                const size_t stagedSize = (destinationFormat == texture.format()) ? surface.size() : surface.size() / sourcePixelBytes * destinationPixelBytes;
+
+                offset = (offset + kStagingPlacementAlignment - 1) & ~(kStagingPlacementAlignment - 1);
+
+                if(stagingBuffer.size() < offset + stagedSize)
+                {
+                    stagingBuffer.resize(offset + stagedSize);
+                }
+
+                copySurface(surface, std::span(stagingBuffer).subspan(offset, stagedSize));
+                offset += stagedSize;
+            }
+        }
+    }
+
+    return offset;
+}
+
+// Returns the bytes staged. Textures the staging format has no conversion for are staged as imported.
+uint64_t stageTexture(const cputex::TextureView& texture, StagingFormat stagingFormat, std::vector<std::byte>& stagingBuffer, bool& converted)
+{
+    gpufmt::Format destinationFormat = stagedFormat(texture.format(), stagingFormat);
+    converted = destinationFormat != gpufmt::Format::UNDEFINED;
+
+    if(!converted)
+    {
+        destinationFormat = texture.format();
+    }
+
+    return stageSurfaces(texture, destinationFormat, stagingBuffer, [&](std::span<const std::byte> surface, std::span<std::byte> staged)
+        {
+            convertPixels(surface, texture.format(), staged, destinationFormat);
+        });
+}
+
+// Reads every surface once. Stops at the first surface that rules out narrowing.
+std::optional<FormatNarrowing> findNarrowing(const cputex::TextureView& texture)
+{
+    ChannelAnalysis analysis(texture.format());
+    if(!analysis.supported()) { return std::nullopt; }
+
+    for(cputex::CountType arraySlice = 0; arraySlice < texture.arraySize(); ++arraySlice)
+    {
+        for(cputex::CountType face = 0; face < texture.faces(); ++face)
+        {
+            for(cputex::CountType mip = 0; mip < texture.mips(); ++mip)
+            {
+                if(!analysis.add(texture.getMipSurfaceData(arraySlice, face, mip))) { return std::nullopt; }
+            }
+        }
+    }
+
+    return narrowFormat(texture.format(), analysis.content());
+}
+
+// The index texture and the palette go into the staging buffer back to back, as two uploads
+uint64_t stagePalettizedTexture(const PalettizedTexture& texture, std::vector<std::byte>& stagingBuffer)
+{
+    const auto copySurface = [](std::span<const std::byte> surface, std::span<std::byte> staged)
+    {
+        std::memcpy(staged.data(), surface.data(), surface.size());
+    };
+
+    const uint64_t indexBytes = stageSurfaces(texture.indices, gpufmt::Format::R8_UINT, stagingBuffer, copySurface);
+
+    // The palette is tiny, a buffer of its own costs nothing and keeps stageSurfaces simple
+    std::vector<std::byte> paletteStagingBuffer;
+    return indexBytes + stageSurfaces(texture.palette, texture.palette.format(), paletteStagingBuffer, copySurface);
+}
+
+uint64_t stageReducedHdrTexture(const cputex::TextureView& texture, gpufmt::Format reducedFormat, std::vector<std::byte>& stagingBuffer)
+{
+    return stageSurfaces(texture, reducedFormat, stagingBuffer, [&](std::span<const std::byte> surface, std::span<std::byte> staged)
+        {
+            reduceHdrPixels(surface, texture.format(), staged, reducedFormat);
+        });
+}
+
+uint64_t stageNarrowedTexture(const cputex::TextureView& texture, const FormatNarrowing& narrowing, std::vector<std::byte>& stagingBuffer)
+{
+    return stageSurfaces(texture, narrowing.format, stagingBuffer, [&](std::span<const std::byte> surface, std::span<std::byte> staged)
+        {
+            narrowPixels(surface, texture.format(), staged, narrowing);
+        });
+}
+}
+
+std::string_view toString(ImportPipelineStage stage)
+{
+    switch(stage)
+    {
+    case ImportPipelineStage::Read:
+        return "read";
+    case ImportPipelineStage::Decode:
+        return "decode";
+    case ImportPipelineStage::Stage:
+        return "stage";
+    default:
+        return "unknown";
+    }
+}
+
+ImportPipelineResult runImportPipeline(std::span<const std::filesystem::path> filePaths, const ImportPipelineOptions& options)
+{
+    const int readThreadCount = std::max(options.readThreadCount, 1);
+    const int decodeThreadCount = std::max(options.decodeThreadCount, 1);
+    const int stageThreadCount = std::max(options.stageThreadCount, 1);
+    const size_t queueDepth = (size_t)std::max(options.queueDepth, 1);
+
+    BoundedQueue<size_t> readQueue(queueDepth);
+    BoundedQueue<DecodedFile> decodeQueue(queueDepth);
+
+    std::array<StageCounters, (size_t)ImportPipelineStage::Count> counters;
+    counters[(size_t)ImportPipelineStage::Read].runningThreads = readThreadCount;
+    counters[(size_t)ImportPipelineStage::Decode].runningThreads = decodeThreadCount;
+    counters[(size_t)ImportPipelineStage::Stage].runningThreads = stageThreadCount;
+
+    std::atomic<size_t> nextFile = 0;
+    std::atomic<int> errorCount = 0;
+    std::atomic<uint64_t> stagedBytes = 0;
+    std::atomic<int> unconvertedCount = 0;
+    std::atomic<int> narrowedCount = 0;
+    std::atomic<int> palettizedCount = 0;
+    std::mutex hdrReductionsMutex;
+    std::vector<HdrReductionRecord> hdrReductions;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    {
+        std::vector<std::jthread> threads;
+
+        for(int i = 0; i < readThreadCount; ++i)
+        {
+            threads.emplace_back([&]()
+                {
+                    StageCounters& stageCounters = counters[(size_t)ImportPipelineStage::Read];
+
+                    for(size_t fileIndex = nextFile++; fileIndex < filePaths.size(); fileIndex = nextFile++)
+                    {
+                        const auto readStart = std::chrono::steady_clock::now();
+                        loadIntoPageCache(filePaths[fileIndex]);
+                        stageCounters.addBusyTime(readStart);
+                        ++stageCounters.itemCount;
+
+                        readQueue.push(fileIndex);
+                    }
+
+                    if(--stageCounters.runningThreads == 0) { readQueue.close(); }
+                });
+        }
+
+        for(int i = 0; i < decodeThreadCount; ++i)
+        {
+            threads.emplace_back([&]()
+                {
+                    StageCounters& stageCounters = counters[(size_t)ImportPipelineStage::Decode];
+
+                    while(const std::optional<size_t> fileIndex = readQueue.pop())
+                    {
+                        const auto decodeStart = std::chrono::steady_clock::now();
+                        teximp::TextureImportResult result = teximp::importTexture(filePaths[*fileIndex]);
+                        stageCounters.addBusyTime(decodeStart);
+                        ++stageCounters.itemCount;
+
+                        if(result.importer == nullptr || result.importer->error() != teximp::TextureImportError::None)
+                        {
+                            ++errorCount;
+                            continue;
+                        }
+
+                        decodeQueue.push(DecodedFile{*fileIndex, std::move(result)});
+                    }
+
+                    if(--stageCounters.runningThreads == 0) { decodeQueue.close(); }
+                });
+        }
+
+        for(int i = 0; i < stageThreadCount; ++i)
+        {
+            threads.emplace_back([&]()
+                {
+                    StageCounters& stageCounters = counters[(size_t)ImportPipelineStage::Stage];
+
+                    // Reused across files like a ring of upload memory would be
+                    std::vector<std::byte> stagingBuffer;
+
+                    while(std::optional<DecodedFile> decodedFile = decodeQueue.pop())
+                    {
+                        const auto stageStart = std::chrono::steady_clock::now();
+
+                        for(const cputex::UniqueTexture& texture : decodedFile->result.textureAllocator.getTextures())
+                        {
+                            if(options.reduceHdr)
+                            {
+                                if(const std::optional<HdrReduction> reduction = chooseHdrReduction(texture, options.hdrReduction))
+                                {
+                                    {
+                                        std::lock_guard lock(hdrReductionsMutex);
+                                        hdrReductions.push_back(HdrReductionRecord{decodedFile->fileIndex, texture.format(), *reduction});
+                                    }
+
+                                    if(reduction->format != gpufmt::Format::UNDEFINED)
+                                    {
+                                        stagedBytes += stageReducedHdrTexture(texture, reduction->format, stagingBuffer);
+                                        continue;
+                                    }
+                                }
+                            }
+
+                            if(options.narrowFormats)
+                            {
+                                if(const std::optional<FormatNarrowing> narrowing = findNarrowing(texture))
+                                {
+                                    stagedBytes += stageNarrowedTexture(texture, *narrowing, stagingBuffer);
+                                    ++narrowedCount;
+                                    continue;
+                                }
+                            }
+
+                            if(options.palettize)
+                            {
+                                if(const std::optional<PalettizedTexture> palettized = palettize(texture))
+                                {
+                                    stagedBytes += stagePalettizedTexture(*palettized, stagingBuffer);
+                                    ++palettizedCount;
+                                    continue;
+                                }
+                            }
+
+                            bool converted = false;
+                            stagedBytes += stageTexture(texture, options.stagingFormat, stagingBuffer, converted);
+
+                            if(!converted)
+                            {
+                                ++unconvertedCount;
+                            }
+                        }
+
+                        // Freeing the texture is part of the stage's work
+                        decodedFile.reset();
+
+                        stageCounters.addBusyTime(stageStart);
+                        ++stageCounters.itemCount;
+                    }
+                });
+        }
+    }
+
+    ImportPipelineResult pipelineResult;
+    pipelineResult.wallTime = std::chrono::steady_clock::now() - start;
+    pipelineResult.importCount = counters[(size_t)ImportPipelineStage::Decode].itemCount;
+    pipelineResult.errorCount = errorCount;
+    pipelineResult.stagedBytes = stagedBytes;
+    pipelineResult.unconvertedCount = unconvertedCount;
+    pipelineResult.narrowedCount = narrowedCount;
+    pipelineResult.palettizedCount = palettizedCount;
+    pipelineResult.hdrReductions = std::move(hdrReductions);
+
+    const std::array threadCounts = {readThreadCount, decodeThreadCount, stageThreadCount};
+
+    for(size_t stageIndex = 0; stageIndex < counters.size(); ++stageIndex)
+    {
+        ImportPipelineStageStats& stats = pipelineResult.stages[stageIndex];
+        stats.threadCount = threadCounts[stageIndex];
+        stats.itemCount = counters[stageIndex].itemCount;
+        stats.busyTime = std::chrono::nanoseconds(counters[stageIndex].busyNanoseconds.load());
+    }
+
+    return pipelineResult;
+}
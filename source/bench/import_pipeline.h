@@ -0,0 +1,83 @@
+#pragma once
+
+#include "hdr_reduction.h"
+#include "staging_format.h"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+struct ImportPipelineOptions
+{
+    int readThreadCount = 2;
+    int decodeThreadCount = 4;
+    int stageThreadCount = 1;
+    // Files waiting between two stages. A full queue blocks the stage feeding it.
+    int queueDepth = 8;
+    StagingFormat stagingFormat = StagingFormat::Native;
+    // Stage textures whose content fits a narrower format (opaque alpha, gray, unused components) in that format,
+    // ahead of the staging format
+    bool narrowFormats = false;
+    // Stage textures with at most 256 colors as R8_UINT indices plus a 256x1 palette, after narrowing and ahead
+    // of the staging format
+    bool palettize = false;
+    // Stage floating point textures in the smallest format within the error bound, ahead of everything else
+    bool reduceHdr = false;
+    HdrReductionOptions hdrReduction;
+};
+
+enum class ImportPipelineStage
+{
+    Read,
+    Decode,
+    Stage,
+    Count
+};
+
+struct ImportPipelineStageStats
+{
+    int threadCount = 0;
+    int itemCount = 0;
+    // Time the stage's threads spent working, not waiting on their input or output queue
+    std::chrono::nanoseconds busyTime{0};
+};
+
+struct HdrReductionRecord
+{
+    size_t fileIndex = 0;
+    gpufmt::Format sourceFormat = gpufmt::Format::UNDEFINED;
+    HdrReduction reduction;
+};
+
+struct ImportPipelineResult
+{
+    int importCount = 0;
+    int errorCount = 0;
+    uint64_t stagedBytes = 0;
+    // Textures staged in their imported format because the staging format has no conversion for it
+    int unconvertedCount = 0;
+    // Textures staged in a narrower format
+    int narrowedCount = 0;
+    // Textures staged as palette indices plus a palette
+    int palettizedCount = 0;
+    // One per floating point texture, in the order they were staged
+    std::vector<HdrReductionRecord> hdrReductions;
+    std::chrono::nanoseconds wallTime{0};
+    std::array<ImportPipelineStageStats, (size_t)ImportPipelineStage::Count> stages;
+};
+
+std::string_view toString(ImportPipelineStage stage);
+
+// Imports the files as a pipeline of stages connected by bounded queues, so that different files are read,
+// decoded and staged at the same time and neither the disk nor the cores sit idle while the other is busy.
+//
+// Read:   reads the file into the page cache
+// Decode: importTexture, which decodes and converts to the output format in one call
+// Stage:  packs every surface into a staging buffer with upload heap alignment, the copy an upload would make,
+//         converting to the staging format, reducing HDR precision, narrowing the format or
+//         palettizing as part of that copy
+ImportPipelineResult runImportPipeline(std::span<const std::filesystem::path> filePaths, const ImportPipelineOptions& options);
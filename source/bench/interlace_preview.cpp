@@ -0,0 +1,115 @@
+#include "interlace_preview.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+// Once passes 1 to n are in, the decoded pixels are exactly those on a grid of these blocks
+constexpr std::array<int, 7> kPreviewBlockWidths = {8, 4, 4, 2, 2, 1, 1};
+constexpr std::array<int, 7> kPreviewBlockHeights = {8, 8, 4, 4, 2, 2, 1};
+
+int passExtent(int extent, int start, int step)
+{
+    return extent > start ? (extent - start + step - 1) / step : 0;
+}
+}
+
+int adam7PassWidth(int width, int pass)
+{
+    return passExtent(width, kAdam7Passes[pass].xStart, kAdam7Passes[pass].xStep);
+}
+
+int adam7PassHeight(int height, int pass)
+{
+    return passExtent(height, kAdam7Passes[pass].yStart, kAdam7Passes[pass].yStep);
+}
+
+void scatterAdam7Pass(std::span<const std::byte> passPixels, int pass, std::span<std::byte> image, int width, int height,
+                      size_t pixelBytes)
+{
+    const Adam7Pass& geometry = kAdam7Passes[pass];
+    const int passWidth = adam7PassWidth(width, pass);
+    const int passHeight = adam7PassHeight(height, pass);
+
+    assert(passPixels.size() >= (size_t)passWidth * passHeight * pixelBytes);
+    assert(image.size() >= (size_t)width * height * pixelBytes);
+
+    const size_t rowPitch = (size_t)width * pixelBytes;
+    const size_t columnStep = (size_t)geometry.xStep * pixelBytes;
+
+    for(int passY = 0; passY < passHeight; ++passY)
+    {
+        const std::byte* source = passPixels.data() + (size_t)passY * passWidth * pixelBytes;
+        std::byte* destination = image.data() + (size_t)(geometry.yStart + passY * geometry.yStep) * rowPitch +
+                                 (size_t)geometry.xStart * pixelBytes;
+
+        for(int passX = 0; passX < passWidth; ++passX, source += pixelBytes, destination += columnStep)
+        {
+            std::memcpy(destination, source, pixelBytes);
+        }
+    }
+}
+
+void fillAdam7Preview(std::span<std::byte> image, int width, int height, size_t pixelBytes, int completedPasses)
+{
+    if(completedPasses <= 0 || completedPasses >= (int)kAdam7Passes.size()) { return; }
+
+    assert(image.size() >= (size_t)width * height * pixelBytes);
+
+    const int blockWidth = kPreviewBlockWidths[completedPasses - 1];
+    const int blockHeight = kPreviewBlockHeights[completedPasses - 1];
+    const size_t rowPitch = (size_t)width * pixelBytes;
+
+    for(int y = 0; y < height; ++y)
+    {
+        std::byte* row = image.data() + (size_t)y * rowPitch;
+
+        // Rows off the grid are copies of the grid row above, which is already filled
+        if(y % blockHeight != 0)
+        {
+            std::memcpy(row, row - (size_t)(y % blockHeight) * rowPitch, rowPitch);
+            continue;
+        }
+
+        if(blockWidth == 1) { continue; }
+
+        for(int x = 0; x < width; x += blockWidth)
+        {
+            const std::byte* decoded = row + (size_t)x * pixelBytes;
+            const int end = std::min(x + blockWidth, width);
+
+            for(int fillX = x + 1; fillX < end; ++fillX)
+            {
+                std::memcpy(row + (size_t)fillX * pixelBytes, decoded, pixelBytes);
+            }
+        }
+    }
+}
+
+void replayAdam7Passes(std::span<const std::byte> image, int width, int height, size_t pixelBytes, const Adam7PreviewCallback& callback)
+{
+    std::vector<std::byte> preview(image.size());
+    std::vector<std::byte> passPixels;
+
+    for(int pass = 0; pass < (int)kAdam7Passes.size(); ++pass)
+    {
+        const Adam7Pass& geometry = kAdam7Passes[pass];
+        passPixels.clear();
+
+        for(int y = geometry.yStart; y < height; y += geometry.yStep)
+        {
+            for(int x = geometry.xStart; x < width; x += geometry.xStep)
+            {
+                const std::byte* pixel = image.data() + ((size_t)y * width + x) * pixelBytes;
+                passPixels.insert(passPixels.end(), pixel, pixel + pixelBytes);
+            }
+        }
+
+        scatterAdam7Pass(passPixels, pass, preview, width, height, pixelBytes);
+        fillAdam7Preview(preview, width, height, pixelBytes, pass + 1);
+        callback(preview, pass + 1);
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <span>
+
+// Pixels of the full image an Adam7 pass decodes: xStart + i * xStep, yStart + j * yStep
+struct Adam7Pass
+{
+    int xStart;
+    int yStart;
+    int xStep;
+    int yStep;
+};
+
+inline constexpr std::array<Adam7Pass, 7> kAdam7Passes = {
+    {{0, 0, 8, 8}, {4, 0, 8, 8}, {0, 4, 4, 8}, {2, 0, 4, 4}, {0, 2, 2, 4}, {1, 0, 2, 2}, {0, 1, 1, 2}}};
+
+// Width and height of the reduced image a pass decodes, 0 for passes an image too small has no pixels in
+int adam7PassWidth(int width, int pass);
+int adam7PassHeight(int height, int pass);
+
+// Writes the pixels of one decoded pass, rows of adam7PassWidth pixels packed back to back, to their places in the
+// full image. Pixels are whole bytes, a decoder expands sub byte gray depths before it scatters a pass.
+void scatterAdam7Pass(std::span<const std::byte> passPixels, int pass, std::span<std::byte> image, int width, int height,
+                      size_t pixelBytes);
+
+// Turns an image the first completedPasses passes have been scattered into into a low resolution preview, by
+// filling every pixel a later pass would write with the decoded pixel up and to the left of it. After the first pass
+// the image is 8x8 blocks, after the sixth 1x2. Only pixels later passes overwrite are touched, so the decode can
+// scatter the next pass into the same image and preview again.
+//
+// The first pass is 1/64 of the pixels, which is what lets a viewer show an interlaced image after a few percent of
+// its data has arrived.
+void fillAdam7Preview(std::span<std::byte> image, int width, int height, size_t pixelBytes, int completedPasses);
+
+// Called after each of the seven passes with the full size preview, which is only valid during the call
+using Adam7PreviewCallback = std::function<void(std::span<const std::byte> preview, int completedPasses)>;
+
+// Replays a decoded image in the order an interlaced decode produces it: takes each pass's pixels out of the image,
+// scatters them into a preview and fills it, then calls back. This is what a viewer would see from an importer
+// that reported passes, which teximp does not do yet.
+void replayAdam7Passes(std::span<const std::byte> image, int width, int height, size_t pixelBytes, const Adam7PreviewCallback& callback);
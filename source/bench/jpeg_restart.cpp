@@ -0,0 +1,231 @@
+#include "jpeg_restart.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace
+{
+constexpr uint8_t kMarkerPrefix = 0xff;
+constexpr uint8_t kSof0 = 0xc0;
+constexpr uint8_t kSof1 = 0xc1;
+constexpr uint8_t kRst0 = 0xd0;
+constexpr uint8_t kRst7 = 0xd7;
+constexpr uint8_t kSoi = 0xd8;
+constexpr uint8_t kEoi = 0xd9;
+constexpr uint8_t kSos = 0xda;
+constexpr uint8_t kDri = 0xdd;
+constexpr uint8_t kTem = 0x01;
+
+struct FrameComponent
+{
+    uint8_t id;
+    uint8_t horizontalSampling;
+    uint8_t verticalSampling;
+};
+
+struct Frame
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<FrameComponent> components;
+};
+
+uint8_t byteAt(std::span<const std::byte> file, size_t offset)
+{
+    return (uint8_t)file[offset];
+}
+
+uint16_t bigEndian16(std::span<const std::byte> file, size_t offset)
+{
+    return (uint16_t)((byteAt(file, offset) << 8) | byteAt(file, offset + 1));
+}
+
+uint32_t divideRoundingUp(uint32_t value, uint32_t divisor)
+{
+    return (value + divisor - 1) / divisor;
+}
+
+bool isStartOfFrame(uint8_t marker)
+{
+    // C4, C8 and CC are DHT, JPG and DAC
+    return marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc;
+}
+
+bool parseFrame(std::span<const std::byte> segment, Frame& frame)
+{
+    if(segment.size() < 6) { return false; }
+
+    frame.height = bigEndian16(segment, 1);
+    frame.width = bigEndian16(segment, 3);
+    const size_t componentCount = byteAt(segment, 5);
+
+    // A height of 0 is defined later by a DNL marker, after the scan
+    if(frame.width == 0 || frame.height == 0 || componentCount == 0 || segment.size() < 6 + componentCount * 3) { return false; }
+
+    for(size_t i = 0; i < componentCount; ++i)
+    {
+        const uint8_t sampling = byteAt(segment, 6 + i * 3 + 1);
+        const FrameComponent component = {byteAt(segment, 6 + i * 3), (uint8_t)(sampling >> 4), (uint8_t)(sampling & 0xf)};
+
+        if(component.horizontalSampling < 1 || component.horizontalSampling > 4 || component.verticalSampling < 1 || component.verticalSampling > 4)
+        {
+            return false;
+        }
+
+        frame.components.push_back(component);
+    }
+
+    return true;
+}
+
+// MCUs of a scan: one block of the component in a single component scan, one of every component's sampling
+// rectangles in an interleaved one
+bool scanMcus(std::span<const std::byte> segment, const Frame& frame, JpegRestartLayout& layout)
+{
+    if(segment.empty()) { return false; }
+
+    const size_t scanComponentCount = byteAt(segment, 0);
+    if(scanComponentCount == 0 || segment.size() < 1 + scanComponentCount * 2) { return false; }
+
+    uint32_t maxHorizontalSampling = 1;
+    uint32_t maxVerticalSampling = 1;
+    for(const FrameComponent& component : frame.components)
+    {
+        maxHorizontalSampling = std::max<uint32_t>(maxHorizontalSampling, component.horizontalSampling);
+        maxVerticalSampling = std::max<uint32_t>(maxVerticalSampling, component.verticalSampling);
+    }
+
+    if(scanComponentCount > 1)
+    {
+        layout.mcusPerRow = divideRoundingUp(frame.width, 8 * maxHorizontalSampling);
+        layout.mcuRows = divideRoundingUp(frame.height, 8 * maxVerticalSampling);
+        return true;
+    }
+
+    const uint8_t componentId = byteAt(segment, 1);
+    const auto component = std::ranges::find(frame.components, componentId, &FrameComponent::id);
+    if(component == frame.components.end()) { return false; }
+
+    const uint32_t componentWidth = divideRoundingUp(frame.width * component->horizontalSampling, maxHorizontalSampling);
+    const uint32_t componentHeight = divideRoundingUp(frame.height * component->verticalSampling, maxVerticalSampling);
+    layout.mcusPerRow = divideRoundingUp(componentWidth, 8);
+    layout.mcuRows = divideRoundingUp(componentHeight, 8);
+    return true;
+}
+
+// Splits the entropy coded data at its restart markers, which have to count RST0 to RST7 and around again. Ends
+// at the first other marker, which has to be EOI for the file to have a single scan.
+bool splitEntropyCodedData(std::span<const std::byte> file, size_t offset, JpegRestartLayout& layout)
+{
+    size_t segmentStart = offset;
+    uint32_t restartCount = 0;
+
+    while(offset < file.size())
+    {
+        const void* const prefix = std::memchr(file.data() + offset, kMarkerPrefix, file.size() - offset);
+        if(prefix == nullptr) { return false; }
+
+        const size_t prefixOffset = (size_t)((const std::byte*)prefix - file.data());
+        if(prefixOffset + 1 >= file.size()) { return false; }
+
+        const uint8_t marker = byteAt(file, prefixOffset + 1);
+
+        // A stuffed 0xFF data byte, or fill in front of a marker
+        if(marker == 0x00 || marker == kMarkerPrefix)
+        {
+            offset = prefixOffset + ((marker == 0x00) ? 2 : 1);
+            continue;
+        }
+
+        layout.segments.push_back(JpegRestartSegment{segmentStart, prefixOffset - segmentStart});
+
+        if(marker >= kRst0 && marker <= kRst7)
+        {
+            if(marker != kRst0 + restartCount % 8) { return false; }
+
+            ++restartCount;
+            offset = segmentStart = prefixOffset + 2;
+            continue;
+        }
+
+        return marker == kEoi;
+    }
+
+    return false;
+}
+}
+
+std::optional<JpegRestartLayout> findJpegRestartSegments(std::span<const std::byte> file)
+{
+    if(file.size() < 4 || byteAt(file, 0) != kMarkerPrefix || byteAt(file, 1) != kSoi) { return std::nullopt; }
+
+    JpegRestartLayout layout;
+    Frame frame;
+    bool foundFrame = false;
+    size_t offset = 2;
+
+    while(true)
+    {
+        if(offset + 2 > file.size() || byteAt(file, offset) != kMarkerPrefix) { return std::nullopt; }
+
+        const uint8_t marker = byteAt(file, offset + 1);
+
+        if(marker == kMarkerPrefix)
+        {
+            ++offset;
+            continue;
+        }
+
+        // Markers without a length. Restart markers and EOI before the scan mean the file is broken.
+        if(marker == kTem)
+        {
+            offset += 2;
+            continue;
+        }
+
+        if(marker == kSoi || marker == kEoi || (marker >= kRst0 && marker <= kRst7)) { return std::nullopt; }
+
+        if(offset + 4 > file.size()) { return std::nullopt; }
+
+        const uint16_t length = bigEndian16(file, offset + 2);
+        if(length < 2 || offset + 2 + length > file.size()) { return std::nullopt; }
+
+        const std::span<const std::byte> segment = file.subspan(offset + 4, length - 2);
+
+        if(isStartOfFrame(marker))
+        {
+            if(marker != kSof0 && marker != kSof1) { return std::nullopt; }
+            if(foundFrame || !parseFrame(segment, frame)) { return std::nullopt; }
+
+            foundFrame = true;
+        }
+        else if(marker == kDri)
+        {
+            if(segment.size() < 2) { return std::nullopt; }
+
+            layout.restartInterval = bigEndian16(segment, 0);
+        }
+        else if(marker == kSos)
+        {
+            if(!foundFrame || layout.restartInterval == 0 || !scanMcus(segment, frame, layout)) { return std::nullopt; }
+            if(!splitEntropyCodedData(file, offset + 2 + length, layout)) { return std::nullopt; }
+
+            break;
+        }
+
+        offset += 2 + length;
+    }
+
+    // Every segment but the last has exactly restartInterval MCUs, a missing marker would shift all rows after it
+    const uint64_t mcuCount = (uint64_t)layout.mcusPerRow * layout.mcuRows;
+    if(layout.segments.size() != (mcuCount + layout.restartInterval - 1) / layout.restartInterval) { return std::nullopt; }
+
+    for(size_t i = 0; i < layout.segments.size(); ++i)
+    {
+        layout.segments[i].firstMcu = (uint32_t)(i * layout.restartInterval);
+        layout.segments[i].mcuCount = (uint32_t)std::min<uint64_t>(layout.restartInterval, mcuCount - layout.segments[i].firstMcu);
+    }
+
+    return layout;
+}
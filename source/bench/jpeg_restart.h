@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+// An entropy coded segment of a scan, between two restart markers. The Huffman decoder's bit buffer and the DC
+// predictions start over in every segment, so segments can be decoded independently and in any order.
+struct JpegRestartSegment
+{
+    // Byte range in the file, the markers excluded. Stuffed bytes are left in place.
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    uint32_t firstMcu = 0;
+    uint32_t mcuCount = 0;
+};
+
+struct JpegRestartLayout
+{
+    // MCUs per segment, the last segment may have fewer
+    uint32_t restartInterval = 0;
+    uint32_t mcusPerRow = 0;
+    uint32_t mcuRows = 0;
+    // In MCU order
+    std::vector<JpegRestartSegment> segments;
+};
+
+// Finds the restart segments of a JPEG whose entropy coded data can be decoded in parallel: a Huffman coded
+// sequential frame (SOF0 or SOF1) with a single scan and a restart interval. A decoder hands each thread a run
+// of segments and writes the MCU rows they cover.
+//
+// Returns nullopt for everything else, which has to be decoded serially: progressive, lossless and arithmetic
+// coded frames, files without a restart interval, with more than one scan, and files whose restart markers are
+// missing or out of sequence, which a serial decoder resynchronizes on.
+std::optional<JpegRestartLayout> findJpegRestartSegments(std::span<const std::byte> file);
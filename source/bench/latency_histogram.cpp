@@ -0,0 +1,65 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+
+void LatencyHistogram::add(std::chrono::nanoseconds latency)
+{
+    const uint64_t microseconds = (uint64_t)std::max<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(latency).count(), 0);
+    const int bucket = std::min((int)std::bit_width(microseconds) - 1, kBucketCount - 1);
+
+    ++mBuckets[std::max(bucket, 0)];
+    ++mCount;
+    mMax = std::max(mMax, latency);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for(int i = 0; i < kBucketCount; ++i)
+    {
+        mBuckets[i] += other.mBuckets[i];
+    }
+
+    mCount += other.mCount;
+    mMax = std::max(mMax, other.mMax);
+}
+
+std::chrono::microseconds LatencyHistogram::percentile(double percent) const
+{
+    if(mCount == 0) { return {}; }
+
+    const uint64_t target = std::max<uint64_t>((uint64_t)(mCount * (percent / 100.0) + 0.5), 1);
+    uint64_t accumulated = 0;
+
+    for(int i = 0; i < kBucketCount; ++i)
+    {
+        accumulated += mBuckets[i];
+        if(accumulated >= target)
+        {
+            return std::chrono::microseconds(uint64_t(1) << (i + 1));
+        }
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(mMax);
+}
+
+void LatencyHistogram::print() const
+{
+    const uint64_t largestBucket = *std::max_element(mBuckets.begin(), mBuckets.end());
+    if(largestBucket == 0) { return; }
+
+    constexpr int kBarWidth = 50;
+
+    for(int i = 0; i < kBucketCount; ++i)
+    {
+        if(mBuckets[i] == 0) { continue; }
+
+        const int barLength = std::max((int)((mBuckets[i] * kBarWidth) / largestBucket), 1);
+        std::printf("  < %10llu us %10llu %.*s\n",
+                    (unsigned long long)(uint64_t(1) << (i + 1)),
+                    (unsigned long long)mBuckets[i],
+                    barLength,
+                    "##################################################");
+    }
+}
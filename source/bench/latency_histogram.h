@@ -0,0 +1,29 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+// Histogram with power of two microsecond buckets. Bucket i counts samples in [2^i, 2^(i+1)) microseconds,
+// bucket 0 also counts everything under a microsecond.
+class LatencyHistogram
+{
+public:
+    static constexpr int kBucketCount = 32;
+
+    void add(std::chrono::nanoseconds latency);
+    void merge(const LatencyHistogram& other);
+
+    uint64_t count() const { return mCount; }
+    std::chrono::nanoseconds max() const { return mMax; }
+
+    // Upper bound of the bucket containing the given percentile, in the range [0, 100].
+    std::chrono::microseconds percentile(double percent) const;
+
+    void print() const;
+
+private:
+    std::array<uint64_t, kBucketCount> mBuckets{};
+    uint64_t mCount = 0;
+    std::chrono::nanoseconds mMax{0};
+};
@@ -0,0 +1,1217 @@
+#include "import_limits.h"
+#include "import_pipeline.h"
+#include "interlace_preview.h"
+#include "jpeg_restart.h"
+#include "latency_histogram.h"
+#include "mapped_file.h"
+#include "mapped_texture.h"
+#include "memory_budget.h"
+#include "page_cache.h"
+#include "process_stats.h"
+#include "read_ahead.h"
+#include "texture_cache.h"
+#include "texture_probe.h"
+#include "thread_pool.h"
+#include "thumbnail_pack.h"
+
+#include "test_files.h"
+
+#include <gpufmt/format.h>
+#include <gpufmt/string.h>
+#include <teximp/string.h>
+#include <teximp/teximp.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifndef TEXIMP_BENCH_IMPORTER_VERSION
+#define TEXIMP_BENCH_IMPORTER_VERSION "unknown"
+#endif
+
+namespace
+{
+enum class CacheMode
+{
+    Warm,
+    Cold,
+    Both
+};
+
+struct BenchOptions
+{
+    std::filesystem::path baseDirectory = "../";
+    CacheMode cacheMode = CacheMode::Warm;
+    int iterations = 1;
+    int soakCycles = 0;
+    int threadCount = 0;
+    int readAheadFiles = 0;
+    uint64_t readAheadMiB = 64;
+    uint64_t memoryBudgetMiB = 0;
+    int pipelineReadThreads = 0;
+    StagingFormat stagingFormat = StagingFormat::Native;
+    bool narrowFormats = false;
+    bool palettize = false;
+    float hdrMaxRelativeError = -1.0f;
+    std::filesystem::path textureCacheDirectory;
+    bool textureCacheCompress = false;
+    CacheVerification textureCacheVerification = CacheVerification::Metadata;
+    bool mapTextures = false;
+    int previewExtent = 0;
+    int textureCacheColdHours = -1;
+    std::filesystem::path thumbnailPackPath;
+    int thumbnailSize = 128;
+    ResampleFilter thumbnailFilter = ResampleFilter::Lanczos3;
+    bool jpegRestarts = false;
+    bool interlacePreview = false;
+    ImportLimits limits;
+};
+
+struct FormatTimings
+{
+    int importCount = 0;
+    int errorCount = 0;
+    int rejectedCount = 0;
+    // Imports served from the texture cache instead of the importer
+    int cachedCount = 0;
+    // Imports whose data was used in place from the mapped file
+    int mappedCount = 0;
+    uintmax_t fileBytes = 0;
+    std::chrono::nanoseconds wallTime{0};
+    std::chrono::nanoseconds cpuTime{0};
+    // Wall time that was not spent on the cpu. With a cold page cache this is dominated by waiting on I/O.
+    std::chrono::nanoseconds waitTime{0};
+};
+
+using PassTimings = std::array<FormatTimings, (size_t)teximp::FileFormat::Count>;
+
+void printUsage()
+{
+    std::puts("usage: teximp_bench [--base <directory>] [--cache warm|cold|both] [--iterations <count>] [--map]\n"
+              "                    [--max-extent <pixels>] [texture cache] [limits]\n"
+              "       teximp_bench [--base <directory>] --soak <cycles> [limits]\n"
+              "       teximp_bench [--base <directory>] --threads <count> [--iterations <count>] [--memory-budget-mib <MiB>]\n"
+              "                    [read ahead] [limits]\n"
+              "       teximp_bench [--base <directory>] [--cache warm|cold|both] --pipeline <read threads>\n"
+              "                    [--threads <count>] [--staging-format native|rgba8|rgba16f] [--narrow] [--palettize]\n"
+              "                    [--hdr-reduce <max relative error>] [--iterations <count>] [limits]\n"
+              "       teximp_bench [--base <directory>] --thumbnails <pack> [--thumbnail-size <pixels>]\n"
+              "                    [--thumbnail-filter box|lanczos3] [--threads <count>] [limits]\n"
+              "       teximp_bench [--base <directory>] --jpeg-restarts\n"
+              "       teximp_bench [--base <directory>] --interlace-preview\n"
+              "\n"
+              "  --base        directory the test image paths are relative to (default: ../)\n"
+              "  --cache       warm: every file is resident in the page cache before it is imported\n"
+              "                cold: every file is evicted from the page cache before it is imported\n"
+              "                both: run a warm pass followed by a cold pass\n"
+              "  --iterations  number of times each pass imports the whole corpus (default: 1)\n"
+              "  --map         use DDS and KTX payloads in place from a memory mapping when their layout allows it\n"
+              "  --max-extent  with --map, only use the mips a preview of at most the given size along its longest\n"
+              "                side is made from, as a browser would\n"
+              "  --texture-cache  directory of a persistent cache of decoded textures, checked before importing\n"
+              "  --texture-cache-lz4  store new texture cache entries LZ4 compressed\n"
+              "  --texture-cache-compress-cold  LZ4 compress texture cache entries not hit in the given number of hours\n"
+              "  --texture-cache-verify  all|metadata|none, how much of an entry a hit checks against its CRC-32s\n"
+              "                (default: metadata). none is for caches only ever filled from trusted inputs.\n"
+              "  --soak        import the whole corpus in viewer auto mode order the given number of times, tracking\n"
+              "                latency, resident memory and open handles after every cycle\n"
+              "  --threads     import the whole corpus concurrently on the given number of threads\n"
+              "  --memory-budget-mib  only start an import while the estimated decoded size of the imports in flight\n"
+              "                fits in the given MiB. Estimates come from the file headers.\n"
+              "  --read-ahead  evict the corpus from the page cache and read up to the given number of files ahead of\n"
+              "                the importers instead of preloading it\n"
+              "  --read-ahead-mib  maximum MiB read ahead and not yet imported (default: 64)\n"
+              "  --pipeline    import through separate read, decode and stage thread pools connected by bounded\n"
+              "                queues, with the given number of read threads and --threads decode threads\n"
+              "  --staging-format  format family the pipeline converts to while staging (default: native)\n"
+              "  --narrow      stage 8 bit textures with opaque alpha, gray color or unused components as R8, RG8 or\n"
+              "                B8G8R8X8, and textures widened from 16 bit formats packed again, ahead of the staging\n"
+              "                format\n"
+              "  --palettize   stage 8 bit color textures with at most 256 colors as R8_UINT indices plus a 256x1\n"
+              "                palette, after --narrow and ahead of the staging format\n"
+              "  --hdr-reduce  stage floating point textures as E5B9G9R9, B10G11R11 or R16G16B16A16_SFLOAT when the\n"
+              "                error relative to each pixel's brightest component stays within the given bound, e.g.\n"
+              "                0.004, and list the error of every file\n"
+              "  --thumbnails  update the thumbnail pack at the given path for the whole corpus on --threads threads,\n"
+              "                only importing files that are new or changed, then time finding every thumbnail\n"
+              "  --thumbnail-size  thumbnails fit in a square of this many pixels (default: 128)\n"
+              "  --thumbnail-filter  resampling filter, in linear space (default: lanczos3)\n"
+              "  --jpeg-restarts  list the restart segments of every JPEG, the units a parallel entropy decoder splits\n"
+              "                the scan into, or why it would fall back to a serial decode\n"
+              "  --interlace-preview  import every Adam7 interlaced PNG, then replay it pass by pass through the preview\n"
+              "                a progressive viewer would show, timing the import and each preview");
+}
+
+template<class T>
+bool parseValue(std::string_view value, T& result)
+{
+    const auto parseResult = std::from_chars(value.data(), value.data() + value.size(), result);
+    return parseResult.ec == std::errc() && parseResult.ptr == value.data() + value.size();
+}
+
+bool parseArguments(int argc, char** argv, BenchOptions& options)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+
+        if(arg == "--base" && hasValue)
+        {
+            options.baseDirectory = argv[++i];
+        }
+        else if(arg == "--cache" && hasValue)
+        {
+            const std::string_view value = argv[++i];
+
+            if(value == "warm") { options.cacheMode = CacheMode::Warm; }
+            else if(value == "cold") { options.cacheMode = CacheMode::Cold; }
+            else if(value == "both") { options.cacheMode = CacheMode::Both; }
+            else { return false; }
+        }
+        else if(arg == "--iterations" && hasValue)
+        {
+            if(!parseValue(argv[++i], options.iterations) || options.iterations < 1) { return false; }
+        }
+        else if(arg == "--soak" && hasValue)
+        {
+            if(!parseValue(argv[++i], options.soakCycles) || options.soakCycles < 1) { return false; }
+        }
+        else if(arg == "--threads" && hasValue)
+        {
+            if(!parseValue(argv[++i], options.threadCount) || options.threadCount < 1) { return false; }
+        }
+        else if(arg == "--map")
+        {
+            options.mapTextures = true;
+        }
+        else if(arg == "--max-extent" && hasValue)
+        {
+            if(!parseValue(argv[++i], options.previewExtent) || options.previewExtent < 1) { return false; }
+        }
+        else if(arg == "--texture-cache" && hasValue)
+        {
+            options.textureCacheDirectory = argv[++i];
+        }
+        else if(arg == "--texture-cache-lz4")
+        {
+            options.textureCacheCompress = true;
+        }
+        else if(arg == "--texture-cache-compress-cold" && hasValue)
+        {
+            if(!parseValue(argv[++i], options.textureCacheColdHours) || options.textureCacheColdHours < 0) { return false; }
+        }
+        else if(arg == "--texture-cache-verify" && hasValue)
+        {
+            const std::string_view value = argv[++i];
+
+            if(value == "all") { options.textureCacheVerification = CacheVerification::All; }
+            else if(value == "metadata") { options.textureCacheVerification = CacheVerification::Metadata; }
+            else if(value == "none") { options.textureCacheVerification = CacheVerification::None; }
+            else { return false; }
+        }
+        else if(arg == "--pipeline" && hasValue)
+        {
+            if(!parseValue(argv[++i], options.pipelineReadThreads) || options.pipelineReadThreads < 1) { return false; }
+        }
+        else if(arg == "--staging-format" && hasValue)
+        {
+            const std::string_view value = argv[++i];
+
+            if(value == "native") { options.stagingFormat = StagingFormat::Native; }
+            else if(value == "rgba8") { options.stagingFormat = StagingFormat::Rgba8; }
+            else if(value == "rgba16f") { options.stagingFormat = StagingFormat::Rgba16Float; }
+            else { return false; }
+        }
+        else if(arg == "--narrow")
+        {
+            options.narrowFormats = true;
+        }
+        else if(arg == "--palettize")
+        {
+            options.palettize = true;
+        }
+        else if(arg == "--hdr-reduce" && hasValue)
+        {
+            if(!parseValue(argv[++i], options.hdrMaxRelativeError) || !(options.hdrMaxRelativeError >= 0.0f)) { return false; }
+        }
+        else if(arg == "--thumbnails" && hasValue)
+        {
+            options.thumbnailPackPath = argv[++i];
+        }
+        else if(arg == "--thumbnail-size" && hasValue)
+        {
+            if(!parseValue(argv[++i], options.thumbnailSize) || options.thumbnailSize < 1 || options.thumbnailSize > 4096) { return false; }
+        }
+        else if(arg == "--thumbnail-filter" && hasValue)
+        {
+            const std::string_view value = argv[++i];
+
+            if(value == "box") { options.thumbnailFilter = ResampleFilter::Box; }
+            else if(value == "lanczos3") { options.thumbnailFilter = ResampleFilter::Lanczos3; }
+            else { return false; }
+        }
+        else if(arg == "--jpeg-restarts")
+        {
+            options.jpegRestarts = true;
+        }
+        else if(arg == "--interlace-preview")
+        {
+            options.interlacePreview = true;
+        }
+        else if(arg == "--memory-budget-mib" && hasValue)
+        {
+            if(!parseValue(argv[++i], options.memoryBudgetMiB) || options.memoryBudgetMiB < 1) { return false; }
+        }
+        else if(arg == "--read-ahead" && hasValue)
+        {
+            if(!parseValue(argv[++i], options.readAheadFiles) || options.readAheadFiles < 1) { return false; }
+        }
+        else if(arg == "--read-ahead-mib" && hasValue)
+        {
+            if(!parseValue(argv[++i], options.readAheadMiB) || options.readAheadMiB < 1) { return false; }
+        }
+        else if(arg == "--max-pixels" && hasValue)
+        {
+            if(!parseValue(argv[++i], options.limits.maxPixels)) { return false; }
+        }
+        else if(arg == "--max-bytes" && hasValue)
+        {
+            if(!parseValue(argv[++i], options.limits.maxBytes)) { return false; }
+        }
+        else if(arg == "--max-ratio" && hasValue)
+        {
+            // from_chars for floating point is missing from some standard libraries still in use
+            char* end = nullptr;
+            options.limits.maxDecompressedRatio = std::strtod(argv[++i], &end);
+            if(end == argv[i] || *end != '\0' || !std::isfinite(options.limits.maxDecompressedRatio) || options.limits.maxDecompressedRatio < 0.0)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Returns true if the file's header declares sizes beyond the limits, in which case it must not be imported.
+bool exceedsImportLimits(const std::filesystem::path& filePath, const ImportLimits& limits, bool report)
+{
+    if(!limits.enabled()) { return false; }
+
+    // Files without a readable header are left to the importer to reject
+    const std::optional<TextureProbe> probe = probeTexture(filePath);
+    if(!probe) { return false; }
+
+    const ImportLimitError error = checkImportLimits(*probe, limits);
+    if(error == ImportLimitError::None) { return false; }
+
+    if(report)
+    {
+        const std::string_view errorString = toString(error);
+        std::printf("rejected %s: %.*s (%llu x %llu, %llu bytes decoded from %llu bytes)\n",
+                    filePath.string().c_str(),
+                    (int)errorString.size(), errorString.data(),
+                    (unsigned long long)probe->width,
+                    (unsigned long long)probe->height,
+                    (unsigned long long)probe->decodedBytes,
+                    (unsigned long long)probe->fileBytes);
+    }
+
+    return true;
+}
+
+// Cache hits and mapped textures do not read their data, fault in what an importer would have written so the
+// timings compare
+volatile std::byte gTouchedPagesSink;
+
+void touchPages(std::span<const std::byte> data)
+{
+    std::byte value{0};
+
+    for(size_t offset = 0; offset < data.size(); offset += 4096)
+    {
+        value ^= data[offset];
+    }
+
+    gTouchedPagesSink = value;
+}
+
+PassTimings runPass(const BenchOptions& options, bool coldCache, const TextureCache* textureCache)
+{
+    PassTimings timings;
+
+    for(int iteration = 0; iteration < options.iterations; ++iteration)
+    {
+        for(size_t formatIndex = 0; formatIndex < kTestFiles.size(); ++formatIndex)
+        {
+            FormatTimings& formatTimings = timings[formatIndex];
+
+            for(const std::string_view testFile : kTestFiles[formatIndex])
+            {
+                const auto filePath = options.baseDirectory / testFile;
+
+                std::error_code ec;
+                const uintmax_t fileSize = std::filesystem::file_size(filePath, ec);
+
+                // Probed before the cache is prepared and the clocks start, so a cold import faults its header
+                // pages itself and no import pays for the probe
+                if(exceedsImportLimits(filePath, options.limits, iteration == 0))
+                {
+                    ++formatTimings.rejectedCount;
+                    continue;
+                }
+
+                if(coldCache)
+                {
+                    evictFromPageCache(filePath);
+                }
+                else
+                {
+                    loadIntoPageCache(filePath);
+                }
+
+                const auto cpuStart = processCpuTime();
+                const auto wallStart = std::chrono::steady_clock::now();
+
+                bool succeeded = false;
+                bool cached = false;
+                bool mapped = false;
+
+                const std::optional<MappedTexture> mappedTexture = options.mapTextures ? mapTexture(filePath, options.previewExtent) : std::nullopt;
+
+                // Lookups hash the whole file, which is part of the cost of a hit
+                const std::optional<TextureCacheKey> cacheKey = (textureCache && !mappedTexture) ? textureCache->computeKey(filePath) : std::nullopt;
+
+                if(mappedTexture)
+                {
+                    touchPages(mappedTexture->texture().getData());
+
+                    succeeded = true;
+                    mapped = true;
+                }
+                else if(const std::optional<CachedTextures> cachedTextures = cacheKey ? textureCache->find(*cacheKey) : std::nullopt)
+                {
+                    for(const cputex::TextureView& texture : cachedTextures->textures())
+                    {
+                        touchPages(texture.getData());
+                    }
+
+                    succeeded = true;
+                    cached = true;
+                }
+                else
+                {
+                    const teximp::TextureImportResult result = teximp::importTexture(filePath);
+                    succeeded = result.importer != nullptr && result.importer->error() == teximp::TextureImportError::None;
+
+                    if(succeeded && cacheKey)
+                    {
+                        textureCache->store(*cacheKey, result.textureAllocator.getTextures());
+                    }
+                }
+
+                const auto wallTime = std::chrono::steady_clock::now() - wallStart;
+                const auto cpuTime = processCpuTime() - cpuStart;
+
+                ++formatTimings.importCount;
+                formatTimings.fileBytes += ec ? 0 : fileSize;
+                formatTimings.wallTime += wallTime;
+                formatTimings.cpuTime += cpuTime;
+                formatTimings.waitTime += std::max(std::chrono::nanoseconds(wallTime - cpuTime), std::chrono::nanoseconds(0));
+
+                if(cached)
+                {
+                    ++formatTimings.cachedCount;
+                }
+
+                if(mapped)
+                {
+                    ++formatTimings.mappedCount;
+                }
+
+                if(!succeeded)
+                {
+                    ++formatTimings.errorCount;
+                }
+            }
+        }
+    }
+
+    return timings;
+}
+
+void printTimings(std::string_view label, const PassTimings& timings)
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    std::printf("\n%.*s page cache\n", (int)label.size(), label.data());
+    std::printf("%-10s %8s %8s %8s %8s %8s %10s %12s %12s %12s %10s\n", "format", "imports", "errors", "rejected", "cached", "mapped", "MiB", "wall ms", "cpu ms", "io wait ms", "MiB/s");
+
+    FormatTimings total;
+
+    const auto printRow = [](std::string_view name, const FormatTimings& row)
+    {
+        const double mebibytes = (double)row.fileBytes / (1024.0 * 1024.0);
+        const double wallMs = Milliseconds(row.wallTime).count();
+
+        std::printf("%-10.*s %8d %8d %8d %8d %8d %10.2f %12.2f %12.2f %12.2f %10.2f\n",
+                    (int)name.size(), name.data(),
+                    row.importCount,
+                    row.errorCount,
+                    row.rejectedCount,
+                    row.cachedCount,
+                    row.mappedCount,
+                    mebibytes,
+                    wallMs,
+                    Milliseconds(row.cpuTime).count(),
+                    Milliseconds(row.waitTime).count(),
+                    (wallMs > 0.0) ? mebibytes / (wallMs / 1000.0) : 0.0);
+    };
+
+    for(size_t formatIndex = 0; formatIndex < timings.size(); ++formatIndex)
+    {
+        const FormatTimings& formatTimings = timings[formatIndex];
+        if(formatTimings.importCount == 0 && formatTimings.rejectedCount == 0) { continue; }
+
+        printRow(teximp::toString((teximp::FileFormat)formatIndex), formatTimings);
+
+        total.importCount += formatTimings.importCount;
+        total.errorCount += formatTimings.errorCount;
+        total.rejectedCount += formatTimings.rejectedCount;
+        total.cachedCount += formatTimings.cachedCount;
+        total.mappedCount += formatTimings.mappedCount;
+        total.fileBytes += formatTimings.fileBytes;
+        total.wallTime += formatTimings.wallTime;
+        total.cpuTime += formatTimings.cpuTime;
+        total.waitTime += formatTimings.waitTime;
+    }
+
+    printRow("total", total);
+}
+
+struct SoakCycle
+{
+    LatencyHistogram latencies;
+    int errorCount = 0;
+    int rejectedCount = 0;
+    uint64_t residentBytes = 0;
+    int handleCount = 0;
+};
+
+// Reports growth that happened in every cycle after the first. A single increase is normal as caches and
+// allocator pools fill up, steady growth over many cycles is what a leak looks like.
+template<class T, class Getter>
+void reportMonotonicGrowth(const char* name, const std::vector<SoakCycle>& cycles, Getter getter)
+{
+    if(cycles.size() < 3) { return; }
+
+    bool monotonic = true;
+    for(size_t i = 2; i < cycles.size(); ++i)
+    {
+        monotonic = monotonic && getter(cycles[i]) >= getter(cycles[i - 1]);
+    }
+
+    const T growth = getter(cycles.back()) - getter(cycles[1]);
+
+    if(monotonic && growth > 0)
+    {
+        std::printf("WARNING: %s grew in every cycle after the first, %lld total (%.1f per cycle)\n",
+                    name,
+                    (long long)growth,
+                    (double)growth / (double)(cycles.size() - 2));
+    }
+    else
+    {
+        std::printf("%s: no monotonic growth\n", name);
+    }
+}
+
+int runSoak(const BenchOptions& options)
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    std::vector<SoakCycle> cycles;
+    cycles.reserve(options.soakCycles);
+
+    LatencyHistogram totalLatencies;
+
+    std::printf("%6s %8s %8s %8s %10s %10s %10s %10s %12s %8s\n", "cycle", "imports", "errors", "rejected", "p50 us", "p90 us", "p99 us", "max ms", "resident MiB", "handles");
+
+    for(int cycle = 0; cycle < options.soakCycles; ++cycle)
+    {
+        SoakCycle& soakCycle = cycles.emplace_back();
+
+        // Same order as the viewer's auto mode: every file of a format, then on to the next format
+        for(size_t formatIndex = 0; formatIndex < kTestFiles.size(); ++formatIndex)
+        {
+            for(const std::string_view testFile : kTestFiles[formatIndex])
+            {
+                const auto filePath = options.baseDirectory / testFile;
+
+                if(exceedsImportLimits(filePath, options.limits, cycle == 0))
+                {
+                    ++soakCycle.rejectedCount;
+                    continue;
+                }
+
+                const auto start = std::chrono::steady_clock::now();
+                teximp::TextureImportResult result = teximp::importTexture(filePath);
+                soakCycle.latencies.add(std::chrono::steady_clock::now() - start);
+
+                if(result.importer == nullptr || result.importer->error() != teximp::TextureImportError::None)
+                {
+                    ++soakCycle.errorCount;
+                }
+            }
+        }
+
+        soakCycle.residentBytes = processResidentBytes();
+        soakCycle.handleCount = processHandleCount();
+        totalLatencies.merge(soakCycle.latencies);
+
+        std::printf("%6d %8llu %8d %8d %10lld %10lld %10lld %10.2f %12.2f %8d\n",
+                    cycle,
+                    (unsigned long long)soakCycle.latencies.count(),
+                    soakCycle.errorCount,
+                    soakCycle.rejectedCount,
+                    (long long)soakCycle.latencies.percentile(50.0).count(),
+                    (long long)soakCycle.latencies.percentile(90.0).count(),
+                    (long long)soakCycle.latencies.percentile(99.0).count(),
+                    Milliseconds(soakCycle.latencies.max()).count(),
+                    (double)soakCycle.residentBytes / (1024.0 * 1024.0),
+                    soakCycle.handleCount);
+        std::fflush(stdout);
+    }
+
+    std::puts("\nimport latency over all cycles");
+    totalLatencies.print();
+    std::puts("");
+
+    reportMonotonicGrowth<int64_t>("resident bytes", cycles, [](const SoakCycle& cycle) { return (int64_t)cycle.residentBytes; });
+    reportMonotonicGrowth<int64_t>("handle count", cycles, [](const SoakCycle& cycle) { return (int64_t)cycle.handleCount; });
+
+    return 0;
+}
+
+int runBatch(const BenchOptions& options)
+{
+    using Seconds = std::chrono::duration<double>;
+
+    const bool readAhead = options.readAheadFiles > 0;
+
+    if(readAhead && !pageCacheEvictionSupported())
+    {
+        std::fputs("Read ahead needs a cold page cache, which is not supported on this platform.\n", stderr);
+        return 1;
+    }
+
+    std::vector<std::filesystem::path> filePaths;
+    std::vector<uint64_t> decodedBytesEstimates;
+    uintmax_t totalBytes = 0;
+    int rejectedCount = 0;
+
+    for(const std::span<const std::string_view> formatTestFiles : kTestFiles)
+    {
+        for(const std::string_view testFile : formatTestFiles)
+        {
+            auto filePath = options.baseDirectory / testFile;
+
+            if(exceedsImportLimits(filePath, options.limits, true))
+            {
+                ++rejectedCount;
+                continue;
+            }
+
+            std::error_code ec;
+            const uintmax_t fileSize = std::filesystem::file_size(filePath, ec);
+            totalBytes += ec ? 0 : fileSize;
+
+            if(options.memoryBudgetMiB > 0)
+            {
+                // Without a readable header the file size is the only estimate there is
+                const std::optional<TextureProbe> probe = probeTexture(filePath);
+                decodedBytesEstimates.push_back(probe ? std::max<uint64_t>(probe->decodedBytes, probe->fileBytes) : (ec ? 0 : fileSize));
+            }
+
+            if(!readAhead)
+            {
+                loadIntoPageCache(filePath);
+            }
+
+            filePaths.push_back(std::move(filePath));
+        }
+    }
+
+    ThreadPool threadPool(options.threadCount);
+
+    std::optional<MemoryBudget> memoryBudget;
+    if(options.memoryBudgetMiB > 0)
+    {
+        memoryBudget.emplace(options.memoryBudgetMiB * 1024 * 1024);
+    }
+
+    int importCount = 0;
+    int errorCount = 0;
+    bool usedIoUring = false;
+
+    std::chrono::nanoseconds elapsed{0};
+
+    for(int iteration = 0; iteration < options.iterations; ++iteration)
+    {
+        if(readAhead)
+        {
+            // Eviction is not part of the measurement
+            for(const std::filesystem::path& filePath : filePaths)
+            {
+                evictFromPageCache(filePath);
+            }
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+
+        std::optional<ReadAhead> fileReadAhead;
+        if(readAhead)
+        {
+            ReadAheadOptions readAheadOptions;
+            readAheadOptions.maxFilesInFlight = options.readAheadFiles;
+            readAheadOptions.maxBytesInFlight = options.readAheadMiB * 1024 * 1024;
+
+            fileReadAhead.emplace(filePaths, readAheadOptions);
+        }
+
+        // Results are checked and freed on the worker, holding every imported texture until the end of the
+        // iteration would defeat the memory budget.
+        std::vector<std::future<bool>> imports;
+        imports.reserve(filePaths.size());
+
+        for(size_t fileIndex = 0; fileIndex < filePaths.size(); ++fileIndex)
+        {
+            if(fileReadAhead)
+            {
+                fileReadAhead->waitUntilRead(fileIndex);
+            }
+
+            if(memoryBudget)
+            {
+                memoryBudget->acquire(decodedBytesEstimates[fileIndex]);
+            }
+
+            auto task = std::make_shared<std::packaged_task<bool()>>(
+                [&fileReadAhead, &memoryBudget, &filePaths, &decodedBytesEstimates, fileIndex]()
+                {
+                    bool succeeded = false;
+
+                    {
+                        const teximp::TextureImportResult result = teximp::importTexture(filePaths[fileIndex]);
+                        succeeded = result.importer != nullptr && result.importer->error() == teximp::TextureImportError::None;
+                    }
+
+                    if(fileReadAhead)
+                    {
+                        fileReadAhead->release(fileIndex);
+                    }
+
+                    if(memoryBudget)
+                    {
+                        memoryBudget->release(decodedBytesEstimates[fileIndex]);
+                    }
+
+                    return succeeded;
+                });
+
+            imports.push_back(task->get_future());
+            threadPool.post([task]() { (*task)(); });
+        }
+
+        for(std::future<bool>& import : imports)
+        {
+            ++importCount;
+
+            if(!import.get())
+            {
+                ++errorCount;
+            }
+        }
+
+        if(fileReadAhead)
+        {
+            usedIoUring = fileReadAhead->usingIoUring();
+        }
+
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    const double seconds = Seconds(elapsed).count();
+    const double mebibytes = (double)totalBytes * options.iterations / (1024.0 * 1024.0);
+
+    std::printf("\n%d threads: %d imports, %d errors, %d rejected in %.3f s, %.1f imports/s, %.2f MiB/s\n",
+                options.threadCount,
+                importCount,
+                errorCount,
+                rejectedCount,
+                seconds,
+                (seconds > 0.0) ? importCount / seconds : 0.0,
+                (seconds > 0.0) ? mebibytes / seconds : 0.0);
+
+    if(readAhead)
+    {
+        std::printf("read ahead: %d files, %llu MiB, %s\n",
+                    options.readAheadFiles,
+                    (unsigned long long)options.readAheadMiB,
+                    usedIoUring ? "io_uring" : "thread pool");
+    }
+
+    if(memoryBudget)
+    {
+        std::printf("memory budget: %llu MiB, peak estimated in flight %.1f MiB\n",
+                    (unsigned long long)options.memoryBudgetMiB,
+                    (double)memoryBudget->peakBytes() / (1024.0 * 1024.0));
+    }
+
+    return 0;
+}
+
+// Per file, so the error bound can be picked per asset
+void printHdrReductions(const std::vector<HdrReductionRecord>& records, std::span<const std::filesystem::path> filePaths, const std::filesystem::path& baseDirectory)
+{
+    int reducedCount = 0;
+    float worstRelativeError = 0.0f;
+
+    std::printf("%-60s %-24s %-24s %14s %14s\n", "file", "imported as", "staged as", "max rel error", "max abs error");
+
+    for(const HdrReductionRecord& record : records)
+    {
+        const std::string fileName = filePaths[record.fileIndex].lexically_relative(baseDirectory).generic_string();
+        const std::string_view sourceFormatName = gpufmt::toString(record.sourceFormat);
+        const std::string_view stagedFormatName = (record.reduction.format != gpufmt::Format::UNDEFINED) ? gpufmt::toString(record.reduction.format) : "unchanged";
+
+        std::printf("%-60s %-24.*s %-24.*s %14.3g %14.3g\n",
+                    fileName.c_str(),
+                    (int)sourceFormatName.size(), sourceFormatName.data(),
+                    (int)stagedFormatName.size(), stagedFormatName.data(),
+                    record.reduction.maxRelativeError,
+                    record.reduction.maxAbsoluteError);
+
+        if(record.reduction.format != gpufmt::Format::UNDEFINED)
+        {
+            ++reducedCount;
+            worstRelativeError = std::max(worstRelativeError, record.reduction.maxRelativeError);
+        }
+    }
+
+    std::printf("reduced %d of %d floating point textures, worst relative error of a reduced texture %.3g\n",
+                reducedCount,
+                (int)records.size(),
+                worstRelativeError);
+}
+
+void runPipeline(const BenchOptions& options, bool coldCache)
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    using Seconds = std::chrono::duration<double>;
+
+    std::vector<std::filesystem::path> filePaths;
+    int rejectedCount = 0;
+
+    for(const std::span<const std::string_view> formatTestFiles : kTestFiles)
+    {
+        for(const std::string_view testFile : formatTestFiles)
+        {
+            auto filePath = options.baseDirectory / testFile;
+
+            if(exceedsImportLimits(filePath, options.limits, false))
+            {
+                ++rejectedCount;
+                continue;
+            }
+
+            filePaths.push_back(std::move(filePath));
+        }
+    }
+
+    ImportPipelineOptions pipelineOptions;
+    pipelineOptions.readThreadCount = options.pipelineReadThreads;
+    pipelineOptions.decodeThreadCount = (options.threadCount > 0) ? options.threadCount : std::max((int)std::thread::hardware_concurrency(), 1);
+    pipelineOptions.queueDepth = pipelineOptions.decodeThreadCount * 2;
+    pipelineOptions.stagingFormat = options.stagingFormat;
+    pipelineOptions.narrowFormats = options.narrowFormats;
+    pipelineOptions.palettize = options.palettize;
+    pipelineOptions.reduceHdr = options.hdrMaxRelativeError >= 0.0f;
+    pipelineOptions.hdrReduction.maxRelativeError = options.hdrMaxRelativeError;
+
+    ImportPipelineResult total;
+
+    for(int iteration = 0; iteration < options.iterations; ++iteration)
+    {
+        // Both are outside of the measurement
+        for(const std::filesystem::path& filePath : filePaths)
+        {
+            if(coldCache) { evictFromPageCache(filePath); }
+            else { loadIntoPageCache(filePath); }
+        }
+
+        const ImportPipelineResult result = runImportPipeline(filePaths, pipelineOptions);
+
+        total.importCount += result.importCount;
+        total.errorCount += result.errorCount;
+        total.stagedBytes += result.stagedBytes;
+        total.unconvertedCount += result.unconvertedCount;
+        total.narrowedCount += result.narrowedCount;
+        total.palettizedCount += result.palettizedCount;
+
+        // Every iteration measures the same files, the first one is enough
+        if(iteration == 0) { total.hdrReductions = result.hdrReductions; }
+        total.wallTime += result.wallTime;
+
+        for(size_t stageIndex = 0; stageIndex < total.stages.size(); ++stageIndex)
+        {
+            total.stages[stageIndex].threadCount = result.stages[stageIndex].threadCount;
+            total.stages[stageIndex].itemCount += result.stages[stageIndex].itemCount;
+            total.stages[stageIndex].busyTime += result.stages[stageIndex].busyTime;
+        }
+    }
+
+    const double seconds = Seconds(total.wallTime).count();
+
+    std::printf("\n%s pipeline: %d imports, %d errors, %d rejected in %.3f s, %.1f imports/s, %.2f MiB staged/s\n",
+                coldCache ? "cold" : "warm",
+                total.importCount,
+                total.errorCount,
+                rejectedCount,
+                seconds,
+                (seconds > 0.0) ? total.importCount / seconds : 0.0,
+                (seconds > 0.0) ? (double)total.stagedBytes / (1024.0 * 1024.0) / seconds : 0.0);
+
+    if(options.stagingFormat != StagingFormat::Native)
+    {
+        const std::string_view stagingFormatName = toString(options.stagingFormat);
+        std::printf("staged as %.*s, %d textures had no conversion and were staged as imported\n",
+                    (int)stagingFormatName.size(), stagingFormatName.data(),
+                    total.unconvertedCount);
+    }
+
+    if(options.narrowFormats)
+    {
+        std::printf("narrowed %d textures to R8, RG8, 16 bit packed formats or B8G8R8X8\n", total.narrowedCount);
+    }
+
+    if(options.palettize)
+    {
+        std::printf("palettized %d textures with at most 256 colors\n", total.palettizedCount);
+    }
+
+    if(pipelineOptions.reduceHdr)
+    {
+        printHdrReductions(total.hdrReductions, filePaths, options.baseDirectory);
+    }
+
+    // A stage close to 100% busy is the bottleneck, the stages around it wait on it
+    std::printf("%-8s %8s %8s %12s %8s\n", "stage", "threads", "items", "busy ms", "busy %");
+
+    for(size_t stageIndex = 0; stageIndex < total.stages.size(); ++stageIndex)
+    {
+        const ImportPipelineStageStats& stage = total.stages[stageIndex];
+        const std::string_view stageName = toString((ImportPipelineStage)stageIndex);
+        const double busyMilliseconds = Milliseconds(stage.busyTime).count();
+        const double availableMilliseconds = Milliseconds(total.wallTime).count() * stage.threadCount;
+
+        std::printf("%-8.*s %8d %8d %12.2f %7.1f%%\n",
+                    (int)stageName.size(), stageName.data(),
+                    stage.threadCount,
+                    stage.itemCount,
+                    busyMilliseconds,
+                    (availableMilliseconds > 0.0) ? busyMilliseconds / availableMilliseconds * 100.0 : 0.0);
+    }
+}
+
+int runThumbnails(const BenchOptions& options)
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    std::vector<std::filesystem::path> filePaths;
+    int rejectedCount = 0;
+
+    for(const std::span<const std::string_view> formatTestFiles : kTestFiles)
+    {
+        for(const std::string_view testFile : formatTestFiles)
+        {
+            auto filePath = options.baseDirectory / testFile;
+
+            if(exceedsImportLimits(filePath, options.limits, false))
+            {
+                ++rejectedCount;
+                continue;
+            }
+
+            filePaths.push_back(std::move(filePath));
+        }
+    }
+
+    ThumbnailOptions thumbnailOptions;
+    thumbnailOptions.size = options.thumbnailSize;
+    thumbnailOptions.filter = options.thumbnailFilter;
+    thumbnailOptions.threadCount = (options.threadCount > 0) ? options.threadCount : std::max((int)std::thread::hardware_concurrency(), 1);
+    thumbnailOptions.importerVersion = TEXIMP_BENCH_IMPORTER_VERSION;
+
+    const ThumbnailPackUpdate update = updateThumbnailPack(options.thumbnailPackPath, filePaths, thumbnailOptions);
+
+    if(!update.written)
+    {
+        std::fprintf(stderr, "Could not write the thumbnail pack %s.\n", options.thumbnailPackPath.string().c_str());
+        return 1;
+    }
+
+    const std::string_view filterName = toString(thumbnailOptions.filter);
+    std::printf("thumbnails: %d files, %d computed, %d reused, %d failed, %d rejected in %.2f ms (%dpx %.*s, %d threads)\n",
+                update.fileCount,
+                update.computedCount,
+                update.reusedCount,
+                update.failedCount,
+                rejectedCount,
+                Milliseconds(update.wallTime).count(),
+                thumbnailOptions.size,
+                (int)filterName.size(), filterName.data(),
+                thumbnailOptions.threadCount);
+
+    // What a browser pays to show the whole corpus: map the pack, hash every file and find its thumbnail
+    const auto lookupStart = std::chrono::steady_clock::now();
+
+    const std::optional<ThumbnailPack> pack = openThumbnailPack(options.thumbnailPackPath);
+    if(!pack) { return 1; }
+
+    int foundCount = 0;
+
+    for(const std::filesystem::path& filePath : filePaths)
+    {
+        const std::optional<ThumbnailKey> key = computeThumbnailKey(filePath, thumbnailOptions);
+
+        if(const std::optional<cputex::TextureView> thumbnail = key ? pack->find(*key) : std::nullopt)
+        {
+            touchPages(thumbnail->getData());
+            ++foundCount;
+        }
+    }
+
+    std::printf("found %d of %zu thumbnails in %.2f ms\n", foundCount, filePaths.size(), Milliseconds(std::chrono::steady_clock::now() - lookupStart).count());
+    return 0;
+}
+
+int runJpegRestarts(const BenchOptions& options)
+{
+    using Microseconds = std::chrono::duration<double, std::micro>;
+
+    int parallelCount = 0;
+    int serialCount = 0;
+
+    for(const std::string_view testFile : kTestFiles[(size_t)teximp::FileFormat::Jpeg])
+    {
+        const std::filesystem::path filePath = options.baseDirectory / testFile;
+
+        MappedFile file;
+        if(!file.open(filePath)) { continue; }
+
+        // The scan is a serial pass in front of the parallel decode, it has to stay far below the decode's cost
+        const auto start = std::chrono::steady_clock::now();
+        const std::optional<JpegRestartLayout> layout = findJpegRestartSegments(file.data());
+        const double scanMicroseconds = Microseconds(std::chrono::steady_clock::now() - start).count();
+
+        if(layout)
+        {
+            ++parallelCount;
+            std::printf("%-70.*s %6zu segments of %5u MCUs, %ux%u MCUs, scanned in %.1f us\n",
+                        (int)testFile.size(), testFile.data(),
+                        layout->segments.size(),
+                        layout->restartInterval,
+                        layout->mcusPerRow,
+                        layout->mcuRows,
+                        scanMicroseconds);
+        }
+        else
+        {
+            ++serialCount;
+            std::printf("%-70.*s serial\n", (int)testFile.size(), testFile.data());
+        }
+    }
+
+    std::printf("%d JPEGs can be entropy decoded in parallel, %d need a serial decode\n", parallelCount, serialCount);
+    return 0;
+}
+
+bool isAdam7Png(const MappedFile& file)
+{
+    // The interlace method is the last byte of IHDR, which always follows the 8 byte signature
+    constexpr size_t kInterlaceOffset = 8 + 8 + 12;
+    return file.data().size() > kInterlaceOffset && file.data()[kInterlaceOffset] == std::byte{1};
+}
+
+int runInterlacePreview(const BenchOptions& options)
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+    using Microseconds = std::chrono::duration<double, std::micro>;
+
+    std::puts("previews after passes 1 to 7 hold 1/64, 1/32, 1/16, 1/8, 1/4, 1/2 and all of the pixels");
+
+    int previewedCount = 0;
+
+    for(const std::string_view testFile : kTestFiles[(size_t)teximp::FileFormat::Png])
+    {
+        const std::filesystem::path filePath = options.baseDirectory / testFile;
+
+        {
+            MappedFile file;
+            if(!file.open(filePath) || !isAdam7Png(file)) { continue; }
+        }
+
+        const auto importStart = std::chrono::steady_clock::now();
+        const teximp::TextureImportResult result = teximp::importTexture(filePath);
+        const double importMilliseconds = Milliseconds(std::chrono::steady_clock::now() - importStart).count();
+
+        if(result.importer == nullptr || result.importer->error() != teximp::TextureImportError::None || result.textureAllocator.getTextures().empty())
+        {
+            std::printf("%-70.*s failed to import\n", (int)testFile.size(), testFile.data());
+            continue;
+        }
+
+        const cputex::TextureView texture = result.textureAllocator.getTextures()[0];
+        const gpufmt::FormatInfo& formatInfo = gpufmt::formatInfo(texture.format());
+        if(formatInfo.blockCompressed) { continue; }
+
+        // From the start of each pass to its callback. Taking the pass out of the decoded image is included, which a
+        // decoder would not have to do, so this bounds what previews add to an interlaced decode.
+        std::array<double, kAdam7Passes.size()> previewMicroseconds = {};
+        auto passStart = std::chrono::steady_clock::now();
+
+        replayAdam7Passes(texture.getMipSurfaceData(0, 0, 0), texture.extent().x, texture.extent().y, formatInfo.blockByteSize,
+            [&](std::span<const std::byte>, int completedPasses)
+            {
+                const auto now = std::chrono::steady_clock::now();
+                previewMicroseconds[completedPasses - 1] = Microseconds(now - passStart).count();
+                passStart = now;
+            });
+
+        ++previewedCount;
+        std::printf("%-70.*s %5dx%-5d import %8.3f ms, previews", (int)testFile.size(), testFile.data(), texture.extent().x, texture.extent().y,
+                    importMilliseconds);
+        for(const double microseconds : previewMicroseconds)
+        {
+            std::printf(" %7.1f", microseconds);
+        }
+        std::puts(" us");
+    }
+
+    std::printf("%d interlaced PNGs previewed\n", previewedCount);
+    return 0;
+}
+}
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+
+    if(!parseArguments(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if(options.soakCycles > 0)
+    {
+        return runSoak(options);
+    }
+
+    if(!options.thumbnailPackPath.empty())
+    {
+        return runThumbnails(options);
+    }
+
+    if(options.jpegRestarts)
+    {
+        return runJpegRestarts(options);
+    }
+
+    if(options.interlacePreview)
+    {
+        return runInterlacePreview(options);
+    }
+
+    if(options.threadCount > 0 && options.pipelineReadThreads == 0)
+    {
+        return runBatch(options);
+    }
+
+    if(options.cacheMode != CacheMode::Warm && !pageCacheEvictionSupported())
+    {
+        std::fputs("Evicting files from the page cache is not supported on this platform.\n", stderr);
+        return 1;
+    }
+
+    if(options.pipelineReadThreads > 0)
+    {
+        if(options.cacheMode == CacheMode::Warm || options.cacheMode == CacheMode::Both)
+        {
+            runPipeline(options, false);
+        }
+
+        if(options.cacheMode == CacheMode::Cold || options.cacheMode == CacheMode::Both)
+        {
+            runPipeline(options, true);
+        }
+
+        return 0;
+    }
+
+    std::optional<TextureCache> textureCache;
+    if(!options.textureCacheDirectory.empty())
+    {
+        TextureCacheOptions textureCacheOptions;
+        textureCacheOptions.directory = options.textureCacheDirectory;
+        textureCacheOptions.importerVersion = TEXIMP_BENCH_IMPORTER_VERSION;
+        textureCacheOptions.compress = options.textureCacheCompress;
+        textureCacheOptions.verification = options.textureCacheVerification;
+
+        textureCache.emplace(std::move(textureCacheOptions));
+
+        if((options.textureCacheCompress || options.textureCacheColdHours >= 0) && !textureCache->compressionSupported())
+        {
+            std::fputs("This build has no LZ4, texture cache entries are stored uncompressed.\n", stderr);
+        }
+
+        if(options.textureCacheColdHours >= 0)
+        {
+            const auto notUsedSince = std::filesystem::file_time_type::clock::now() - std::chrono::hours(options.textureCacheColdHours);
+            std::printf("compressed %d cold texture cache entries\n", textureCache->compressColdEntries(notUsedSince));
+        }
+    }
+
+    const TextureCache* const textureCachePointer = textureCache ? &*textureCache : nullptr;
+
+    if(options.cacheMode == CacheMode::Warm || options.cacheMode == CacheMode::Both)
+    {
+        printTimings("warm", runPass(options, false, textureCachePointer));
+    }
+
+    if(options.cacheMode == CacheMode::Cold || options.cacheMode == CacheMode::Both)
+    {
+        printTimings("cold", runPass(options, true, textureCachePointer));
+    }
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : mData(std::exchange(other.mData, nullptr))
+    , mSize(std::exchange(other.mSize, 0))
+    , mOpen(std::exchange(other.mOpen, false))
+#ifdef _WIN32
+    , mFile(std::exchange(other.mFile, nullptr))
+    , mMapping(std::exchange(other.mMapping, nullptr))
+#endif
+{}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if(this != &other)
+    {
+        close();
+
+        mData = std::exchange(other.mData, nullptr);
+        mSize = std::exchange(other.mSize, 0);
+        mOpen = std::exchange(other.mOpen, false);
+#ifdef _WIN32
+        mFile = std::exchange(other.mFile, nullptr);
+        mMapping = std::exchange(other.mMapping, nullptr);
+#endif
+    }
+
+    return *this;
+}
+
+bool MappedFile::open(const std::filesystem::path& filePath)
+{
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(file == INVALID_HANDLE_VALUE) { return false; }
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize))
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // Mapping an empty file fails, there is nothing to map anyway
+    if(fileSize.QuadPart > 0)
+    {
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if(mapping == nullptr)
+        {
+            CloseHandle(file);
+            return false;
+        }
+
+        const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if(data == nullptr)
+        {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        mMapping = mapping;
+        mData = (const std::byte*)data;
+        mSize = (size_t)fileSize.QuadPart;
+    }
+
+    mFile = file;
+#else
+    const int fd = ::open(filePath.c_str(), O_RDONLY);
+    if(fd < 0) { return false; }
+
+    struct stat fileStat;
+    if(::fstat(fd, &fileStat) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // Mapping an empty file fails, there is nothing to map anyway
+    if(fileStat.st_size > 0)
+    {
+        void* data = ::mmap(nullptr, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data == MAP_FAILED)
+        {
+            ::close(fd);
+            return false;
+        }
+
+        mData = (const std::byte*)data;
+        mSize = (size_t)fileStat.st_size;
+    }
+
+    // The mapping keeps its own reference to the file
+    ::close(fd);
+#endif
+
+    mOpen = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+    if(!mOpen) { return; }
+
+#ifdef _WIN32
+    if(mData != nullptr) { UnmapViewOfFile(mData); }
+    if(mMapping != nullptr) { CloseHandle(mMapping); }
+    if(mFile != nullptr) { CloseHandle(mFile); }
+
+    mFile = nullptr;
+    mMapping = nullptr;
+#else
+    if(mData != nullptr) { ::munmap((void*)mData, mSize); }
+#endif
+
+    mData = nullptr;
+    mSize = 0;
+    mOpen = false;
+}
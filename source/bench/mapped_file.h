@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+// Read only memory mapping of a whole file. Pages are faulted in from the page cache on first access instead of
+// being copied into a buffer up front.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::filesystem::path& filePath);
+    void close();
+
+    bool isOpen() const { return mOpen; }
+    std::span<const std::byte> data() const { return {mData, mSize}; }
+
+private:
+    const std::byte* mData = nullptr;
+    size_t mSize = 0;
+    bool mOpen = false;
+
+#ifdef _WIN32
+    void* mFile = nullptr;
+    void* mMapping = nullptr;
+#endif
+};
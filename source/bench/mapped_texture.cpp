@@ -0,0 +1,419 @@
+#include "mapped_texture.h"
+
+#include <gpufmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <string_view>
+
+namespace
+{
+template<class T>
+bool readValue(std::span<const std::byte> data, size_t offset, T& value)
+{
+    if(offset > data.size() || sizeof(T) > data.size() - offset) { return false; }
+
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return true;
+}
+
+constexpr size_t kMaxSize = std::numeric_limits<size_t>::max();
+// Header values are untrusted, anything beyond these is not a texture that could be used in place anyway
+constexpr cputex::CountType kMaxMips = 32;
+constexpr cputex::CountType kMaxArraySize = 1 << 16;
+
+size_t saturatingMultiply(size_t a, size_t b)
+{
+    if(a != 0 && b > kMaxSize / a) { return kMaxSize; }
+    return a * b;
+}
+
+// Bytes a texture takes with every subresource tightly packed, the way DDS stores them
+size_t packedSurfaceSize(const cputex::TextureParams& params, const gpufmt::FormatInfo& formatInfo, cputex::CountType mip)
+{
+    const cputex::Extent mipExtent = cputex::calculateMipExtent(params.extent, mip);
+    const size_t blocksX = (mipExtent.x + formatInfo.blockExtent.x - 1) / formatInfo.blockExtent.x;
+    const size_t blocksY = (mipExtent.y + formatInfo.blockExtent.y - 1) / formatInfo.blockExtent.y;
+    const size_t blocksZ = (mipExtent.z + formatInfo.blockExtent.z - 1) / formatInfo.blockExtent.z;
+    return saturatingMultiply(saturatingMultiply(saturatingMultiply(blocksX, blocksY), blocksZ), formatInfo.blockByteSize);
+}
+
+size_t packedTextureSize(const cputex::TextureParams& params, const gpufmt::FormatInfo& formatInfo)
+{
+    size_t mipChainSize = 0;
+    for(cputex::CountType mip = 0; mip < params.mips; ++mip)
+    {
+        mipChainSize = std::min(mipChainSize + packedSurfaceSize(params, formatInfo, mip), kMaxSize / 2);
+    }
+
+    return saturatingMultiply(saturatingMultiply(mipChainSize, params.faces), params.arraySize);
+}
+
+// Every subresource has to be exactly where cputex expects it, otherwise the data cannot be used in place
+bool matchesCputexLayout(const cputex::TextureView& texture, const cputex::TextureParams& params, const gpufmt::FormatInfo& formatInfo)
+{
+    const std::byte* const base = texture.getData().data();
+    size_t expectedOffset = 0;
+
+    for(cputex::CountType arraySlice = 0; arraySlice < params.arraySize; ++arraySlice)
+    {
+        for(cputex::CountType face = 0; face < params.faces; ++face)
+        {
+            for(cputex::CountType mip = 0; mip < params.mips; ++mip)
+            {
+                const size_t expectedSize = packedSurfaceSize(params, formatInfo, mip);
+
+                const std::span<const std::byte> surface = texture.getMipSurfaceData(arraySlice, face, mip);
+                if((size_t)(surface.data() - base) != expectedOffset || surface.size() != expectedSize) { return false; }
+
+                expectedOffset += expectedSize;
+            }
+        }
+    }
+
+    return expectedOffset == texture.sizeInBytes();
+}
+
+#ifdef TEXIMP_ENABLE_DDS
+constexpr uint32_t kDdpfAlphaPixels = 0x1;
+constexpr uint32_t kDdpfFourCC = 0x4;
+constexpr uint32_t kDdpfRgb = 0x40;
+constexpr uint32_t kDdsCaps2Cubemap = 0x200;
+constexpr uint32_t kDdsCaps2CubemapAllFaces = 0xfc00;
+constexpr uint32_t kDdsCaps2Volume = 0x200000;
+constexpr uint32_t kDx10ResourceDimensionTexture1D = 2;
+constexpr uint32_t kDx10ResourceDimensionTexture3D = 4;
+constexpr uint32_t kDx10MiscTextureCube = 0x4;
+
+gpufmt::Format dxgiToFormat(uint32_t dxgiFormat)
+{
+    switch(dxgiFormat)
+    {
+    case 2: return gpufmt::Format::R32G32B32A32_SFLOAT;
+    case 10: return gpufmt::Format::R16G16B16A16_SFLOAT;
+    case 26: return gpufmt::Format::B10G11R11_UFLOAT_PACK32;
+    case 28: return gpufmt::Format::R8G8B8A8_UNORM;
+    case 29: return gpufmt::Format::R8G8B8A8_SRGB;
+    case 49: return gpufmt::Format::R8G8_UNORM;
+    case 61: return gpufmt::Format::R8_UNORM;
+    case 67: return gpufmt::Format::E5B9G9R9_UFLOAT_PACK32;
+    case 71: return gpufmt::Format::BC1_RGBA_UNORM_BLOCK;
+    case 72: return gpufmt::Format::BC1_RGBA_SRGB_BLOCK;
+    case 74: return gpufmt::Format::BC2_UNORM_BLOCK;
+    case 75: return gpufmt::Format::BC2_SRGB_BLOCK;
+    case 77: return gpufmt::Format::BC3_UNORM_BLOCK;
+    case 78: return gpufmt::Format::BC3_SRGB_BLOCK;
+    case 80: return gpufmt::Format::BC4_UNORM_BLOCK;
+    case 81: return gpufmt::Format::BC4_SNORM_BLOCK;
+    case 83: return gpufmt::Format::BC5_UNORM_BLOCK;
+    case 84: return gpufmt::Format::BC5_SNORM_BLOCK;
+    case 85: return gpufmt::Format::R5G6B5_UNORM_PACK16;
+    case 86: return gpufmt::Format::A1R5G5B5_UNORM_PACK16;
+    case 87: return gpufmt::Format::B8G8R8A8_UNORM;
+    case 88: return gpufmt::Format::B8G8R8X8_UNORM;
+    case 91: return gpufmt::Format::B8G8R8A8_SRGB;
+    case 95: return gpufmt::Format::BC6H_UFLOAT_BLOCK;
+    case 96: return gpufmt::Format::BC6H_SFLOAT_BLOCK;
+    case 98: return gpufmt::Format::BC7_UNORM_BLOCK;
+    case 99: return gpufmt::Format::BC7_SRGB_BLOCK;
+    case 115: return gpufmt::Format::A4R4G4B4_UNORM_PACK16;
+    default: return gpufmt::Format::UNDEFINED;
+    }
+}
+
+gpufmt::Format legacyDdsToFormat(uint32_t pixelFormatFlags, std::string_view fourCC, uint32_t rgbBitCount, const std::array<uint32_t, 4>& masks)
+{
+    if((pixelFormatFlags & kDdpfFourCC) != 0)
+    {
+        if(fourCC == "DXT1") { return gpufmt::Format::BC1_RGBA_UNORM_BLOCK; }
+        if(fourCC == "DXT2" || fourCC == "DXT3") { return gpufmt::Format::BC2_UNORM_BLOCK; }
+        if(fourCC == "DXT4" || fourCC == "DXT5") { return gpufmt::Format::BC3_UNORM_BLOCK; }
+        if(fourCC == "ATI1" || fourCC == "BC4U") { return gpufmt::Format::BC4_UNORM_BLOCK; }
+        if(fourCC == "BC4S") { return gpufmt::Format::BC4_SNORM_BLOCK; }
+        if(fourCC == "ATI2" || fourCC == "BC5U") { return gpufmt::Format::BC5_UNORM_BLOCK; }
+        if(fourCC == "BC5S") { return gpufmt::Format::BC5_SNORM_BLOCK; }
+
+        // D3DFMT values stored in place of a fourCC
+        uint32_t d3dFormat = 0;
+        std::memcpy(&d3dFormat, fourCC.data(), sizeof(d3dFormat));
+        if(d3dFormat == 113) { return gpufmt::Format::R16G16B16A16_SFLOAT; }
+        if(d3dFormat == 116) { return gpufmt::Format::R32G32B32A32_SFLOAT; }
+
+        return gpufmt::Format::UNDEFINED;
+    }
+
+    if((pixelFormatFlags & kDdpfRgb) != 0 && rgbBitCount == 32)
+    {
+        const bool hasAlpha = (pixelFormatFlags & kDdpfAlphaPixels) != 0;
+
+        if(masks == std::array<uint32_t, 4>{0xff, 0xff00, 0xff0000, 0xff000000} && hasAlpha) { return gpufmt::Format::R8G8B8A8_UNORM; }
+        if(masks == std::array<uint32_t, 4>{0xff0000, 0xff00, 0xff, 0xff000000} && hasAlpha) { return gpufmt::Format::B8G8R8A8_UNORM; }
+        if(masks == std::array<uint32_t, 4>{0xff0000, 0xff00, 0xff, 0} && !hasAlpha) { return gpufmt::Format::B8G8R8X8_UNORM; }
+    }
+
+    // 16 bit formats stay packed, X1R5G5B5 is left to the importer because its unused bit would read as alpha
+    if((pixelFormatFlags & kDdpfRgb) != 0 && rgbBitCount == 16)
+    {
+        const bool hasAlpha = (pixelFormatFlags & kDdpfAlphaPixels) != 0;
+
+        if(masks == std::array<uint32_t, 4>{0xf800, 0x07e0, 0x001f, 0} && !hasAlpha) { return gpufmt::Format::R5G6B5_UNORM_PACK16; }
+        if(masks == std::array<uint32_t, 4>{0x7c00, 0x03e0, 0x001f, 0x8000} && hasAlpha) { return gpufmt::Format::A1R5G5B5_UNORM_PACK16; }
+        if(masks == std::array<uint32_t, 4>{0x0f00, 0x00f0, 0x000f, 0xf000} && hasAlpha) { return gpufmt::Format::A4R4G4B4_UNORM_PACK16; }
+    }
+
+    return gpufmt::Format::UNDEFINED;
+}
+
+bool describeDds(std::span<const std::byte> file, cputex::TextureParams& params, size_t& payloadOffset)
+{
+    uint32_t height = 0;
+    uint32_t width = 0;
+    uint32_t depth = 0;
+    uint32_t mips = 0;
+    uint32_t pixelFormatFlags = 0;
+    std::array<char, 4> fourCC{};
+    uint32_t rgbBitCount = 0;
+    std::array<uint32_t, 4> masks{};
+    uint32_t caps2 = 0;
+
+    if(!readValue(file, 12, height) || !readValue(file, 16, width) || !readValue(file, 24, depth) || !readValue(file, 28, mips) ||
+       !readValue(file, 80, pixelFormatFlags) || !readValue(file, 84, fourCC) || !readValue(file, 88, rgbBitCount) ||
+       !readValue(file, 92, masks) || !readValue(file, 112, caps2))
+    {
+        return false;
+    }
+
+    params.extent = cputex::Extent{(int32_t)width, (int32_t)height, 1};
+    params.mips = (cputex::CountType)std::max<uint32_t>(mips, 1);
+    params.dimension = cputex::TextureDimension::Texture2D;
+    payloadOffset = 128;
+
+    const std::string_view fourCCString(fourCC.data(), fourCC.size());
+
+    if((pixelFormatFlags & kDdpfFourCC) != 0 && fourCCString == "DX10")
+    {
+        uint32_t dxgiFormat = 0;
+        uint32_t resourceDimension = 0;
+        uint32_t miscFlag = 0;
+        uint32_t arraySize = 0;
+        if(!readValue(file, 128, dxgiFormat) || !readValue(file, 132, resourceDimension) || !readValue(file, 136, miscFlag) ||
+           !readValue(file, 140, arraySize))
+        {
+            return false;
+        }
+
+        params.format = dxgiToFormat(dxgiFormat);
+        params.arraySize = (cputex::CountType)std::max<uint32_t>(arraySize, 1);
+        payloadOffset = 148;
+
+        if(resourceDimension == kDx10ResourceDimensionTexture1D)
+        {
+            params.dimension = cputex::TextureDimension::Texture1D;
+        }
+        else if(resourceDimension == kDx10ResourceDimensionTexture3D)
+        {
+            params.dimension = cputex::TextureDimension::Texture3D;
+            params.extent.z = (int32_t)std::max<uint32_t>(depth, 1);
+        }
+        else if((miscFlag & kDx10MiscTextureCube) != 0)
+        {
+            params.dimension = cputex::TextureDimension::TextureCube;
+            params.faces = 6;
+        }
+    }
+    else
+    {
+        params.format = legacyDdsToFormat(pixelFormatFlags, fourCCString, rgbBitCount, masks);
+
+        if((caps2 & kDdsCaps2Volume) != 0)
+        {
+            params.dimension = cputex::TextureDimension::Texture3D;
+            params.extent.z = (int32_t)std::max<uint32_t>(depth, 1);
+        }
+        else if((caps2 & kDdsCaps2Cubemap) != 0)
+        {
+            // Cube maps with missing faces have no cputex equivalent
+            if((caps2 & kDdsCaps2CubemapAllFaces) != kDdsCaps2CubemapAllFaces) { return false; }
+
+            params.dimension = cputex::TextureDimension::TextureCube;
+            params.faces = 6;
+        }
+    }
+
+    return params.format != gpufmt::Format::UNDEFINED;
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_KTX
+constexpr std::array<uint8_t, 12> kKtxIdentifier = {0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n'};
+constexpr uint32_t kKtxEndianness = 0x04030201;
+
+gpufmt::Format glInternalFormatToFormat(uint32_t glInternalFormat)
+{
+    switch(glInternalFormat)
+    {
+    case 0x8058: return gpufmt::Format::R8G8B8A8_UNORM;       // GL_RGBA8
+    case 0x8C43: return gpufmt::Format::R8G8B8A8_SRGB;        // GL_SRGB8_ALPHA8
+    case 0x881A: return gpufmt::Format::R16G16B16A16_SFLOAT;  // GL_RGBA16F
+    case 0x8814: return gpufmt::Format::R32G32B32A32_SFLOAT;  // GL_RGBA32F
+    case 0x83F1: return gpufmt::Format::BC1_RGBA_UNORM_BLOCK; // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+    case 0x83F2: return gpufmt::Format::BC2_UNORM_BLOCK;      // GL_COMPRESSED_RGBA_S3TC_DXT3_EXT
+    case 0x83F3: return gpufmt::Format::BC3_UNORM_BLOCK;      // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+    case 0x8E8C: return gpufmt::Format::BC7_UNORM_BLOCK;      // GL_COMPRESSED_RGBA_BPTC_UNORM
+    case 0x8E8D: return gpufmt::Format::BC7_SRGB_BLOCK;       // GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+    default: return gpufmt::Format::UNDEFINED;
+    }
+}
+
+// Packed 16 bit internal formats are stored in whatever packing the file's type and format say
+gpufmt::Format glPackedTypeToFormat(uint32_t glType, uint32_t glFormat)
+{
+    constexpr uint32_t kGlRgb = 0x1907;
+    constexpr uint32_t kGlRgba = 0x1908;
+    constexpr uint32_t kGlBgra = 0x80E1;
+
+    switch(glType)
+    {
+    case 0x8363: return (glFormat == kGlRgb) ? gpufmt::Format::R5G6B5_UNORM_PACK16 : gpufmt::Format::UNDEFINED;    // GL_UNSIGNED_SHORT_5_6_5
+    case 0x8364: return (glFormat == kGlRgb) ? gpufmt::Format::B5G6R5_UNORM_PACK16 : gpufmt::Format::UNDEFINED;    // GL_UNSIGNED_SHORT_5_6_5_REV
+    case 0x8034: return (glFormat == kGlRgba) ? gpufmt::Format::R5G5B5A1_UNORM_PACK16 : gpufmt::Format::UNDEFINED; // GL_UNSIGNED_SHORT_5_5_5_1
+    case 0x8366: return (glFormat == kGlBgra) ? gpufmt::Format::A1R5G5B5_UNORM_PACK16 : gpufmt::Format::UNDEFINED; // GL_UNSIGNED_SHORT_1_5_5_5_REV
+    case 0x8033: return (glFormat == kGlRgba) ? gpufmt::Format::R4G4B4A4_UNORM_PACK16 : gpufmt::Format::UNDEFINED; // GL_UNSIGNED_SHORT_4_4_4_4
+    case 0x8365: return (glFormat == kGlBgra) ? gpufmt::Format::A4R4G4B4_UNORM_PACK16 : gpufmt::Format::UNDEFINED; // GL_UNSIGNED_SHORT_4_4_4_4_REV
+    default: return gpufmt::Format::UNDEFINED;
+    }
+}
+
+bool isGlPackedInternalFormat(uint32_t glInternalFormat)
+{
+    // GL_RGB565, GL_RGB5_A1, GL_RGBA4
+    return glInternalFormat == 0x8D62 || glInternalFormat == 0x8057 || glInternalFormat == 0x8056;
+}
+
+bool describeKtx(std::span<const std::byte> file, cputex::TextureParams& params, size_t& payloadOffset)
+{
+    uint32_t endianness = 0;
+    uint32_t glType = 0;
+    uint32_t glFormat = 0;
+    uint32_t glInternalFormat = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t depth = 0;
+    uint32_t arrayElements = 0;
+    uint32_t faces = 0;
+    uint32_t mips = 0;
+    uint32_t keyValueBytes = 0;
+
+    if(!readValue(file, 12, endianness) || !readValue(file, 16, glType) || !readValue(file, 24, glFormat) ||
+       !readValue(file, 28, glInternalFormat) || !readValue(file, 36, width) || !readValue(file, 40, height) ||
+       !readValue(file, 44, depth) || !readValue(file, 48, arrayElements) || !readValue(file, 52, faces) ||
+       !readValue(file, 56, mips) || !readValue(file, 60, keyValueBytes))
+    {
+        return false;
+    }
+
+    // Big endian files would need every value swapped
+    if(endianness != kKtxEndianness) { return false; }
+    if(depth > 1 || arrayElements > 1 || faces > 1 || mips > 1) { return false; }
+
+    uint32_t imageSize = 0;
+    const size_t imageSizeOffset = 64 + (size_t)keyValueBytes;
+    if(!readValue(file, imageSizeOffset, imageSize)) { return false; }
+
+    params.format = isGlPackedInternalFormat(glInternalFormat) ? glPackedTypeToFormat(glType, glFormat) : glInternalFormatToFormat(glInternalFormat);
+    params.dimension = (height == 0) ? cputex::TextureDimension::Texture1D : cputex::TextureDimension::Texture2D;
+    params.extent = cputex::Extent{(int32_t)width, (int32_t)std::max<uint32_t>(height, 1), 1};
+    payloadOffset = imageSizeOffset + 4;
+
+    // Rows are padded to 4 bytes, which only matters for formats whose rows are not already a multiple of 4.
+    // Those fail the layout check, the image size catches the rest.
+    return params.format != gpufmt::Format::UNDEFINED && imageSize <= file.size() - std::min(payloadOffset, file.size());
+}
+#endif
+}
+
+std::optional<MappedTexture> mapTexture(const std::filesystem::path& filePath, int targetMaxExtent)
+{
+    MappedTexture mappedTexture;
+    if(!mappedTexture.mMappedFile.open(filePath)) { return std::nullopt; }
+
+    const std::span<const std::byte> file = mappedTexture.mMappedFile.data();
+
+    cputex::TextureParams params;
+    size_t payloadOffset = 0;
+    bool described = false;
+
+#ifdef TEXIMP_ENABLE_DDS
+    if(file.size() >= 4 && std::memcmp(file.data(), "DDS ", 4) == 0)
+    {
+        described = describeDds(file, params, payloadOffset);
+    }
+#endif
+
+#ifdef TEXIMP_ENABLE_KTX
+    if(file.size() >= kKtxIdentifier.size() && std::memcmp(file.data(), kKtxIdentifier.data(), kKtxIdentifier.size()) == 0)
+    {
+        described = describeKtx(file, params, payloadOffset);
+    }
+#endif
+
+    if(!described || payloadOffset > file.size()) { return std::nullopt; }
+    if(params.extent.x <= 0 || params.extent.y <= 0 || params.extent.z <= 0) { return std::nullopt; }
+    if(params.mips < 1 || params.mips > kMaxMips || params.arraySize < 1 || params.arraySize > kMaxArraySize) { return std::nullopt; }
+
+    const gpufmt::FormatInfo& formatInfo = gpufmt::formatInfo(params.format);
+    if(formatInfo.blockByteSize == 0) { return std::nullopt; }
+
+    // Trailing bytes after the last subresource are allowed, some writers pad files
+    const size_t textureSize = packedTextureSize(params, formatInfo);
+    if(textureSize > file.size() - payloadOffset) { return std::nullopt; }
+
+    mappedTexture.mTexture = cputex::TextureView(params, file.subspan(payloadOffset, textureSize));
+    if(!matchesCputexLayout(mappedTexture.mTexture, params, formatInfo)) { return std::nullopt; }
+
+    // Arrays and cube maps repeat the mip chain per subresource, dropping mips would leave gaps in the view
+    const cputex::CountType firstMip = (params.arraySize == 1 && params.faces == 1) ? previewMip(params.extent, params.mips, targetMaxExtent) : 0;
+
+    if(firstMip > 0)
+    {
+        size_t skippedSize = 0;
+        for(cputex::CountType mip = 0; mip < firstMip; ++mip)
+        {
+            skippedSize += packedSurfaceSize(params, formatInfo, mip);
+        }
+
+        cputex::TextureParams previewParams = params;
+        previewParams.extent = cputex::calculateMipExtent(params.extent, firstMip);
+        previewParams.mips = params.mips - firstMip;
+
+        // The tail of a packed chain is itself a packed chain, but cputex gets the final say like it did above
+        const cputex::TextureView previewTexture(previewParams, file.subspan(payloadOffset + skippedSize, textureSize - skippedSize));
+        if(matchesCputexLayout(previewTexture, previewParams, formatInfo))
+        {
+            mappedTexture.mTexture = previewTexture;
+        }
+    }
+
+    return mappedTexture;
+}
+
+cputex::CountType previewMip(const cputex::Extent& extent, cputex::CountType mips, int targetMaxExtent)
+{
+    if(targetMaxExtent <= 0) { return 0; }
+
+    cputex::CountType mip = 0;
+
+    while(mip + 1 < mips)
+    {
+        const cputex::Extent nextExtent = cputex::calculateMipExtent(extent, mip + 1);
+        if(std::max({nextExtent.x, nextExtent.y, nextExtent.z}) < targetMaxExtent) { break; }
+
+        ++mip;
+    }
+
+    return mip;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "mapped_file.h"
+
+#include <cputex/definitions.h>
+
+#include <filesystem>
+#include <optional>
+
+// A texture whose data is used in place from a memory mapped file instead of being copied into a texture
+// allocator. The view stays valid for as long as this object, which owns the mapping, is alive.
+class MappedTexture
+{
+public:
+    const cputex::TextureView& texture() const { return mTexture; }
+
+private:
+    friend std::optional<MappedTexture> mapTexture(const std::filesystem::path& filePath, int targetMaxExtent);
+
+    MappedFile mMappedFile;
+    cputex::TextureView mTexture;
+};
+
+// Maps DDS and KTX files whose payload is already laid out exactly as cputex lays out a texture: subresources
+// tightly packed, ordered by array slice, then face, then mip. That covers block compressed and linear formats
+// from DDS, and KTX files with a single subresource. KTX stores mips first and prefixes every mip with its size,
+// so anything with more than one subresource never matches.
+//
+// When targetMaxExtent is positive, textures with a single array slice and face start at previewMip instead of
+// mip 0. The larger mips are left out of the view, so a preview never touches their pages.
+//
+// Returns nullopt for every other file, including formats this does not know how to describe, in which case the
+// caller imports the file as usual.
+std::optional<MappedTexture> mapTexture(const std::filesystem::path& filePath, int targetMaxExtent = 0);
+
+// The mip a preview at most targetMaxExtent pixels along its longest side is made from: the smallest one that is
+// still at least that large, so the preview is only ever scaled down, or mip 0 when the texture is smaller already
+cputex::CountType previewMip(const cputex::Extent& extent, cputex::CountType mips, int targetMaxExtent);
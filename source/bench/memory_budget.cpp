@@ -0,0 +1,56 @@
+#include "memory_budget.h"
+
+#include <algorithm>
+
+MemoryBudget::MemoryBudget(uint64_t budgetBytes)
+    : mBudgetBytes(budgetBytes)
+{}
+
+void MemoryBudget::acquire(uint64_t bytes)
+{
+    bytes = std::min(bytes, mBudgetBytes);
+
+    std::unique_lock lock(mMutex);
+
+    const uint64_t ticket = mNextTicket++;
+
+    mCondition.wait(lock, [this, ticket, bytes]()
+        {
+            if(ticket != mServingTicket) { return false; }
+
+            return mInFlightBytes <= mBudgetBytes - bytes;
+        });
+
+    ++mServingTicket;
+    mInFlightBytes += bytes;
+    mPeakBytes = std::max(mPeakBytes, mInFlightBytes);
+
+    lock.unlock();
+
+    // The next ticket may already fit
+    mCondition.notify_all();
+}
+
+void MemoryBudget::release(uint64_t bytes)
+{
+    bytes = std::min(bytes, mBudgetBytes);
+
+    {
+        std::scoped_lock lock(mMutex);
+        mInFlightBytes -= std::min(bytes, mInFlightBytes);
+    }
+
+    mCondition.notify_all();
+}
+
+uint64_t MemoryBudget::inFlightBytes() const
+{
+    std::scoped_lock lock(mMutex);
+    return mInFlightBytes;
+}
+
+uint64_t MemoryBudget::peakBytes() const
+{
+    std::scoped_lock lock(mMutex);
+    return mPeakBytes;
+}
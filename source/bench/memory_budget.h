@@ -0,0 +1,37 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Limits the memory that concurrent imports are expected to use at the same time. Each import acquires its
+// estimated decoded size before it starts and releases it when its texture is freed.
+//
+// Requests are admitted strictly in the order they arrive. A large request that does not fit yet holds back
+// the smaller ones behind it instead of being overtaken by them forever. A request larger than the whole
+// budget is admitted once nothing else is in flight and counts as the whole budget.
+class MemoryBudget
+{
+public:
+    explicit MemoryBudget(uint64_t budgetBytes);
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    void acquire(uint64_t bytes);
+    void release(uint64_t bytes);
+
+    uint64_t budgetBytes() const { return mBudgetBytes; }
+    uint64_t inFlightBytes() const;
+    uint64_t peakBytes() const;
+
+private:
+    const uint64_t mBudgetBytes;
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    uint64_t mInFlightBytes = 0;
+    uint64_t mPeakBytes = 0;
+    uint64_t mNextTicket = 0;
+    uint64_t mServingTicket = 0;
+};
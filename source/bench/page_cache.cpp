@@ -0,0 +1,47 @@
+#include "page_cache.h"
+
+#include <array>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+bool evictFromPageCache(const std::filesystem::path& filePath)
+{
+#ifdef _WIN32
+    // There is no per file equivalent of posix_fadvise on Windows. Flushing the standby list requires
+    // administrator rights and affects the whole system.
+    return false;
+#else
+    const int fd = ::open(filePath.c_str(), O_RDONLY);
+    if(fd < 0) { return false; }
+
+    // The files are only ever read, so all of their pages are clean and DONTNEED drops them immediately.
+    const int result = ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+
+    return result == 0;
+#endif
+}
+
+bool loadIntoPageCache(const std::filesystem::path& filePath)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    if(!file) { return false; }
+
+    std::array<char, 64 * 1024> buffer;
+    while(file.read(buffer.data(), buffer.size()) || file.gcount() > 0) {}
+
+    return true;
+}
+
+bool pageCacheEvictionSupported()
+{
+#ifdef _WIN32
+    return false;
+#else
+    return true;
+#endif
+}
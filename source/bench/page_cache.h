@@ -0,0 +1,12 @@
+#pragma once
+
+#include <filesystem>
+
+// Drops the cached pages of a file so the next read has to go to the storage device.
+// Returns false if the file could not be opened or the platform has no way to do this.
+bool evictFromPageCache(const std::filesystem::path& filePath);
+
+// Reads the whole file and discards the contents, leaving it resident in the page cache.
+bool loadIntoPageCache(const std::filesystem::path& filePath);
+
+bool pageCacheEvictionSupported();
@@ -0,0 +1,165 @@
+#include "palette_texture.h"
+
+#include <gpufmt/format.h>
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+namespace
+{
+constexpr int kPaletteSize = 256;
+
+bool isPalettizable(gpufmt::Format format)
+{
+    switch(format)
+    {
+    case gpufmt::Format::R8G8B8A8_UNORM:
+    case gpufmt::Format::R8G8B8A8_SRGB:
+    case gpufmt::Format::B8G8R8A8_UNORM:
+    case gpufmt::Format::B8G8R8A8_SRGB:
+    case gpufmt::Format::B8G8R8X8_UNORM:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Open addressing map from a 32 bit color to its palette index. Four times the palette size keeps probe
+// sequences short right up to the 257th color that ends the search.
+class ColorIndexMap
+{
+public:
+    ColorIndexMap()
+    {
+        mSlots.fill(kEmpty);
+    }
+
+    // Returns -1 once the palette is full and the color is not in it
+    int findOrAdd(uint32_t color)
+    {
+        size_t slot = (color * 0x9e3779b1u) >> (32 - kSlotBits);
+
+        while(true)
+        {
+            const uint64_t entry = mSlots[slot];
+
+            if(entry == kEmpty)
+            {
+                if(mColorCount == kPaletteSize) { return -1; }
+
+                mColors[(size_t)mColorCount] = color;
+                mSlots[slot] = ((uint64_t)mColorCount << 32) | color;
+                return mColorCount++;
+            }
+
+            if((uint32_t)entry == color) { return (int)(entry >> 32); }
+
+            slot = (slot + 1) & (kSlotCount - 1);
+        }
+    }
+
+    int colorCount() const { return mColorCount; }
+    const std::array<uint32_t, kPaletteSize>& colors() const { return mColors; }
+
+private:
+    static constexpr int kSlotBits = 10;
+    static constexpr size_t kSlotCount = size_t(1) << kSlotBits;
+    // Indices are at most 255, so no real entry has bits set above 40
+    static constexpr uint64_t kEmpty = ~uint64_t(0);
+
+    std::array<uint64_t, kSlotCount> mSlots;
+    std::array<uint32_t, kPaletteSize> mColors = {};
+    int mColorCount = 0;
+};
+
+size_t surfaceOffset(const cputex::TextureView& texture, std::span<const std::byte> surface)
+{
+    return (size_t)(surface.data() - texture.getData().data());
+}
+}
+
+std::optional<PalettizedTexture> palettize(const cputex::TextureView& texture)
+{
+    if(!isPalettizable(texture.format())) { return std::nullopt; }
+
+    cputex::TextureParams indexParams;
+    indexParams.format = gpufmt::Format::R8_UINT;
+    indexParams.dimension = texture.dimension();
+    indexParams.extent = texture.extent();
+    indexParams.arraySize = texture.arraySize();
+    indexParams.faces = texture.faces();
+    indexParams.mips = texture.mips();
+
+    PalettizedTexture palettized;
+    palettized.indices = cputex::UniqueTexture(indexParams);
+
+    const cputex::TextureView indexView = palettized.indices;
+    const std::span<std::byte> indexData = palettized.indices.accessData();
+
+    ColorIndexMap colorIndices;
+
+    for(cputex::CountType arraySlice = 0; arraySlice < texture.arraySize(); ++arraySlice)
+    {
+        for(cputex::CountType face = 0; face < texture.faces(); ++face)
+        {
+            for(cputex::CountType mip = 0; mip < texture.mips(); ++mip)
+            {
+                const std::span<const std::byte> surface = texture.getMipSurfaceData(arraySlice, face, mip);
+                const std::span<const std::byte> indexSurface = indexView.getMipSurfaceData(arraySlice, face, mip);
+                uint8_t* const indices = (uint8_t*)indexData.data() + surfaceOffset(indexView, indexSurface);
+
+                const size_t pixelCount = surface.size() / 4;
+                if(indexSurface.size() != pixelCount) { return std::nullopt; }
+
+                // Indexed images mostly come in runs of one color, most lookups stop here
+                uint32_t previousColor = 0;
+                int previousIndex = -1;
+
+                for(size_t i = 0; i < pixelCount; ++i)
+                {
+                    uint32_t color;
+                    std::memcpy(&color, surface.data() + i * 4, sizeof(color));
+
+                    if(color != previousColor || previousIndex < 0)
+                    {
+                        previousIndex = colorIndices.findOrAdd(color);
+                        if(previousIndex < 0) { return std::nullopt; }
+
+                        previousColor = color;
+                    }
+
+                    indices[i] = (uint8_t)previousIndex;
+                }
+            }
+        }
+    }
+
+    cputex::TextureParams paletteParams;
+    paletteParams.format = texture.format();
+    paletteParams.dimension = cputex::TextureDimension::Texture2D;
+    paletteParams.extent = cputex::Extent{kPaletteSize, 1, 1};
+
+    palettized.palette = cputex::UniqueTexture(paletteParams);
+    palettized.colorCount = colorIndices.colorCount();
+
+    const std::span<std::byte> paletteData = palettized.palette.accessData();
+    std::memset(paletteData.data(), 0, paletteData.size());
+    std::memcpy(paletteData.data(), colorIndices.colors().data(), (size_t)palettized.colorCount * sizeof(uint32_t));
+
+    return palettized;
+}
+
+std::array<std::byte, 4> samplePalettized(const PalettizedTexture& texture, cputex::CountType arraySlice, cputex::CountType face,
+                                          cputex::CountType mip, int x, int y, int z)
+{
+    const cputex::TextureView indexView = texture.indices;
+    const cputex::Extent mipExtent = cputex::calculateMipExtent(indexView.extent(), mip);
+    const std::span<const uint8_t> indices = indexView.getMipSurfaceData<uint8_t>(arraySlice, face, mip);
+
+    const size_t index = indices[((size_t)z * mipExtent.y + (size_t)y) * mipExtent.x + (size_t)x];
+
+    std::array<std::byte, 4> texel;
+    std::memcpy(texel.data(), texture.palette.getData().data() + index * 4, texel.size());
+    return texel;
+}
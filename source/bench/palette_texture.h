@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cputex/definitions.h>
+
+#include <array>
+#include <cstddef>
+#include <optional>
+
+// A color texture stored as one R8_UINT palette index per pixel plus a 256x1 palette texture in the original
+// format. Indexed images (paletted BMP, TGA and PNG) are expanded to 4 bytes per pixel by the importers, keeping
+// them as indices is a quarter of the memory and upload bandwidth.
+struct PalettizedTexture
+{
+    // Same dimension, extent, array size, faces and mips as the original texture
+    cputex::UniqueTexture indices;
+    // Entries past colorCount are zero
+    cputex::UniqueTexture palette;
+    int colorCount = 0;
+};
+
+// Recovers the palette of a texture in a 4 byte 8 bit color format. Returns nullopt for other formats and for
+// textures with more than 256 distinct colors across all of their subresources.
+std::optional<PalettizedTexture> palettize(const cputex::TextureView& texture);
+
+// Reference lookup of one texel, what a shader does with a Load from the index texture followed by a Load from
+// the palette. Returns the texel's bytes in the palette's format.
+std::array<std::byte, 4> samplePalettized(const PalettizedTexture& texture, cputex::CountType arraySlice, cputex::CountType face,
+                                          cputex::CountType mip, int x, int y, int z = 0);
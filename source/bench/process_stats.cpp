@@ -0,0 +1,82 @@
+#include "process_stats.h"
+
+#include <cstdint>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <filesystem>
+#include <fstream>
+#endif
+
+std::chrono::nanoseconds processCpuTime()
+{
+#ifdef _WIN32
+    FILETIME creationTime;
+    FILETIME exitTime;
+    FILETIME kernelTime;
+    FILETIME userTime;
+    if(!GetProcessTimes(GetCurrentProcess(), &creationTime, &exitTime, &kernelTime, &userTime)) { return {}; }
+
+    const auto toTicks = [](const FILETIME& fileTime)
+    {
+        return ((uint64_t)fileTime.dwHighDateTime << 32) | (uint64_t)fileTime.dwLowDateTime;
+    };
+
+    // FILETIME is measured in 100 nanosecond intervals
+    return std::chrono::nanoseconds((toTicks(kernelTime) + toTicks(userTime)) * 100);
+#else
+    timespec time;
+    if(clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0) { return {}; }
+
+    return std::chrono::seconds(time.tv_sec) + std::chrono::nanoseconds(time.tv_nsec);
+#endif
+}
+
+uint64_t processResidentBytes()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) { return 0; }
+
+    return counters.WorkingSetSize;
+#elif defined(__linux__)
+    // statm reports sizes in pages: total program size followed by the resident set
+    std::ifstream statm("/proc/self/statm");
+    uint64_t totalPages = 0;
+    uint64_t residentPages = 0;
+    if(!(statm >> totalPages >> residentPages)) { return 0; }
+
+    return residentPages * (uint64_t)sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
+
+int processHandleCount()
+{
+#if defined(_WIN32)
+    DWORD handleCount = 0;
+    if(!GetProcessHandleCount(GetCurrentProcess(), &handleCount)) { return -1; }
+
+    return (int)handleCount;
+#elif defined(__linux__)
+    std::error_code ec;
+    int handleCount = 0;
+    for(std::filesystem::directory_iterator itr("/proc/self/fd", ec), end; !ec && itr != end; itr.increment(ec))
+    {
+        ++handleCount;
+    }
+
+    // The iterator holds a descriptor of its own while it walks the directory
+    return ec ? -1 : handleCount - 1;
+#else
+    return -1;
+#endif
+}
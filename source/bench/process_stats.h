@@ -0,0 +1,13 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// User plus kernel time consumed by all threads of the current process.
+std::chrono::nanoseconds processCpuTime();
+
+// Resident set size on Linux, working set size on Windows. Returns 0 where unsupported.
+uint64_t processResidentBytes();
+
+// Open file descriptors on Linux, kernel object handles on Windows. Returns -1 where unsupported.
+int processHandleCount();
@@ -0,0 +1,287 @@
+#include "read_ahead.h"
+
+#include <algorithm>
+#include <fstream>
+
+#ifdef TEXIMP_BENCH_HAS_IO_URING
+#include <fcntl.h>
+#include <liburing.h>
+#endif
+
+namespace
+{
+constexpr size_t kReadChunkSize = 256 * 1024;
+}
+
+ReadAhead::ReadAhead(std::vector<std::filesystem::path> filePaths, const ReadAheadOptions& options)
+    : mFilePaths(std::move(filePaths))
+    , mOptions(options)
+{
+    mFileSizes.reserve(mFilePaths.size());
+
+    for(const std::filesystem::path& filePath : mFilePaths)
+    {
+        std::error_code ec;
+        const uintmax_t fileSize = std::filesystem::file_size(filePath, ec);
+        mFileSizes.push_back(ec ? 0 : fileSize);
+    }
+
+    mFileStates.resize(mFilePaths.size(), FileState::Pending);
+
+    mThread = std::jthread([this](std::stop_token stopToken)
+        {
+#ifdef TEXIMP_BENCH_HAS_IO_URING
+            if(runIoUring(stopToken)) { return; }
+#endif
+            runThreadPool(stopToken);
+        });
+}
+
+ReadAhead::~ReadAhead()
+{
+    mThread.request_stop();
+    mCondition.notify_all();
+
+    if(mThread.joinable())
+    {
+        mThread.join();
+    }
+
+    // Joining the pool waits for reads that are still running
+    mThreadPool.reset();
+}
+
+void ReadAhead::waitUntilRead(size_t fileIndex)
+{
+    std::unique_lock lock(mMutex);
+    mCondition.wait(lock, [this, fileIndex]() { return mFileStates[fileIndex] >= FileState::Read; });
+}
+
+void ReadAhead::release(size_t fileIndex)
+{
+    {
+        std::scoped_lock lock(mMutex);
+        if(mFileStates[fileIndex] != FileState::Read) { return; }
+
+        mFileStates[fileIndex] = FileState::Released;
+        --mFilesInFlight;
+        mBytesInFlight -= mFileSizes[fileIndex];
+    }
+
+    mCondition.notify_all();
+}
+
+uint64_t ReadAhead::bytesRead() const
+{
+    std::scoped_lock lock(mMutex);
+    return mBytesRead;
+}
+
+uint64_t ReadAhead::peakBytesInFlight() const
+{
+    std::scoped_lock lock(mMutex);
+    return mPeakBytesInFlight;
+}
+
+bool ReadAhead::canStartNextFile() const
+{
+    if(mNextFile >= mFilePaths.size()) { return false; }
+    if(mFilesInFlight >= mOptions.maxFilesInFlight) { return false; }
+
+    // Always let one file through, otherwise a file larger than the budget would never be read
+    return mFilesInFlight == 0 || mBytesInFlight + mFileSizes[mNextFile] <= mOptions.maxBytesInFlight;
+}
+
+void ReadAhead::startFile(size_t fileIndex)
+{
+    mFileStates[fileIndex] = FileState::Reading;
+    ++mFilesInFlight;
+    mBytesInFlight += mFileSizes[fileIndex];
+    mPeakBytesInFlight = std::max(mPeakBytesInFlight, mBytesInFlight);
+}
+
+void ReadAhead::finishFile(size_t fileIndex, uint64_t bytesRead)
+{
+    {
+        std::scoped_lock lock(mMutex);
+        mFileStates[fileIndex] = FileState::Read;
+        mBytesRead += bytesRead;
+    }
+
+    mCondition.notify_all();
+}
+
+void ReadAhead::runThreadPool(std::stop_token stopToken)
+{
+    mThreadPool = std::make_unique<ThreadPool>(mOptions.fallbackThreadCount);
+
+    while(true)
+    {
+        size_t fileIndex = 0;
+
+        {
+            std::unique_lock lock(mMutex);
+
+            // wait still returns true on a stop if a file could start, and that file is not wanted any more
+            if(!mCondition.wait(lock, stopToken, [this]() { return canStartNextFile(); }) || stopToken.stop_requested()) { return; }
+
+            fileIndex = mNextFile++;
+            startFile(fileIndex);
+        }
+
+        mThreadPool->post([this, fileIndex, stopToken]()
+            {
+                std::ifstream file(mFilePaths[fileIndex], std::ios::binary);
+                std::vector<char> buffer(kReadChunkSize);
+                uint64_t bytesRead = 0;
+
+                while(!stopToken.stop_requested() && (file.read(buffer.data(), buffer.size()) || file.gcount() > 0))
+                {
+                    bytesRead += (uint64_t)file.gcount();
+                }
+
+                finishFile(fileIndex, bytesRead);
+            });
+    }
+}
+
+#ifdef TEXIMP_BENCH_HAS_IO_URING
+bool ReadAhead::runIoUring(std::stop_token stopToken)
+{
+    // Every file goes through open, a chain of reads and close. Each slot tracks one file through those steps
+    // and owns the buffer its reads land in.
+    enum class Operation
+    {
+        Open,
+        Read,
+        Close
+    };
+
+    struct Slot
+    {
+        size_t fileIndex = 0;
+        Operation operation = Operation::Open;
+        int fd = -1;
+        uint64_t offset = 0;
+        std::vector<char> buffer;
+        bool busy = false;
+    };
+
+    io_uring ring;
+    const unsigned queueDepth = (unsigned)std::max(mOptions.maxFilesInFlight, 1);
+
+    // Not available on kernels before 5.1, and commonly blocked by container seccomp profiles
+    if(io_uring_queue_init(queueDepth, &ring, 0) < 0) { return false; }
+
+    mUsingIoUring = true;
+
+    std::vector<Slot> slots(queueDepth);
+    for(Slot& slot : slots)
+    {
+        slot.buffer.resize(kReadChunkSize);
+    }
+
+    int operationsInFlight = 0;
+
+    const auto submitRead = [&ring](Slot& slot)
+    {
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+        slot.operation = Operation::Read;
+        io_uring_prep_read(sqe, slot.fd, slot.buffer.data(), (unsigned)slot.buffer.size(), slot.offset);
+        io_uring_sqe_set_data(sqe, &slot);
+    };
+
+    const auto submitClose = [&ring](Slot& slot)
+    {
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+        slot.operation = Operation::Close;
+        io_uring_prep_close(sqe, slot.fd);
+        io_uring_sqe_set_data(sqe, &slot);
+    };
+
+    while(true)
+    {
+        {
+            std::unique_lock lock(mMutex);
+
+            // With nothing in the ring there are no completions to wait for, only a release can make progress.
+            // Once stopping, the ring is drained so the slots' buffers outlive every read, but nothing new opens.
+            if(operationsInFlight == 0 &&
+               (stopToken.stop_requested() || !mCondition.wait(lock, stopToken, [this]() { return canStartNextFile(); })))
+            {
+                break;
+            }
+
+            for(Slot& slot : slots)
+            {
+                if(slot.busy || stopToken.stop_requested() || !canStartNextFile()) { continue; }
+
+                slot.fileIndex = mNextFile++;
+                slot.operation = Operation::Open;
+                slot.fd = -1;
+                slot.offset = 0;
+                slot.busy = true;
+                startFile(slot.fileIndex);
+
+                io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+                io_uring_prep_openat(sqe, AT_FDCWD, mFilePaths[slot.fileIndex].c_str(), O_RDONLY, 0);
+                io_uring_sqe_set_data(sqe, &slot);
+                ++operationsInFlight;
+            }
+        }
+
+        io_uring_submit(&ring);
+
+        io_uring_cqe* cqe = nullptr;
+        if(io_uring_wait_cqe(&ring, &cqe) < 0) { continue; }
+
+        // Drain every completion that is ready, not just the one that woke us up
+        do
+        {
+            Slot& slot = *(Slot*)io_uring_cqe_get_data(cqe);
+            const int result = cqe->res;
+            io_uring_cqe_seen(&ring, cqe);
+
+            switch(slot.operation)
+            {
+            case Operation::Open:
+                if(result < 0)
+                {
+                    --operationsInFlight;
+                    slot.busy = false;
+                    finishFile(slot.fileIndex, 0);
+                    break;
+                }
+
+                slot.fd = result;
+                submitRead(slot);
+                break;
+
+            case Operation::Read:
+                if(result > 0)
+                {
+                    slot.offset += result;
+                }
+
+                if(result > 0 && slot.offset < mFileSizes[slot.fileIndex] && !stopToken.stop_requested())
+                {
+                    submitRead(slot);
+                    break;
+                }
+
+                submitClose(slot);
+                break;
+
+            case Operation::Close:
+                --operationsInFlight;
+                slot.busy = false;
+                finishFile(slot.fileIndex, slot.offset);
+                break;
+            }
+        } while(io_uring_peek_cqe(&ring, &cqe) == 0);
+    }
+
+    io_uring_queue_exit(&ring);
+    return true;
+}
+#endif
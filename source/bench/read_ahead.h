@@ -0,0 +1,93 @@
+#pragma once
+
+#include "thread_pool.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+struct ReadAheadOptions
+{
+    // Files opened and being read at the same time
+    int maxFilesInFlight = 16;
+    // Bytes read ahead of the importer and not yet released. A file larger than this is still read, but only
+    // once nothing else is in flight.
+    uint64_t maxBytesInFlight = 64 * 1024 * 1024;
+    // Threads used when io_uring is not available
+    int fallbackThreadCount = 4;
+};
+
+// Reads a list of files, in order, ahead of the importer so that each one is already in the page cache when
+// importTexture opens it. Per file open/read/close latency is overlapped with decoding instead of being paid
+// serially by every import, which dominates when the files are small.
+//
+// Opens, reads and closes are submitted through io_uring where it is available, otherwise a thread pool reads
+// the files. Once stopping, no new file is opened, and files being read are closed without reading the rest. The
+// data read is discarded: importTexture only takes a path and reads the file again, this time from memory.
+class ReadAhead
+{
+public:
+    ReadAhead(std::vector<std::filesystem::path> filePaths, const ReadAheadOptions& options);
+    ~ReadAhead();
+
+    ReadAhead(const ReadAhead&) = delete;
+    ReadAhead& operator=(const ReadAhead&) = delete;
+
+    // Blocks until the file has been read, or has failed to read.
+    void waitUntilRead(size_t fileIndex);
+
+    // The importer is done with the file, it no longer counts against the in flight limits.
+    void release(size_t fileIndex);
+
+    bool usingIoUring() const { return mUsingIoUring.load(); }
+
+    // Bytes read from all files so far
+    uint64_t bytesRead() const;
+
+    // The most bytes in flight at any one time so far
+    uint64_t peakBytesInFlight() const;
+
+private:
+    enum class FileState : uint8_t
+    {
+        Pending,
+        Reading,
+        Read,
+        Released
+    };
+
+    // Must be called with mMutex held
+    bool canStartNextFile() const;
+    void startFile(size_t fileIndex);
+    void finishFile(size_t fileIndex, uint64_t bytesRead);
+
+    void runThreadPool(std::stop_token stopToken);
+#ifdef TEXIMP_BENCH_HAS_IO_URING
+    bool runIoUring(std::stop_token stopToken);
+#endif
+
+    std::vector<std::filesystem::path> mFilePaths;
+    std::vector<uint64_t> mFileSizes;
+    ReadAheadOptions mOptions;
+    std::atomic<bool> mUsingIoUring = false;
+
+    mutable std::mutex mMutex;
+    std::condition_variable_any mCondition;
+    std::vector<FileState> mFileStates;
+    size_t mNextFile = 0;
+    int mFilesInFlight = 0;
+    uint64_t mBytesInFlight = 0;
+    uint64_t mPeakBytesInFlight = 0;
+    uint64_t mBytesRead = 0;
+
+    std::unique_ptr<ThreadPool> mThreadPool;
+
+    // Declared last so the thread starts after, and is joined before, everything it uses
+    std::jthread mThread;
+};
@@ -0,0 +1,686 @@
+#include "staging_format.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+enum class ComponentType
+{
+    Unorm8,
+    Half,
+    Float
+};
+
+// Where each of R, G, B and A comes from in a source pixel, -1 when the format does not have it. Missing
+// color components read as 0, a missing alpha as 1.
+struct SourceLayout
+{
+    ComponentType componentType;
+    size_t pixelBytes;
+    std::array<int, 4> components;
+    bool srgb;
+};
+
+bool describeSource(gpufmt::Format format, SourceLayout& layout)
+{
+    switch(format)
+    {
+    case gpufmt::Format::R8_UNORM: layout = {ComponentType::Unorm8, 1, {0, -1, -1, -1}, false}; return true;
+    case gpufmt::Format::R8_SRGB: layout = {ComponentType::Unorm8, 1, {0, -1, -1, -1}, true}; return true;
+    case gpufmt::Format::R8G8_UNORM: layout = {ComponentType::Unorm8, 2, {0, 1, -1, -1}, false}; return true;
+    case gpufmt::Format::R8G8_SRGB: layout = {ComponentType::Unorm8, 2, {0, 1, -1, -1}, true}; return true;
+    case gpufmt::Format::R8G8B8_UNORM: layout = {ComponentType::Unorm8, 3, {0, 1, 2, -1}, false}; return true;
+    case gpufmt::Format::B8G8R8_UNORM: layout = {ComponentType::Unorm8, 3, {2, 1, 0, -1}, false}; return true;
+    case gpufmt::Format::R8G8B8A8_UNORM: layout = {ComponentType::Unorm8, 4, {0, 1, 2, 3}, false}; return true;
+    case gpufmt::Format::R8G8B8A8_SRGB: layout = {ComponentType::Unorm8, 4, {0, 1, 2, 3}, true}; return true;
+    case gpufmt::Format::B8G8R8A8_UNORM: layout = {ComponentType::Unorm8, 4, {2, 1, 0, 3}, false}; return true;
+    case gpufmt::Format::B8G8R8A8_SRGB: layout = {ComponentType::Unorm8, 4, {2, 1, 0, 3}, true}; return true;
+    case gpufmt::Format::B8G8R8X8_UNORM: layout = {ComponentType::Unorm8, 4, {2, 1, 0, -1}, false}; return true;
+    case gpufmt::Format::R16G16B16A16_SFLOAT: layout = {ComponentType::Half, 8, {0, 1, 2, 3}, false}; return true;
+    case gpufmt::Format::R32G32B32_SFLOAT: layout = {ComponentType::Float, 12, {0, 1, 2, -1}, false}; return true;
+    case gpufmt::Format::R32G32B32A32_SFLOAT: layout = {ComponentType::Float, 16, {0, 1, 2, 3}, false}; return true;
+    default: return false;
+    }
+}
+
+float srgbToLinear(float encoded)
+{
+    return (encoded <= 0.04045f) ? encoded / 12.92f : std::pow((encoded + 0.055f) / 1.055f, 2.4f);
+}
+
+// 8 bit components only have 256 possible values, converting them to half is a lookup
+struct Unorm8ToHalfTables
+{
+    std::array<uint16_t, 256> linear;
+    std::array<uint16_t, 256> srgb;
+};
+
+const Unorm8ToHalfTables& unorm8ToHalfTables()
+{
+    static const Unorm8ToHalfTables tables = []()
+    {
+        Unorm8ToHalfTables values;
+        for(size_t i = 0; i < 256; ++i)
+        {
+            values.linear[i] = floatToHalf((float)i / 255.0f);
+            values.srgb[i] = floatToHalf(srgbToLinear((float)i / 255.0f));
+        }
+        return values;
+    }();
+
+    return tables;
+}
+
+// Same for floats, used where pixels are filtered in linear space
+struct Unorm8ToFloatTables
+{
+    std::array<float, 256> linear;
+    std::array<float, 256> srgb;
+};
+
+const Unorm8ToFloatTables& unorm8ToFloatTables()
+{
+    static const Unorm8ToFloatTables tables = []()
+    {
+        Unorm8ToFloatTables values;
+        for(size_t i = 0; i < 256; ++i)
+        {
+            values.linear[i] = (float)i / 255.0f;
+            values.srgb[i] = srgbToLinear((float)i / 255.0f);
+        }
+        return values;
+    }();
+
+    return tables;
+}
+
+uint8_t floatToUnorm8(float value)
+{
+    // Also maps NaN to 0
+    return (uint8_t)(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+// Half and float sources are converted a block of pixels at a time, so halves are widened and narrowed by the
+// vector kernels and the blocks stay in L1
+constexpr size_t kFloatBlockPixels = 256;
+
+// Hands the pixels to storeBlock(firstPixel, pixelCount, rgba) as blocks of RGBA floats. The layout is resolved
+// outside of the pixel loop, missing components are filled in from constants.
+template<class StoreBlock>
+bool convertFloatPixels(const std::byte* source, size_t pixelCount, const SourceLayout& layout, StoreBlock&& storeBlock)
+{
+    if(layout.componentType == ComponentType::Unorm8) { return false; }
+
+    const bool half = (layout.componentType == ComponentType::Half);
+    const size_t componentCount = layout.pixelBytes / (half ? 2 : 4);
+    const std::array<int, 4> indices = layout.components;
+    // RGBA sources are used as they are loaded
+    const bool rgba = (indices == std::array<int, 4>{0, 1, 2, 3});
+
+    std::array<float, kFloatBlockPixels * 4> components;
+    std::array<float, kFloatBlockPixels * 4> pixels;
+
+    for(size_t firstPixel = 0; firstPixel < pixelCount; firstPixel += kFloatBlockPixels)
+    {
+        const size_t blockPixels = std::min(kFloatBlockPixels, pixelCount - firstPixel);
+        const std::span<const std::byte> blockSource(source + firstPixel * layout.pixelBytes, blockPixels * layout.pixelBytes);
+
+        if(half)
+        {
+            halvesToFloats(blockSource, std::span(components).first(blockPixels * componentCount));
+        }
+        else
+        {
+            std::memcpy(components.data(), blockSource.data(), blockSource.size());
+        }
+
+        if(rgba)
+        {
+            storeBlock(firstPixel, blockPixels, components.data());
+            continue;
+        }
+
+        for(size_t i = 0; i < blockPixels; ++i)
+        {
+            const float* const sourcePixel = components.data() + i * componentCount;
+            float* const pixel = pixels.data() + i * 4;
+
+            pixel[0] = (indices[0] >= 0) ? sourcePixel[indices[0]] : 0.0f;
+            pixel[1] = (indices[1] >= 0) ? sourcePixel[indices[1]] : 0.0f;
+            pixel[2] = (indices[2] >= 0) ? sourcePixel[indices[2]] : 0.0f;
+            pixel[3] = (indices[3] >= 0) ? sourcePixel[indices[3]] : 1.0f;
+        }
+
+        storeBlock(firstPixel, blockPixels, pixels.data());
+    }
+
+    return true;
+}
+
+// Every 8 bit value an n bit value widens to, by bit replication or by rounding x * 255 / (2^n - 1). The two
+// differ for 5 and 6 bits and importers use either.
+using ValueSet = std::array<uint64_t, 4>;
+
+ValueSet widenedValues(int bits)
+{
+    const uint32_t maxValue = (1u << bits) - 1;
+    ValueSet values = {};
+
+    for(uint32_t value = 0; value <= maxValue; ++value)
+    {
+        uint32_t replicated = 0;
+        for(int shift = 8 - bits; shift > -bits; shift -= bits)
+        {
+            replicated |= (shift >= 0) ? value << shift : value >> -shift;
+        }
+
+        const uint32_t rounded = (value * 255 + maxValue / 2) / maxValue;
+
+        values[replicated / 64] |= uint64_t(1) << (replicated % 64);
+        values[rounded / 64] |= uint64_t(1) << (rounded % 64);
+    }
+
+    return values;
+}
+
+constexpr std::array<int, 4> kTrackedBits = {1, 4, 5, 6};
+
+const std::array<ValueSet, 4>& trackedBitsValues()
+{
+    static const std::array<ValueSet, 4> values = {widenedValues(1), widenedValues(4), widenedValues(5), widenedValues(6)};
+    return values;
+}
+
+bool fits(const ChannelContent& content, size_t component, int bits)
+{
+    return (content.fitsBits[component] & (1u << (bits - 1))) != 0;
+}
+
+// The 16 bit format that holds the values the content was widened from, sampled within 1 LSB of the content. All
+// three have DXGI equivalents (B5G6R5, B5G5R5A1 and B4G4R4A4).
+gpufmt::Format packedFormatFor(const ChannelContent& content)
+{
+    const bool color5 = fits(content, 0, 5) && fits(content, 1, 5) && fits(content, 2, 5);
+
+    if(content.opaque && fits(content, 0, 5) && fits(content, 1, 6) && fits(content, 2, 5)) { return gpufmt::Format::R5G6B5_UNORM_PACK16; }
+    if(color5 && fits(content, 3, 1)) { return gpufmt::Format::A1R5G5B5_UNORM_PACK16; }
+    if(fits(content, 0, 4) && fits(content, 1, 4) && fits(content, 2, 4) && fits(content, 3, 4)) { return gpufmt::Format::A4R4G4B4_UNORM_PACK16; }
+
+    return gpufmt::Format::UNDEFINED;
+}
+
+// Inverse of both widenings
+template<int kBits>
+uint32_t quantize(uint8_t value)
+{
+    constexpr uint32_t kMaxValue = (1u << kBits) - 1;
+    return ((uint32_t)value * kMaxValue + 127) / 255;
+}
+
+template<class PackPixel>
+void packPixels(const uint8_t* sourcePixel, size_t pixelCount, const SourceLayout& layout, uint8_t* destination, PackPixel&& packPixel)
+{
+    const std::array<int, 4> indices = layout.components;
+
+    for(size_t i = 0; i < pixelCount; ++i, sourcePixel += layout.pixelBytes)
+    {
+        const uint16_t packed = packPixel(sourcePixel[indices[0]],
+                                          sourcePixel[indices[1]],
+                                          sourcePixel[indices[2]],
+                                          (indices[3] >= 0) ? sourcePixel[indices[3]] : (uint8_t)255);
+        std::memcpy(destination + i * 2, &packed, sizeof(packed));
+    }
+}
+}
+
+std::string_view toString(StagingFormat stagingFormat)
+{
+    switch(stagingFormat)
+    {
+    case StagingFormat::Native:
+        return "native";
+    case StagingFormat::Rgba8:
+        return "rgba8";
+    case StagingFormat::Rgba16Float:
+        return "rgba16f";
+    default:
+        return "unknown";
+    }
+}
+
+gpufmt::Format stagedFormat(gpufmt::Format sourceFormat, StagingFormat stagingFormat)
+{
+    if(stagingFormat == StagingFormat::Native || gpufmt::formatInfo(sourceFormat).blockCompressed) { return sourceFormat; }
+
+    SourceLayout layout;
+    if(!describeSource(sourceFormat, layout)) { return gpufmt::Format::UNDEFINED; }
+
+    if(stagingFormat == StagingFormat::Rgba8)
+    {
+        return layout.srgb ? gpufmt::Format::R8G8B8A8_SRGB : gpufmt::Format::R8G8B8A8_UNORM;
+    }
+
+    return gpufmt::Format::R16G16B16A16_SFLOAT;
+}
+
+bool convertPixels(std::span<const std::byte> source, gpufmt::Format sourceFormat,
+                   std::span<std::byte> destination, gpufmt::Format destinationFormat)
+{
+    if(sourceFormat == destinationFormat)
+    {
+        if(source.size() != destination.size()) { return false; }
+
+        std::memcpy(destination.data(), source.data(), source.size());
+        return true;
+    }
+
+    SourceLayout layout;
+    if(!describeSource(sourceFormat, layout) || source.size() % layout.pixelBytes != 0) { return false; }
+
+    const size_t pixelCount = source.size() / layout.pixelBytes;
+    const std::byte* sourcePixel = source.data();
+
+    const std::array<int, 4> indices = layout.components;
+
+    if(destinationFormat == gpufmt::Format::R8G8B8A8_UNORM || destinationFormat == gpufmt::Format::R8G8B8A8_SRGB)
+    {
+        if(destination.size() != pixelCount * 4) { return false; }
+
+        uint8_t* const destinationPixels = (uint8_t*)destination.data();
+
+        if(layout.componentType == ComponentType::Unorm8)
+        {
+            // sRGB-ness is carried by the destination format, the encoded values are copied as they are
+            for(size_t i = 0; i < pixelCount; ++i, sourcePixel += layout.pixelBytes)
+            {
+                uint8_t* const destinationPixel = destinationPixels + i * 4;
+                destinationPixel[0] = (indices[0] >= 0) ? (uint8_t)sourcePixel[indices[0]] : 0;
+                destinationPixel[1] = (indices[1] >= 0) ? (uint8_t)sourcePixel[indices[1]] : 0;
+                destinationPixel[2] = (indices[2] >= 0) ? (uint8_t)sourcePixel[indices[2]] : 0;
+                destinationPixel[3] = (indices[3] >= 0) ? (uint8_t)sourcePixel[indices[3]] : 255;
+            }
+
+            return true;
+        }
+
+        return convertFloatPixels(sourcePixel, pixelCount, layout, [destinationPixels](size_t firstPixel, size_t blockPixels, const float* pixels)
+            {
+                uint8_t* const destinationComponents = destinationPixels + firstPixel * 4;
+                for(size_t i = 0; i < blockPixels * 4; ++i)
+                {
+                    destinationComponents[i] = floatToUnorm8(pixels[i]);
+                }
+            });
+    }
+
+    if(destinationFormat == gpufmt::Format::R16G16B16A16_SFLOAT)
+    {
+        if(destination.size() != pixelCount * 8) { return false; }
+
+        std::byte* const destinationPixels = destination.data();
+
+        if(layout.componentType == ComponentType::Unorm8)
+        {
+            const Unorm8ToHalfTables& tables = unorm8ToHalfTables();
+            const std::array<uint16_t, 256>& colorTable = layout.srgb ? tables.srgb : tables.linear;
+            constexpr uint16_t kHalfOne = 0x3c00;
+
+            for(size_t i = 0; i < pixelCount; ++i, sourcePixel += layout.pixelBytes)
+            {
+                // Alpha is never sRGB encoded
+                const std::array<uint16_t, 4> pixel = {
+                    (indices[0] >= 0) ? colorTable[(uint8_t)sourcePixel[indices[0]]] : (uint16_t)0,
+                    (indices[1] >= 0) ? colorTable[(uint8_t)sourcePixel[indices[1]]] : (uint16_t)0,
+                    (indices[2] >= 0) ? colorTable[(uint8_t)sourcePixel[indices[2]]] : (uint16_t)0,
+                    (indices[3] >= 0) ? tables.linear[(uint8_t)sourcePixel[indices[3]]] : kHalfOne};
+
+                std::memcpy(destinationPixels + i * 8, pixel.data(), sizeof(pixel));
+            }
+
+            return true;
+        }
+
+        return convertFloatPixels(sourcePixel, pixelCount, layout, [destinationPixels](size_t firstPixel, size_t blockPixels, const float* pixels)
+            {
+                floatsToHalves(std::span(pixels, blockPixels * 4), std::span(destinationPixels + firstPixel * 8, blockPixels * 8));
+            });
+    }
+
+    return false;
+}
+
+bool convertToLinearRgba(std::span<const std::byte> source, gpufmt::Format sourceFormat, std::span<float> rgba, bool unormIsSrgb)
+{
+    SourceLayout layout;
+    if(!describeSource(sourceFormat, layout) || source.size() % layout.pixelBytes != 0) { return false; }
+
+    const size_t pixelCount = source.size() / layout.pixelBytes;
+    if(rgba.size() != pixelCount * 4) { return false; }
+
+    const std::byte* sourcePixel = source.data();
+    const std::array<int, 4> indices = layout.components;
+
+    if(layout.componentType == ComponentType::Unorm8)
+    {
+        const Unorm8ToFloatTables& tables = unorm8ToFloatTables();
+        const std::array<float, 256>& colorTable = (layout.srgb || unormIsSrgb) ? tables.srgb : tables.linear;
+
+        for(size_t i = 0; i < pixelCount; ++i, sourcePixel += layout.pixelBytes)
+        {
+            float* const pixel = rgba.data() + i * 4;
+            pixel[0] = (indices[0] >= 0) ? colorTable[(uint8_t)sourcePixel[indices[0]]] : 0.0f;
+            pixel[1] = (indices[1] >= 0) ? colorTable[(uint8_t)sourcePixel[indices[1]]] : 0.0f;
+            pixel[2] = (indices[2] >= 0) ? colorTable[(uint8_t)sourcePixel[indices[2]]] : 0.0f;
+            pixel[3] = (indices[3] >= 0) ? tables.linear[(uint8_t)sourcePixel[indices[3]]] : 1.0f;
+        }
+
+        return true;
+    }
+
+    float* const destination = rgba.data();
+
+    return convertFloatPixels(sourcePixel, pixelCount, layout, [destination](size_t firstPixel, size_t blockPixels, const float* pixels)
+        {
+            std::memcpy(destination + firstPixel * 4, pixels, blockPixels * 4 * sizeof(float));
+        });
+}
+
+ChannelAnalysis::ChannelAnalysis(gpufmt::Format format)
+{
+    SourceLayout layout;
+    if(!describeSource(format, layout) || layout.componentType != ComponentType::Unorm8 || layout.pixelBytes < 3) { return; }
+
+    mSupported = true;
+    mPixelBytes = layout.pixelBytes;
+    mHasAlpha = layout.components[3] >= 0;
+    // There are no sRGB 16 bit formats
+    mTrackValues = !layout.srgb;
+    mComponentBytes = {layout.components[0], layout.components[1], layout.components[2], 3};
+}
+
+bool ChannelAnalysis::add(std::span<const std::byte> pixels)
+{
+    static_assert(std::endian::native == std::endian::little, "pixels are reduced as little endian words");
+
+    if(!mSupported) { return false; }
+
+    // Big enough to keep the inner loop vectorized, small enough to stop early on colorful images with alpha
+    constexpr size_t kBlockPixels = 4096;
+
+    const std::byte* const data = pixels.data();
+    const size_t pixelCount = pixels.size() / mPixelBytes;
+    // Byte 3 of formats without alpha
+    const uint32_t alphaFill = mHasAlpha ? 0u : 0xff000000u;
+
+    for(size_t blockStart = 0; blockStart < pixelCount; blockStart += kBlockPixels)
+    {
+        const size_t blockEnd = std::min(pixelCount, blockStart + kBlockPixels);
+
+        uint32_t orBits = 0;
+        uint32_t andBits = ~0u;
+        uint32_t grayDifference = 0;
+
+        if(mPixelBytes == 4)
+        {
+            for(size_t i = blockStart; i < blockEnd; ++i)
+            {
+                uint32_t pixel;
+                std::memcpy(&pixel, data + i * 4, sizeof(pixel));
+                pixel |= alphaFill;
+
+                orBits |= pixel;
+                andBits &= pixel;
+                // Bytes 0 to 2 are the color in both RGBA and BGRA order
+                grayDifference |= pixel ^ (pixel >> 8);
+            }
+        }
+        else
+        {
+            for(size_t i = blockStart; i < blockEnd; ++i)
+            {
+                const uint8_t* const pixelBytes = (const uint8_t*)data + i * 3;
+                const uint32_t pixel = (uint32_t)pixelBytes[0] | ((uint32_t)pixelBytes[1] << 8) | ((uint32_t)pixelBytes[2] << 16) | 0xff000000u;
+
+                orBits |= pixel;
+                andBits &= pixel;
+                grayDifference |= pixel ^ (pixel >> 8);
+            }
+        }
+
+        mOrBits |= orBits;
+        mAndBits &= andBits;
+        mGrayDifference |= grayDifference & 0xffffu;
+
+        if(mTrackValues)
+        {
+            addValues(data + blockStart * mPixelBytes, blockEnd - blockStart);
+            mTrackValues = packedFormatFor(content()) != gpufmt::Format::UNDEFINED;
+        }
+
+        if(!canNarrow()) { return false; }
+    }
+
+    return true;
+}
+
+ChannelContent ChannelAnalysis::content() const noexcept
+{
+    ChannelContent content;
+
+    if(!mSupported)
+    {
+        content.opaque = false;
+        content.grayscale = false;
+        content.constant = {false, false, false, false};
+        return content;
+    }
+
+    content.opaque = (mAndBits >> 24) == 0xffu;
+    content.grayscale = (mGrayDifference == 0);
+
+    // A bit is the same in every pixel when it is set in all of them or in none of them
+    const uint32_t varyingBits = mOrBits ^ mAndBits;
+
+    for(size_t component = 0; component < 4; ++component)
+    {
+        const int shift = mComponentBytes[component] * 8;
+        content.constant[component] = ((varyingBits >> shift) & 0xffu) == 0;
+        content.constantValues[component] = (uint8_t)(mAndBits >> shift);
+    }
+
+    if(mTrackValues)
+    {
+        const std::array<ValueSet, 4>& trackedValues = trackedBitsValues();
+
+        for(size_t component = 0; component < 4; ++component)
+        {
+            // A missing alpha is 255, which every depth widens to
+            if(component == 3 && !mHasAlpha)
+            {
+                content.fitsBits[component] = 0xff;
+                continue;
+            }
+
+            const std::array<uint8_t, 256>& seenValues = mSeenValues[(size_t)mComponentBytes[component]];
+            ValueSet seenValueSet = {};
+
+            for(size_t value = 0; value < seenValues.size(); ++value)
+            {
+                seenValueSet[value / 64] |= uint64_t(seenValues[value]) << (value % 64);
+            }
+
+            content.fitsBits[component] = 0x80;
+
+            for(size_t depth = 0; depth < kTrackedBits.size(); ++depth)
+            {
+                bool allWidened = true;
+                for(size_t word = 0; word < seenValueSet.size(); ++word)
+                {
+                    allWidened = allWidened && (seenValueSet[word] & ~trackedValues[depth][word]) == 0;
+                }
+
+                if(allWidened)
+                {
+                    content.fitsBits[component] |= (uint8_t)(1u << (kTrackedBits[depth] - 1));
+                }
+            }
+        }
+    }
+
+    return content;
+}
+
+void ChannelAnalysis::addValues(const std::byte* pixels, size_t pixelCount)
+{
+    const uint8_t* pixel = (const uint8_t*)pixels;
+    const size_t pixelBytes = mPixelBytes;
+
+    // Byte stores may alias anything, the members are not touched inside the loops so nothing is reloaded
+    uint8_t* const seen0 = mSeenValues[0].data();
+    uint8_t* const seen1 = mSeenValues[1].data();
+    uint8_t* const seen2 = mSeenValues[2].data();
+    uint8_t* const seen3 = mSeenValues[3].data();
+
+    if(mHasAlpha)
+    {
+        for(size_t i = 0; i < pixelCount; ++i, pixel += pixelBytes)
+        {
+            seen0[pixel[0]] = 1;
+            seen1[pixel[1]] = 1;
+            seen2[pixel[2]] = 1;
+            seen3[pixel[3]] = 1;
+        }
+    }
+    else
+    {
+        for(size_t i = 0; i < pixelCount; ++i, pixel += pixelBytes)
+        {
+            seen0[pixel[0]] = 1;
+            seen1[pixel[1]] = 1;
+            seen2[pixel[2]] = 1;
+        }
+    }
+}
+
+bool ChannelAnalysis::canNarrow() const noexcept
+{
+    if(mGrayDifference == 0 || mTrackValues) { return true; }
+
+    // Opaque colors narrow to B8G8R8X8, unless they already have no alpha. Then only dropping a blue that is
+    // constantly 0 makes them narrower.
+    if(mHasAlpha) { return (mAndBits >> 24) == 0xffu; }
+    return ((mOrBits >> (mComponentBytes[2] * 8)) & 0xffu) == 0;
+}
+
+std::optional<FormatNarrowing> narrowFormat(gpufmt::Format sourceFormat, const ChannelContent& content)
+{
+    SourceLayout layout;
+    if(!describeSource(sourceFormat, layout) || layout.componentType != ComponentType::Unorm8 || layout.pixelBytes < 3) { return std::nullopt; }
+
+    const gpufmt::Format r8 = layout.srgb ? gpufmt::Format::R8_SRGB : gpufmt::Format::R8_UNORM;
+    const gpufmt::Format rg8 = layout.srgb ? gpufmt::Format::R8G8_SRGB : gpufmt::Format::R8G8_UNORM;
+
+    // Zero is zero in sRGB as well, so components that are constantly 0 can be left to the format's defaults
+    const bool blueZero = content.constant[2] && content.constantValues[2] == 0;
+    const bool greenAndBlueZero = blueZero && content.constant[1] && content.constantValues[1] == 0;
+
+    if(content.opaque && greenAndBlueZero) { return FormatNarrowing{r8, {0, -1, -1, -1}, "rgba"}; }
+    if(content.opaque && content.grayscale) { return FormatNarrowing{r8, {0, -1, -1, -1}, "rrr1"}; }
+    if(content.opaque && blueZero) { return FormatNarrowing{rg8, {0, 1, -1, -1}, "rgba"}; }
+    // R8G8_SRGB would decode the alpha in G as if it were a color, and R8G8_UNORM would not decode the gray
+    if(content.grayscale && !layout.srgb) { return FormatNarrowing{rg8, {0, 3, -1, -1}, "rrrg"}; }
+
+    if(!layout.srgb)
+    {
+        const gpufmt::Format packedFormat = packedFormatFor(content);
+        if(packedFormat != gpufmt::Format::UNDEFINED) { return FormatNarrowing{packedFormat, {0, 1, 2, 3}, "rgba"}; }
+    }
+
+    // Same size, but blending and alpha compression can be skipped. There is no sRGB variant.
+    if(content.opaque && layout.pixelBytes == 4 && layout.components[3] >= 0 && !layout.srgb)
+    {
+        return FormatNarrowing{gpufmt::Format::B8G8R8X8_UNORM, {2, 1, 0, -1}, "rgba"};
+    }
+
+    return std::nullopt;
+}
+
+bool narrowPixels(std::span<const std::byte> source, gpufmt::Format sourceFormat,
+                  std::span<std::byte> destination, const FormatNarrowing& narrowing)
+{
+    SourceLayout layout;
+    if(!describeSource(sourceFormat, layout) || layout.componentType != ComponentType::Unorm8) { return false; }
+
+    const size_t destinationPixelBytes = gpufmt::formatInfo(narrowing.format).blockByteSize;
+    const size_t pixelCount = source.size() / layout.pixelBytes;
+
+    if(destinationPixelBytes > 4 || destination.size() != pixelCount * destinationPixelBytes) { return false; }
+
+    const uint8_t* const sourcePixels = (const uint8_t*)source.data();
+    uint8_t* const packedPixels = (uint8_t*)destination.data();
+
+    switch(narrowing.format)
+    {
+    case gpufmt::Format::R5G6B5_UNORM_PACK16:
+        packPixels(sourcePixels, pixelCount, layout, packedPixels, [](uint8_t r, uint8_t g, uint8_t b, uint8_t)
+            {
+                return (uint16_t)((quantize<5>(r) << 11) | (quantize<6>(g) << 5) | quantize<5>(b));
+            });
+        return true;
+    case gpufmt::Format::A1R5G5B5_UNORM_PACK16:
+        packPixels(sourcePixels, pixelCount, layout, packedPixels, [](uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+            {
+                return (uint16_t)((quantize<1>(a) << 15) | (quantize<5>(r) << 10) | (quantize<5>(g) << 5) | quantize<5>(b));
+            });
+        return true;
+    case gpufmt::Format::A4R4G4B4_UNORM_PACK16:
+        packPixels(sourcePixels, pixelCount, layout, packedPixels, [](uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+            {
+                return (uint16_t)((quantize<4>(a) << 12) | (quantize<4>(r) << 8) | (quantize<4>(g) << 4) | quantize<4>(b));
+            });
+        return true;
+    default:
+        break;
+    }
+
+    // Resolve the source byte of each destination byte once, -1 writes 255
+    std::array<int, 4> sourceBytes = {-1, -1, -1, -1};
+
+    for(size_t component = 0; component < destinationPixelBytes; ++component)
+    {
+        const int sourceComponent = narrowing.sourceComponents[component];
+        sourceBytes[component] = (sourceComponent >= 0) ? layout.components[(size_t)sourceComponent] : -1;
+    }
+
+    const uint8_t* sourcePixel = (const uint8_t*)source.data();
+    uint8_t* const destinationPixels = (uint8_t*)destination.data();
+
+    if(destinationPixelBytes == 1 && sourceBytes[0] >= 0)
+    {
+        const int sourceByte = sourceBytes[0];
+
+        for(size_t i = 0; i < pixelCount; ++i, sourcePixel += layout.pixelBytes)
+        {
+            destinationPixels[i] = sourcePixel[sourceByte];
+        }
+
+        return true;
+    }
+
+    for(size_t i = 0; i < pixelCount; ++i, sourcePixel += layout.pixelBytes)
+    {
+        uint8_t* const destinationPixel = destinationPixels + i * destinationPixelBytes;
+
+        for(size_t component = 0; component < destinationPixelBytes; ++component)
+        {
+            destinationPixel[component] = (sourceBytes[component] >= 0) ? sourcePixel[sourceBytes[component]] : 255;
+        }
+    }
+
+    return true;
+}
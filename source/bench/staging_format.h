@@ -0,0 +1,114 @@
+#pragma once
+
+#include "half_float.h"
+
+#include <gpufmt/format.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+// Format family textures are staged in. Pixels are converted while they are copied into the staging buffer,
+// there is no separate conversion pass and no intermediate buffer.
+enum class StagingFormat
+{
+    // Copied as imported
+    Native,
+    // R8G8B8A8_UNORM, or R8G8B8A8_SRGB for sRGB sources
+    Rgba8,
+    // R16G16B16A16_SFLOAT with sRGB sources linearized
+    Rgba16Float
+};
+
+std::string_view toString(StagingFormat stagingFormat);
+
+// The format a texture of the given format is staged as. Block compressed formats are always staged as they are,
+// they are sampled directly. Returns UNDEFINED for formats the conversion does not support.
+gpufmt::Format stagedFormat(gpufmt::Format sourceFormat, StagingFormat stagingFormat);
+
+// Converts tightly packed pixels of a non block compressed format. The destination must be exactly large enough
+// for the same number of pixels in the destination format. Returns false if the conversion is not supported.
+bool convertPixels(std::span<const std::byte> source, gpufmt::Format sourceFormat,
+                   std::span<std::byte> destination, gpufmt::Format destinationFormat);
+
+// Converts tightly packed pixels of a non block compressed format to linear RGBA floats, four per pixel. sRGB
+// sources are linearized, and so are 8 bit UNORM sources when unormIsSrgb is set, which is how most image files
+// are authored whatever format they import as. Alpha is always linear. Returns false if the format is not
+// supported.
+bool convertToLinearRgba(std::span<const std::byte> source, gpufmt::Format sourceFormat, std::span<float> rgba, bool unormIsSrgb);
+
+// What the pixels of a texture actually use, components in RGBA order
+struct ChannelContent
+{
+    // Alpha is 255 in every pixel, or the format has no alpha
+    bool opaque = true;
+    // R == G == B in every pixel
+    bool grayscale = true;
+    std::array<bool, 4> constant = {true, true, true, true};
+    // Only meaningful for constant components
+    std::array<uint8_t, 4> constantValues = {};
+    // Bit (n - 1) is set when every value of the component is an n bit value widened to 8 bits, by bit
+    // replication or by rounding. Tracked for 1, 4, 5 and 6 bits, what 16 bit formats are widened from.
+    std::array<uint8_t, 4> fitsBits = {};
+};
+
+// Finds out which channels of 8 bit RGB(A) pixels carry information. The reductions are plain ORs and ANDs over
+// whole pixels, so the compiler vectorizes them, and the pixels are only read once. The values each component
+// takes are tracked as well, for as long as the pixels could have been widened from a 16 bit format.
+class ChannelAnalysis
+{
+public:
+    explicit ChannelAnalysis(gpufmt::Format format);
+
+    // Formats other than 8 bit RGB(A) are not analyzed
+    [[nodiscard]] bool supported() const noexcept { return mSupported; }
+
+    // Adds the pixels of one surface. Returns false once the pixels seen so far rule out every narrowing, the
+    // remaining surfaces don't need to be added.
+    bool add(std::span<const std::byte> pixels);
+
+    [[nodiscard]] ChannelContent content() const noexcept;
+
+private:
+    bool canNarrow() const noexcept;
+    void addValues(const std::byte* pixels, size_t pixelCount);
+
+    bool mSupported = false;
+    size_t mPixelBytes = 0;
+    bool mHasAlpha = false;
+    // Byte in the pixel each of R, G, B and A is stored in. Alpha is always byte 3, formats without alpha read it as 255.
+    std::array<int, 4> mComponentBytes = {};
+    uint32_t mOrBits = 0;
+    uint32_t mAndBits = ~0u;
+    uint32_t mGrayDifference = 0;
+    bool mTrackValues = false;
+    // Values seen in each byte of the pixel. Plain stores, a bit set would chain every pixel on the one before.
+    std::array<std::array<uint8_t, 256>, 4> mSeenValues = {};
+};
+
+struct FormatNarrowing
+{
+    gpufmt::Format format = gpufmt::Format::UNDEFINED;
+    // Source component (0 R, 1 G, 2 B, 3 A) written to each component of the narrowed format, -1 writes 255
+    std::array<int, 4> sourceComponents = {-1, -1, -1, -1};
+    // Component mapping that samples the narrowed texture like the original, e.g. "rrr1" for gray in R8
+    std::string_view swizzle = "rgba";
+};
+
+// The narrowest format that holds the content: R8 or RG8 for gray and for colors that only use the first one or
+// two components, R5G6B5, A1R5G5B5 or A4R4G4B4 for content widened from those, B8G8R8X8 for opaque colors. sRGB
+// sources keep sRGB, which rules out the 16 bit formats and RG8 for gray with alpha, since sRGB would decode the
+// alpha too. Returns nullopt when the format can't get narrower.
+//
+// Only the 16 bit formats can change what is sampled. They get back the exact 4, 5 and 6 bit values the content
+// was widened from. The GPU decodes those as x / (2^n - 1), which reproduces rounded widening exactly but is
+// within 1 LSB of bit replicated 5 and 6 bit values. For example, 5 bit 3 replicates to 24 and decodes to 25.
+std::optional<FormatNarrowing> narrowFormat(gpufmt::Format sourceFormat, const ChannelContent& content);
+
+// Writes tightly packed pixels in the narrowed format. The destination must be exactly large enough for the same
+// number of pixels in that format.
+bool narrowPixels(std::span<const std::byte> source, gpufmt::Format sourceFormat,
+                  std::span<std::byte> destination, const FormatNarrowing& narrowing);
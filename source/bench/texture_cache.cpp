@@ -0,0 +1,509 @@
+#include "texture_cache.h"
+
+#include "cache_file.h"
+#include "content_hash.h"
+#include "crc32.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifdef TEXIMP_BENCH_HAS_LZ4
+#include <lz4.h>
+#endif
+
+namespace
+{
+constexpr std::array<char, 4> kCacheMagic = {'T', 'X', 'C', 'E'};
+// Bump whenever the layout below changes, it is part of every key
+constexpr uint32_t kCacheVersion = 2;
+constexpr uint64_t kDataAlignment = 4096;
+constexpr std::string_view kEntryExtension = ".texc";
+constexpr std::chrono::hours kHitRefreshInterval{1};
+
+enum class Compression : uint32_t
+{
+    None,
+    Lz4
+};
+
+// The container is written and read with the native layout of these structs. Only little endian hosts are
+// supported, which is checked below.
+struct CacheFileHeader
+{
+    std::array<char, 4> magic;
+    uint32_t version;
+    std::array<uint64_t, 2> key;
+    uint32_t textureCount;
+    // CRC-32 of this header with metadataCrc set to 0, the texture records and the subresource tables in record order
+    uint32_t metadataCrc;
+    uint64_t fileSize;
+};
+
+struct CacheTextureRecord
+{
+    uint32_t format;
+    uint32_t dimension;
+    int32_t extent[3];
+    int32_t arraySize;
+    int32_t faces;
+    int32_t mips;
+    Compression compression;
+    uint32_t subresourceCount;
+    // CRC-32 of the data as stored, compressed or not
+    uint32_t dataCrc;
+    uint32_t reserved;
+    // Offset of this texture's subresource table, an array of CacheSubresource
+    uint64_t subresourceTableOffset;
+    uint64_t dataOffset;
+    // Size of the texture once decompressed
+    uint64_t dataSize;
+    // Size of the data in the file, equal to dataSize when not compressed
+    uint64_t storedSize;
+};
+
+// Ordered by array slice, then face, then mip. Offsets are relative to the start of the uncompressed texture data.
+struct CacheSubresource
+{
+    uint64_t offset;
+    uint64_t size;
+};
+
+static_assert(std::endian::native == std::endian::little);
+static_assert(sizeof(CacheFileHeader) == 40);
+static_assert(sizeof(CacheTextureRecord) == 80);
+static_assert(sizeof(CacheSubresource) == 16);
+
+// The record's enums and counts are handed to cputex as they are, so they have to describe a texture it can lay out
+bool isValidTextureRecord(const CacheTextureRecord& record)
+{
+    if(record.format == (uint32_t)gpufmt::Format::UNDEFINED || record.format >= (uint32_t)gpufmt::Format::Count) { return false; }
+
+    switch((cputex::TextureDimension)record.dimension)
+    {
+    case cputex::TextureDimension::Texture1D:
+    case cputex::TextureDimension::Texture2D:
+    case cputex::TextureDimension::Texture3D:
+    case cputex::TextureDimension::TextureCube: break;
+    default: return false;
+    }
+
+    return record.extent[0] > 0 && record.extent[1] > 0 && record.extent[2] > 0 && record.arraySize > 0 && record.faces > 0 &&
+           record.mips > 0;
+}
+
+cputex::TextureParams toTextureParams(const CacheTextureRecord& record)
+{
+    cputex::TextureParams params;
+    params.format = (gpufmt::Format)record.format;
+    params.dimension = (cputex::TextureDimension)record.dimension;
+    params.extent = cputex::Extent{record.extent[0], record.extent[1], record.extent[2]};
+    params.arraySize = record.arraySize;
+    params.faces = record.faces;
+    params.mips = record.mips;
+    return params;
+}
+
+std::vector<CacheSubresource> buildSubresourceTable(const cputex::TextureView& texture)
+{
+    std::vector<CacheSubresource> subresources;
+    const std::byte* const base = texture.getData().data();
+
+    for(cputex::CountType arraySlice = 0; arraySlice < texture.arraySize(); ++arraySlice)
+    {
+        for(cputex::CountType face = 0; face < texture.faces(); ++face)
+        {
+            for(cputex::CountType mip = 0; mip < texture.mips(); ++mip)
+            {
+                const std::span<const std::byte> surface = texture.getMipSurfaceData(arraySlice, face, mip);
+                subresources.push_back(CacheSubresource{(uint64_t)(surface.data() - base), surface.size()});
+            }
+        }
+    }
+
+    return subresources;
+}
+
+// The table is the entry's index of its subresources. Views are laid out by cputex, so they are only handed back
+// when that layout is the one the entry was written with, which keeps a cputex layout change from misreading old
+// entries.
+bool matchesSubresourceTable(const cputex::TextureView& texture, std::span<const std::byte> file, const CacheTextureRecord& record)
+{
+    const std::vector<CacheSubresource> subresources = buildSubresourceTable(texture);
+    if(subresources.size() != record.subresourceCount) { return false; }
+
+    return std::memcmp(subresources.data(), file.data() + record.subresourceTableOffset, subresources.size() * sizeof(CacheSubresource)) == 0;
+}
+
+uint32_t computeMetadataCrc(CacheFileHeader header, std::span<const std::byte> records, std::span<const std::span<const std::byte>> subresourceTables)
+{
+    header.metadataCrc = 0;
+
+    uint32_t crc = crc32(std::as_bytes(std::span(&header, 1)));
+    crc = crc32(records, crc);
+
+    for(const std::span<const std::byte> subresourceTable : subresourceTables)
+    {
+        crc = crc32(subresourceTable, crc);
+    }
+
+    return crc;
+}
+
+// Every range has to be inside the file and every subresource inside its texture before anything is trusted
+bool validateEntry(std::span<const std::byte> file, const TextureCacheKey& key, CacheVerification verification)
+{
+    if(file.size() < sizeof(CacheFileHeader)) { return false; }
+
+    CacheFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if(header.magic != kCacheMagic || header.version != kCacheVersion) { return false; }
+    if(header.key != key.hash || header.fileSize != file.size()) { return false; }
+
+    const uint64_t recordsEnd = sizeof(CacheFileHeader) + (uint64_t)header.textureCount * sizeof(CacheTextureRecord);
+    if(recordsEnd > file.size()) { return false; }
+
+    std::vector<std::span<const std::byte>> subresourceTables;
+    subresourceTables.reserve(header.textureCount);
+
+    for(uint32_t textureIndex = 0; textureIndex < header.textureCount; ++textureIndex)
+    {
+        CacheTextureRecord record;
+        std::memcpy(&record, file.data() + sizeof(CacheFileHeader) + textureIndex * sizeof(CacheTextureRecord), sizeof(record));
+
+        if(!isValidTextureRecord(record)) { return false; }
+        if(record.dataOffset > file.size() || record.storedSize > file.size() - record.dataOffset) { return false; }
+        if(record.compression == Compression::None && record.storedSize != record.dataSize) { return false; }
+        if(record.compression != Compression::None && record.compression != Compression::Lz4) { return false; }
+
+        const uint64_t tableSize = (uint64_t)record.subresourceCount * sizeof(CacheSubresource);
+        if(record.subresourceTableOffset > file.size() || tableSize > file.size() - record.subresourceTableOffset) { return false; }
+
+        for(uint32_t subresourceIndex = 0; subresourceIndex < record.subresourceCount; ++subresourceIndex)
+        {
+            CacheSubresource subresource;
+            std::memcpy(&subresource, file.data() + record.subresourceTableOffset + subresourceIndex * sizeof(CacheSubresource), sizeof(subresource));
+
+            if(subresource.offset > record.dataSize || subresource.size > record.dataSize - subresource.offset) { return false; }
+        }
+
+        subresourceTables.push_back(file.subspan(record.subresourceTableOffset, tableSize));
+
+        if(verification == CacheVerification::All && crc32(file.subspan(record.dataOffset, record.storedSize)) != record.dataCrc)
+        {
+            return false;
+        }
+    }
+
+    if(verification != CacheVerification::None)
+    {
+        const std::span<const std::byte> records = file.subspan(sizeof(CacheFileHeader), recordsEnd - sizeof(CacheFileHeader));
+        if(computeMetadataCrc(header, records, subresourceTables) != header.metadataCrc) { return false; }
+    }
+
+    return true;
+}
+}
+
+std::string TextureCacheKey::toString() const
+{
+    char buffer[33];
+    std::snprintf(buffer, sizeof(buffer), "%016llx%016llx", (unsigned long long)hash[0], (unsigned long long)hash[1]);
+    return buffer;
+}
+
+TextureCache::TextureCache(TextureCacheOptions options)
+    : mOptions(std::move(options))
+{
+    std::error_code ec;
+    std::filesystem::create_directories(mOptions.directory, ec);
+}
+
+bool TextureCache::compressionSupported() const
+{
+#ifdef TEXIMP_BENCH_HAS_LZ4
+    return true;
+#else
+    return false;
+#endif
+}
+
+std::optional<TextureCacheKey> TextureCache::computeKey(const std::filesystem::path& sourceFilePath) const
+{
+    MappedFile sourceFile;
+    if(!sourceFile.open(sourceFilePath)) { return std::nullopt; }
+
+    std::array<uint64_t, 2> hash = {kCacheVersion, 0};
+    hash = hashString(mOptions.importerVersion, hash);
+    hash = hashString(mOptions.importOptions, hash);
+    hash = hashBytes(sourceFile.data(), hash);
+
+    return TextureCacheKey{hash};
+}
+
+std::filesystem::path TextureCache::entryPath(const TextureCacheKey& key) const
+{
+    std::filesystem::path path = mOptions.directory / key.toString();
+    path += kEntryExtension;
+    return path;
+}
+
+std::optional<CachedTextures> TextureCache::find(const TextureCacheKey& key) const
+{
+    return find(key, mOptions.verification);
+}
+
+std::optional<CachedTextures> TextureCache::find(const TextureCacheKey& key, CacheVerification verification) const
+{
+    const std::filesystem::path path = entryPath(key);
+
+    CachedTextures cachedTextures;
+    if(!cachedTextures.mMappedFile.open(path)) { return std::nullopt; }
+
+    const std::span<const std::byte> file = cachedTextures.mMappedFile.data();
+    if(!validateEntry(file, key, verification)) { return std::nullopt; }
+
+    CacheFileHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    cachedTextures.mTextures.reserve(header.textureCount);
+    // Views are taken of decompressed textures as they are added, the vector must never reallocate
+    cachedTextures.mDecompressedTextures.reserve(header.textureCount);
+
+    for(uint32_t textureIndex = 0; textureIndex < header.textureCount; ++textureIndex)
+    {
+        CacheTextureRecord record;
+        std::memcpy(&record, file.data() + sizeof(CacheFileHeader) + textureIndex * sizeof(CacheTextureRecord), sizeof(record));
+
+        const cputex::TextureParams params = toTextureParams(record);
+        const std::span<const std::byte> storedData = file.subspan(record.dataOffset, record.storedSize);
+
+        if(record.compression == Compression::None)
+        {
+            cputex::TextureView texture(params, storedData);
+            if(texture.sizeInBytes() != record.dataSize || !matchesSubresourceTable(texture, file, record)) { return std::nullopt; }
+
+            cachedTextures.mTextures.push_back(texture);
+            continue;
+        }
+
+#ifdef TEXIMP_BENCH_HAS_LZ4
+        cputex::UniqueTexture texture(params);
+        const std::span<std::byte> textureData = texture.accessData();
+        if(textureData.size() != record.dataSize || !matchesSubresourceTable(texture, file, record)) { return std::nullopt; }
+
+        const int decompressedSize = LZ4_decompress_safe((const char*)storedData.data(),
+                                                         (char*)textureData.data(),
+                                                         (int)storedData.size(),
+                                                         (int)textureData.size());
+        if(decompressedSize < 0 || (uint64_t)decompressedSize != record.dataSize) { return std::nullopt; }
+
+        cachedTextures.mDecompressedTextures.push_back(std::move(texture));
+        cachedTextures.mTextures.push_back(cachedTextures.mDecompressedTextures.back());
+#else
+        // Written by a build with LZ4
+        return std::nullopt;
+#endif
+    }
+
+    // Hits keep an entry warm for compressColdEntries. Its time is only rewritten once it is older than the refresh
+    // interval, so most hits cost a stat, not a metadata write. A cache that cannot be written stops trying.
+    if(!mHitRefreshFailed.load(std::memory_order_relaxed))
+    {
+        const std::filesystem::file_time_type now = std::filesystem::file_time_type::clock::now();
+
+        std::error_code ec;
+        const std::filesystem::file_time_type lastHit = std::filesystem::last_write_time(path, ec);
+
+        if(!ec && now - lastHit > kHitRefreshInterval)
+        {
+            std::filesystem::last_write_time(path, now, ec);
+            if(ec) { mHitRefreshFailed.store(true, std::memory_order_relaxed); }
+        }
+    }
+
+    return cachedTextures;
+}
+
+bool TextureCache::store(const TextureCacheKey& key, std::span<const cputex::UniqueTexture> textures) const
+{
+    std::vector<cputex::TextureView> views(textures.begin(), textures.end());
+    return storeViews(key, views, mOptions.compress);
+}
+
+bool TextureCache::storeViews(const TextureCacheKey& key, std::span<const cputex::TextureView> textures, [[maybe_unused]] bool compress) const
+{
+    struct PendingTexture
+    {
+        CacheTextureRecord record;
+        std::vector<CacheSubresource> subresources;
+        std::span<const std::byte> storedData;
+        std::vector<char> compressedData;
+    };
+
+    std::vector<PendingTexture> pendingTextures(textures.size());
+
+    uint64_t offset = sizeof(CacheFileHeader) + textures.size() * sizeof(CacheTextureRecord);
+
+    for(size_t textureIndex = 0; textureIndex < textures.size(); ++textureIndex)
+    {
+        const cputex::TextureView& texture = textures[textureIndex];
+        PendingTexture& pending = pendingTextures[textureIndex];
+
+        pending.subresources = buildSubresourceTable(texture);
+        pending.storedData = texture.getData();
+
+        CacheTextureRecord& record = pending.record;
+        record = {};
+        record.format = (uint32_t)texture.format();
+        record.dimension = (uint32_t)texture.dimension();
+        record.extent[0] = texture.extent().x;
+        record.extent[1] = texture.extent().y;
+        record.extent[2] = texture.extent().z;
+        record.arraySize = texture.arraySize();
+        record.faces = texture.faces();
+        record.mips = texture.mips();
+        record.compression = Compression::None;
+        record.subresourceCount = (uint32_t)pending.subresources.size();
+        record.dataSize = texture.sizeInBytes();
+
+#ifdef TEXIMP_BENCH_HAS_LZ4
+        if(compress && pending.storedData.size() <= LZ4_MAX_INPUT_SIZE)
+        {
+            pending.compressedData.resize(LZ4_compressBound((int)pending.storedData.size()));
+
+            const int compressedSize = LZ4_compress_default((const char*)pending.storedData.data(),
+                                                            pending.compressedData.data(),
+                                                            (int)pending.storedData.size(),
+                                                            (int)pending.compressedData.size());
+
+            // Incompressible data, such as already block compressed formats, is stored raw
+            if(compressedSize > 0 && (size_t)compressedSize < pending.storedData.size())
+            {
+                pending.compressedData.resize(compressedSize);
+                pending.storedData = std::as_bytes(std::span(pending.compressedData));
+                record.compression = Compression::Lz4;
+            }
+        }
+#endif
+
+        record.storedSize = pending.storedData.size();
+        record.dataCrc = crc32(pending.storedData);
+        record.subresourceTableOffset = offset;
+        offset += pending.subresources.size() * sizeof(CacheSubresource);
+    }
+
+    for(PendingTexture& pending : pendingTextures)
+    {
+        offset = alignUp(offset, kDataAlignment);
+        pending.record.dataOffset = offset;
+        offset += pending.record.storedSize;
+    }
+
+    CacheFileHeader header = {};
+    header.magic = kCacheMagic;
+    header.version = kCacheVersion;
+    header.key = key.hash;
+    header.textureCount = (uint32_t)textures.size();
+    header.fileSize = offset;
+
+    std::vector<CacheTextureRecord> records;
+    std::vector<std::span<const std::byte>> subresourceTables;
+    for(const PendingTexture& pending : pendingTextures)
+    {
+        records.push_back(pending.record);
+        subresourceTables.push_back(std::as_bytes(std::span(pending.subresources)));
+    }
+
+    header.metadataCrc = computeMetadataCrc(header, std::as_bytes(std::span(records)), subresourceTables);
+
+    const std::filesystem::path path = entryPath(key);
+
+    const std::filesystem::path temporaryPath = temporaryPathFor(path);
+
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if(!file) { return false; }
+
+        file.write((const char*)&header, sizeof(header));
+
+        file.write((const char*)records.data(), records.size() * sizeof(CacheTextureRecord));
+
+        for(const PendingTexture& pending : pendingTextures)
+        {
+            file.write((const char*)pending.subresources.data(), pending.subresources.size() * sizeof(CacheSubresource));
+        }
+
+        for(const PendingTexture& pending : pendingTextures)
+        {
+            const uint64_t padding = pending.record.dataOffset - (uint64_t)file.tellp();
+            const std::array<char, kDataAlignment> zeros = {};
+            file.write(zeros.data(), padding);
+            file.write((const char*)pending.storedData.data(), pending.storedData.size());
+        }
+
+        if(!file)
+        {
+            file.close();
+
+            std::error_code ec;
+            std::filesystem::remove(temporaryPath, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temporaryPath, path, ec);
+
+    if(ec)
+    {
+        // Windows cannot replace an entry another process has mapped. Whatever is there has the same contents.
+        std::filesystem::remove(temporaryPath, ec);
+        return std::filesystem::exists(path, ec);
+    }
+
+    return true;
+}
+
+int TextureCache::compressColdEntries(std::filesystem::file_time_type notUsedSince) const
+{
+    if(!compressionSupported()) { return 0; }
+
+    int compressedCount = 0;
+
+    std::error_code ec;
+    for(const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(mOptions.directory, ec))
+    {
+        if(entry.path().extension() != kEntryExtension) { continue; }
+        if(entry.last_write_time(ec) >= notUsedSince || ec) { continue; }
+
+        std::array<uint64_t, 2> hash;
+        const std::string stem = entry.path().stem().string();
+        if(stem.size() != 32 ||
+           std::sscanf(stem.c_str(), "%16llx%16llx", (unsigned long long*)&hash[0], (unsigned long long*)&hash[1]) != 2)
+        {
+            continue;
+        }
+
+        const TextureCacheKey key{hash};
+
+        // Recompressing gives the data a new CRC, it has to be checked against the old one first
+        std::optional<CachedTextures> cachedTextures = find(key, CacheVerification::All);
+        if(!cachedTextures) { continue; }
+
+        // Entries that are already compressed own their textures, only mapped ones still need compressing
+        if(!cachedTextures->mDecompressedTextures.empty()) { continue; }
+
+        // The new entry is written before the old mapping is released, rename replaces the file underneath it
+        if(storeViews(key, cachedTextures->textures(), true))
+        {
+            ++compressedCount;
+        }
+    }
+
+    return compressedCount;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "mapped_file.h"
+
+#include <cputex/definitions.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// How much of an entry find checks against the CRC-32s stored in it. Bounds are checked at every level, so a
+// corrupt entry can never be read out of range, only decode to wrong pixels.
+enum class CacheVerification
+{
+    // Header, records, subresource tables and texture data
+    All,
+    // Everything except the texture data, which is nearly all of an entry. Only this much is read on a hit of an
+    // uncompressed entry.
+    Metadata,
+    // Nothing, for caches whose contents are trusted, such as ones filled from inputs hashed upstream
+    None
+};
+
+struct TextureCacheOptions
+{
+    std::filesystem::path directory;
+    // Both are part of every key, so a new importer or different import options never hit old entries
+    std::string importerVersion;
+    std::string importOptions;
+    // Store new entries LZ4 compressed. Ignored when the build has no LZ4.
+    bool compress = false;
+    CacheVerification verification = CacheVerification::Metadata;
+};
+
+// 128 bit hash of the source file's bytes, the importer version, the import options and the container version.
+// Not cryptographic, it only has to make accidental collisions practically impossible.
+struct TextureCacheKey
+{
+    std::array<uint64_t, 2> hash = {};
+
+    std::string toString() const;
+};
+
+// Textures loaded from a cache entry. Uncompressed entries are views straight into the mapped file, nothing is
+// copied and nothing but the records and subresource tables is parsed, so loading costs about as much as the page
+// faults on first access. Compressed entries are decompressed into textures owned by this object. Either way a texture is only
+// returned if cputex lays it out exactly as the entry's subresource table records.
+class CachedTextures
+{
+public:
+    std::span<const cputex::TextureView> textures() const { return mTextures; }
+
+private:
+    friend class TextureCache;
+
+    MappedFile mMappedFile;
+    std::vector<cputex::UniqueTexture> mDecompressedTextures;
+    std::vector<cputex::TextureView> mTextures;
+};
+
+// Persistent, content addressed cache of decoded textures. Each entry is one file in the cache directory holding
+// every texture of an import in a raw container: a header, a record per texture with a table of its subresource
+// ranges, then the texture data aligned to pages so it can be mapped and used in place.
+//
+// Entries are written to a temporary file and renamed into place, so concurrent processes sharing a directory
+// never see a partial entry. Entries that fail validation are treated as misses, entries that fail their CRC
+// checks as well.
+class TextureCache
+{
+public:
+    explicit TextureCache(TextureCacheOptions options);
+
+    bool compressionSupported() const;
+
+    std::optional<TextureCacheKey> computeKey(const std::filesystem::path& sourceFilePath) const;
+
+    std::optional<CachedTextures> find(const TextureCacheKey& key) const;
+
+    bool store(const TextureCacheKey& key, std::span<const cputex::UniqueTexture> textures) const;
+
+    // Recompresses uncompressed entries that have not been hit since the given time. Hits only refresh an entry's
+    // time once it is an hour old, so that is the resolution. Returns the number of entries compressed.
+    int compressColdEntries(std::filesystem::file_time_type notUsedSince) const;
+
+private:
+    std::filesystem::path entryPath(const TextureCacheKey& key) const;
+    std::optional<CachedTextures> find(const TextureCacheKey& key, CacheVerification verification) const;
+    bool storeViews(const TextureCacheKey& key, std::span<const cputex::TextureView> textures, bool compress) const;
+
+    TextureCacheOptions mOptions;
+    // Set once refreshing an entry's time fails, the cache is read only to this process
+    mutable std::atomic<bool> mHitRefreshFailed{false};
+};
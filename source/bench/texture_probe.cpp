@@ -0,0 +1,770 @@
+#include "texture_probe.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+constexpr uint64_t kMaxValue = std::numeric_limits<uint64_t>::max();
+
+uint64_t saturatingMultiply(uint64_t a, uint64_t b)
+{
+    if(a != 0 && b > kMaxValue / a) { return kMaxValue; }
+    return a * b;
+}
+
+uint64_t saturatingAdd(uint64_t a, uint64_t b)
+{
+    return (b > kMaxValue - a) ? kMaxValue : a + b;
+}
+
+class FileReader
+{
+public:
+    explicit FileReader(const std::filesystem::path& filePath)
+        : mFile(filePath, std::ios::binary)
+    {
+        std::error_code ec;
+        mSize = std::filesystem::file_size(filePath, ec);
+        if(ec) { mSize = 0; }
+    }
+
+    bool valid() const { return mFile.is_open() && mSize > 0; }
+    uint64_t size() const { return mSize; }
+
+    bool read(uint64_t offset, void* data, size_t byteCount)
+    {
+        if(offset > mSize || byteCount > mSize - offset) { return false; }
+
+        mFile.clear();
+        mFile.seekg((std::streamoff)offset);
+        mFile.read((char*)data, (std::streamsize)byteCount);
+        return (bool)mFile;
+    }
+
+    template<class T>
+    bool read(uint64_t offset, T& value, bool bigEndian = false)
+    {
+        std::array<uint8_t, sizeof(T)> bytes;
+        if(!read(offset, bytes.data(), bytes.size())) { return false; }
+
+        uint64_t result = 0;
+        for(size_t i = 0; i < sizeof(T); ++i)
+        {
+            const size_t shift = bigEndian ? (sizeof(T) - 1 - i) * 8 : i * 8;
+            result |= (uint64_t)bytes[i] << shift;
+        }
+
+        value = (T)result;
+        return true;
+    }
+
+private:
+    std::ifstream mFile;
+    uint64_t mSize = 0;
+};
+
+uint64_t surfaceBytes(uint64_t width, uint64_t height, uint64_t depth, uint64_t bitsPerPixel, uint64_t blockBytes)
+{
+    if(blockBytes > 0)
+    {
+        const uint64_t blocksX = std::max<uint64_t>((width + 3) / 4, 1);
+        const uint64_t blocksY = std::max<uint64_t>((height + 3) / 4, 1);
+        return saturatingMultiply(saturatingMultiply(saturatingMultiply(blocksX, blocksY), depth), blockBytes);
+    }
+
+    const uint64_t bits = saturatingMultiply(saturatingMultiply(saturatingMultiply(width, height), depth), bitsPerPixel);
+    return (bits == kMaxValue) ? kMaxValue : (bits + 7) / 8;
+}
+
+void computeDecodedBytes(TextureProbe& probe, uint64_t bitsPerPixel, uint64_t blockBytes)
+{
+    uint64_t total = 0;
+    uint64_t width = probe.width;
+    uint64_t height = probe.height;
+    uint64_t depth = probe.depth;
+
+    // A hostile mip count would otherwise have us loop for a very long time
+    const uint64_t mips = std::min<uint64_t>(probe.mips, 64);
+
+    for(uint64_t mip = 0; mip < mips; ++mip)
+    {
+        total = saturatingAdd(total, surfaceBytes(width, height, depth, bitsPerPixel, blockBytes));
+
+        width = std::max<uint64_t>(width / 2, 1);
+        height = std::max<uint64_t>(height / 2, 1);
+        depth = std::max<uint64_t>(depth / 2, 1);
+    }
+
+    probe.decodedBytes = saturatingMultiply(saturatingMultiply(total, probe.arraySize), probe.faces);
+}
+
+#ifdef TEXIMP_ENABLE_BITMAP
+bool probeBitmap(FileReader& reader, TextureProbe& probe)
+{
+    uint32_t headerSize = 0;
+    if(!reader.read(14, headerSize)) { return false; }
+
+    uint16_t bitsPerPixel = 0;
+
+    if(headerSize == 12)
+    {
+        // OS/2 1.x header with 16 bit dimensions
+        uint16_t width = 0;
+        uint16_t height = 0;
+        if(!reader.read(18, width) || !reader.read(20, height) || !reader.read(24, bitsPerPixel)) { return false; }
+
+        probe.width = width;
+        probe.height = height;
+    }
+    else
+    {
+        int32_t width = 0;
+        int32_t height = 0;
+        if(!reader.read(18, width) || !reader.read(22, height) || !reader.read(28, bitsPerPixel)) { return false; }
+
+        // Negative heights mark top down images. Widths should never be negative, but take the magnitude the
+        // same way so a corrupt sign cannot hide a huge value.
+        probe.width = (uint64_t)std::abs((int64_t)width);
+        probe.height = (uint64_t)std::abs((int64_t)height);
+    }
+
+    computeDecodedBytes(probe, (bitsPerPixel > 32) ? 64 : 32, 0);
+    return true;
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_DDS
+// Bits per pixel of a DXGI_FORMAT, or the bytes of a 4x4 block through blockBytes for block compressed formats
+uint64_t dxgiBitsPerPixel(uint32_t dxgiFormat, uint64_t& blockBytes)
+{
+    blockBytes = 0;
+
+    if(dxgiFormat >= 1 && dxgiFormat <= 4) { return 128; }
+    if(dxgiFormat >= 5 && dxgiFormat <= 8) { return 96; }
+    if(dxgiFormat >= 9 && dxgiFormat <= 22) { return 64; }
+    if(dxgiFormat >= 23 && dxgiFormat <= 47) { return 32; }
+    if(dxgiFormat >= 48 && dxgiFormat <= 59) { return 16; }
+    if(dxgiFormat >= 60 && dxgiFormat <= 65) { return 8; }
+    if(dxgiFormat == 66) { return 1; }
+    if(dxgiFormat == 67) { return 32; }
+    if(dxgiFormat == 68 || dxgiFormat == 69) { return 16; }
+    if((dxgiFormat >= 70 && dxgiFormat <= 72) || (dxgiFormat >= 79 && dxgiFormat <= 81))
+    {
+        blockBytes = 8;
+        return 0;
+    }
+    if((dxgiFormat >= 73 && dxgiFormat <= 78) || (dxgiFormat >= 82 && dxgiFormat <= 84) || (dxgiFormat >= 94 && dxgiFormat <= 99))
+    {
+        blockBytes = 16;
+        return 0;
+    }
+    if(dxgiFormat == 85 || dxgiFormat == 86 || dxgiFormat == 115) { return 16; }
+    if(dxgiFormat >= 87 && dxgiFormat <= 93) { return 32; }
+
+    // Video and palette formats, sized for the widest of them
+    return 64;
+}
+
+bool probeDds(FileReader& reader, TextureProbe& probe)
+{
+    constexpr uint32_t kDdpfFourCC = 0x4;
+    constexpr uint32_t kDdsCaps2Cubemap = 0x200;
+    constexpr uint32_t kDdsCaps2Volume = 0x200000;
+    constexpr uint32_t kDx10MiscTextureCube = 0x4;
+
+    uint32_t height = 0;
+    uint32_t width = 0;
+    uint32_t depth = 0;
+    uint32_t mips = 0;
+    uint32_t pixelFormatFlags = 0;
+    std::array<char, 4> fourCC{};
+    uint32_t rgbBitCount = 0;
+    uint32_t caps2 = 0;
+
+    if(!reader.read(12, height) || !reader.read(16, width) || !reader.read(24, depth) || !reader.read(28, mips) ||
+       !reader.read(80, pixelFormatFlags) || !reader.read(84, fourCC.data(), fourCC.size()) || !reader.read(88, rgbBitCount) ||
+       !reader.read(112, caps2))
+    {
+        return false;
+    }
+
+    probe.width = width;
+    probe.height = height;
+    probe.depth = ((caps2 & kDdsCaps2Volume) != 0) ? std::max<uint32_t>(depth, 1) : 1;
+    probe.mips = std::max<uint32_t>(mips, 1);
+    probe.faces = ((caps2 & kDdsCaps2Cubemap) != 0) ? 6 : 1;
+
+    uint64_t bitsPerPixel = rgbBitCount;
+    uint64_t blockBytes = 0;
+
+    const std::string_view fourCCString(fourCC.data(), fourCC.size());
+
+    if((pixelFormatFlags & kDdpfFourCC) != 0 && fourCCString == "DX10")
+    {
+        uint32_t dxgiFormat = 0;
+        uint32_t miscFlag = 0;
+        uint32_t arraySize = 0;
+        if(!reader.read(128, dxgiFormat) || !reader.read(136, miscFlag) || !reader.read(140, arraySize)) { return false; }
+
+        bitsPerPixel = dxgiBitsPerPixel(dxgiFormat, blockBytes);
+        probe.arraySize = std::max<uint32_t>(arraySize, 1);
+        probe.faces = ((miscFlag & kDx10MiscTextureCube) != 0) ? 6 : 1;
+    }
+    else if((pixelFormatFlags & kDdpfFourCC) != 0)
+    {
+        if(fourCCString == "DXT1" || fourCCString == "ATI1" || fourCCString == "BC4U" || fourCCString == "BC4S")
+        {
+            blockBytes = 8;
+        }
+        else if(fourCCString == "DXT2" || fourCCString == "DXT3" || fourCCString == "DXT4" || fourCCString == "DXT5" ||
+                fourCCString == "ATI2" || fourCCString == "BC5U" || fourCCString == "BC5S")
+        {
+            blockBytes = 16;
+        }
+        else
+        {
+            // D3DFMT values stored as a fourCC, the widest of which is 128 bits per pixel
+            bitsPerPixel = 128;
+        }
+    }
+
+    computeDecodedBytes(probe, std::max<uint64_t>(bitsPerPixel, 8), blockBytes);
+    return true;
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_EXR
+enum class ExrLevelMode : uint8_t
+{
+    OneLevel,
+    MipmapLevels,
+    RipmapLevels
+};
+
+// Extents of the levels along one axis, each half of the one before it, rounded down or up, until reaching 1
+uint64_t exrLevelCount(uint64_t extent, bool roundUp)
+{
+    uint64_t count = 1;
+    for(; extent > 1; ++count)
+    {
+        extent = roundUp ? extent / 2 + extent % 2 : extent / 2;
+    }
+    return count;
+}
+
+uint64_t exrLevelExtent(uint64_t extent, uint64_t level, bool roundUp)
+{
+    for(uint64_t i = 0; i < level && extent > 1; ++i)
+    {
+        extent = roundUp ? extent / 2 + extent % 2 : extent / 2;
+    }
+    return std::max<uint64_t>(extent, 1);
+}
+
+uint64_t exrLevelExtentSum(uint64_t extent, uint64_t levelCount, bool roundUp)
+{
+    uint64_t sum = 0;
+    for(uint64_t level = 0; level < levelCount; ++level)
+    {
+        sum = saturatingAdd(sum, exrLevelExtent(extent, level, roundUp));
+    }
+    return sum;
+}
+
+bool probeExr(FileReader& reader, TextureProbe& probe)
+{
+    // The header is a list of (name, type, size, value) attributes terminated by an empty name. Attributes
+    // other than the three needed here are skipped using their declared size.
+    uint64_t offset = 8;
+    uint64_t bytesPerPixel = 0;
+    bool foundDataWindow = false;
+    // Scanline files have no tiles attribute and only ever one level
+    ExrLevelMode levelMode = ExrLevelMode::OneLevel;
+    bool roundUp = false;
+
+    const auto readString = [&reader](uint64_t& offset, std::string& value)
+    {
+        value.clear();
+        for(char c = 0; value.size() < 256; value.push_back(c))
+        {
+            if(!reader.read(offset++, c)) { return false; }
+            if(c == '\0') { return true; }
+        }
+        return false;
+    };
+
+    std::string name;
+    std::string type;
+
+    while(readString(offset, name) && !name.empty())
+    {
+        uint32_t size = 0;
+        if(!readString(offset, type) || !reader.read(offset, size)) { return false; }
+        offset += 4;
+
+        if(name == "dataWindow" && type == "box2i")
+        {
+            int32_t xMin = 0;
+            int32_t yMin = 0;
+            int32_t xMax = 0;
+            int32_t yMax = 0;
+            if(!reader.read(offset, xMin) || !reader.read(offset + 4, yMin) || !reader.read(offset + 8, xMax) || !reader.read(offset + 12, yMax)) { return false; }
+
+            probe.width = (uint64_t)std::max<int64_t>((int64_t)xMax - (int64_t)xMin + 1, 0);
+            probe.height = (uint64_t)std::max<int64_t>((int64_t)yMax - (int64_t)yMin + 1, 0);
+            foundDataWindow = true;
+        }
+        else if(name == "channels" && type == "chlist")
+        {
+            uint64_t channelOffset = offset;
+            uint64_t channelCount = 0;
+            uint64_t widestChannel = 0;
+            std::string channelName;
+
+            while(channelOffset < offset + size && readString(channelOffset, channelName) && !channelName.empty())
+            {
+                uint32_t pixelType = 0;
+                if(!reader.read(channelOffset, pixelType)) { return false; }
+                channelOffset += 16;
+
+                // HALF is 2 bytes, UINT and FLOAT are 4
+                widestChannel = std::max<uint64_t>(widestChannel, (pixelType == 1) ? 2 : 4);
+                ++channelCount;
+            }
+
+            // Decoders widen 3 channel data to 4
+            bytesPerPixel = ((channelCount == 3) ? 4 : channelCount) * widestChannel;
+        }
+        else if(name == "tiles" && type == "tiledesc")
+        {
+            // Tile width and height, then the level mode in the low nibble and the rounding mode in the high one
+            uint8_t mode = 0;
+            if(!reader.read(offset + 8, mode)) { return false; }
+
+            // Unknown modes are bounded as the largest chain they could mean
+            levelMode = ((mode & 0xf) <= (uint8_t)ExrLevelMode::RipmapLevels) ? (ExrLevelMode)(mode & 0xf) : ExrLevelMode::RipmapLevels;
+            roundUp = (mode >> 4) != 0;
+        }
+
+        offset += size;
+    }
+
+    if(!foundDataWindow) { return false; }
+
+    const uint64_t pixelBytes = std::max<uint64_t>(bytesPerPixel, 4);
+
+    switch(levelMode)
+    {
+    case ExrLevelMode::OneLevel:
+        computeDecodedBytes(probe, pixelBytes * 8, 0);
+        break;
+    case ExrLevelMode::MipmapLevels:
+    {
+        probe.mips = exrLevelCount(std::max(probe.width, probe.height), roundUp);
+
+        uint64_t pixelCount = 0;
+        for(uint64_t level = 0; level < probe.mips; ++level)
+        {
+            const uint64_t levelPixels = saturatingMultiply(exrLevelExtent(probe.width, level, roundUp), exrLevelExtent(probe.height, level, roundUp));
+            pixelCount = saturatingAdd(pixelCount, levelPixels);
+        }
+
+        probe.decodedBytes = saturatingMultiply(pixelCount, pixelBytes);
+        break;
+    }
+    case ExrLevelMode::RipmapLevels:
+    {
+        // Every combination of a horizontal and a vertical level is stored
+        const uint64_t levelsX = exrLevelCount(probe.width, roundUp);
+        const uint64_t levelsY = exrLevelCount(probe.height, roundUp);
+        probe.mips = std::max(levelsX, levelsY);
+
+        const uint64_t pixelCount = saturatingMultiply(exrLevelExtentSum(probe.width, levelsX, roundUp), exrLevelExtentSum(probe.height, levelsY, roundUp));
+        probe.decodedBytes = saturatingMultiply(pixelCount, pixelBytes);
+        break;
+    }
+    }
+
+    return true;
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_JPEG
+bool probeJpeg(FileReader& reader, TextureProbe& probe)
+{
+    uint64_t offset = 2;
+
+    while(offset + 4 <= reader.size())
+    {
+        uint8_t markerPrefix = 0;
+        uint8_t marker = 0;
+        uint16_t segmentLength = 0;
+        if(!reader.read(offset, markerPrefix) || !reader.read(offset + 1, marker)) { return false; }
+        if(markerPrefix != 0xff) { return false; }
+
+        // Fill bytes
+        if(marker == 0xff)
+        {
+            ++offset;
+            continue;
+        }
+
+        if(!reader.read(offset + 2, segmentLength, true)) { return false; }
+
+        const bool startOfFrame = marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc;
+        if(startOfFrame)
+        {
+            uint16_t height = 0;
+            uint16_t width = 0;
+            uint8_t components = 0;
+            if(!reader.read(offset + 5, height, true) || !reader.read(offset + 7, width, true) || !reader.read(offset + 9, components)) { return false; }
+
+            probe.width = width;
+            probe.height = height;
+            computeDecodedBytes(probe, (components >= 3) ? 32 : 8, 0);
+            return true;
+        }
+
+        // Start of scan without a frame header
+        if(marker == 0xda) { return false; }
+
+        offset += 2 + segmentLength;
+    }
+
+    return false;
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_KTX
+bool probeKtx(FileReader& reader, TextureProbe& probe)
+{
+    uint32_t endianness = 0;
+    if(!reader.read(12, endianness)) { return false; }
+
+    const bool bigEndian = endianness != 0x04030201;
+
+    uint32_t glType = 0;
+    uint32_t glTypeSize = 0;
+    uint32_t glFormat = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t depth = 0;
+    uint32_t arraySize = 0;
+    uint32_t faces = 0;
+    uint32_t mips = 0;
+
+    if(!reader.read(16, glType, bigEndian) || !reader.read(20, glTypeSize, bigEndian) || !reader.read(24, glFormat, bigEndian) ||
+       !reader.read(36, width, bigEndian) || !reader.read(40, height, bigEndian) || !reader.read(44, depth, bigEndian) ||
+       !reader.read(48, arraySize, bigEndian) || !reader.read(52, faces, bigEndian) || !reader.read(56, mips, bigEndian))
+    {
+        return false;
+    }
+
+    probe.width = width;
+    probe.height = std::max<uint32_t>(height, 1);
+    probe.depth = std::max<uint32_t>(depth, 1);
+    probe.arraySize = std::max<uint32_t>(arraySize, 1);
+    probe.faces = std::max<uint32_t>(faces, 1);
+    probe.mips = std::max<uint32_t>(mips, 1);
+
+    if(glType == 0)
+    {
+        // Compressed. 16 bytes per 4x4 block covers every BCn, ETC2 and 4x4 ASTC format.
+        computeDecodedBytes(probe, 0, 16);
+        return true;
+    }
+
+    uint64_t components = 4;
+    switch(glFormat)
+    {
+    case 0x1903: // GL_RED
+    case 0x8D94: // GL_RED_INTEGER
+    case 0x1906: // GL_ALPHA
+    case 0x1909: // GL_LUMINANCE
+    case 0x1902: // GL_DEPTH_COMPONENT
+        components = 1;
+        break;
+    case 0x8227: // GL_RG
+    case 0x8228: // GL_RG_INTEGER
+    case 0x190A: // GL_LUMINANCE_ALPHA
+        components = 2;
+        break;
+    default:
+        break;
+    }
+
+    switch(glType)
+    {
+    case 0x8033: // GL_UNSIGNED_SHORT_4_4_4_4
+    case 0x8034: // GL_UNSIGNED_SHORT_5_5_5_1
+    case 0x8363: // GL_UNSIGNED_SHORT_5_6_5
+    case 0x8035: // GL_UNSIGNED_INT_8_8_8_8
+    case 0x8036: // GL_UNSIGNED_INT_10_10_10_2
+    case 0x8368: // GL_UNSIGNED_INT_2_10_10_10_REV
+    case 0x8C3B: // GL_UNSIGNED_INT_10F_11F_11F_REV
+    case 0x8C3E: // GL_UNSIGNED_INT_5_9_9_9_REV
+    case 0x84FA: // GL_UNSIGNED_INT_24_8
+        // Packed types hold every component in a single glTypeSize value
+        components = 1;
+        break;
+    default:
+        break;
+    }
+
+    computeDecodedBytes(probe, saturatingMultiply(saturatingMultiply(components, std::max<uint32_t>(glTypeSize, 1)), 8), 0);
+    return true;
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_PNG
+bool probePng(FileReader& reader, TextureProbe& probe)
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint8_t bitDepth = 0;
+    uint8_t colorType = 0;
+    if(!reader.read(16, width, true) || !reader.read(20, height, true) || !reader.read(24, bitDepth) || !reader.read(25, colorType)) { return false; }
+
+    probe.width = width;
+    probe.height = height;
+
+    uint64_t channels = 4;
+    switch(colorType)
+    {
+    case 0: channels = 1; break; // gray
+    case 4: channels = 2; break; // gray alpha
+    default: break;              // rgb, palette and rgba all end up with 4 channels
+    }
+
+    computeDecodedBytes(probe, channels * ((bitDepth > 8) ? 16 : 8), 0);
+    return true;
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_TARGA
+bool probeTarga(FileReader& reader, TextureProbe& probe)
+{
+    uint16_t width = 0;
+    uint16_t height = 0;
+    if(!reader.read(12, width) || !reader.read(14, height)) { return false; }
+
+    probe.width = width;
+    probe.height = height;
+    computeDecodedBytes(probe, 32, 0);
+    return true;
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_TIFF
+struct TiffImage
+{
+    uint64_t width = 0;
+    uint64_t height = 0;
+    uint64_t bitsPerPixel = 0;
+    uint32_t nextIfdOffset = 0;
+};
+
+bool readTiffImage(FileReader& reader, uint64_t ifdOffset, bool bigEndian, TiffImage& image)
+{
+    uint16_t entryCount = 0;
+    if(!reader.read(ifdOffset, entryCount, bigEndian)) { return false; }
+
+    uint64_t bitsPerSample = 8;
+    uint64_t samplesPerPixel = 1;
+    bool foundWidth = false;
+    bool foundHeight = false;
+
+    for(uint16_t i = 0; i < entryCount; ++i)
+    {
+        const uint64_t entryOffset = ifdOffset + 2 + (uint64_t)i * 12;
+
+        uint16_t tag = 0;
+        uint16_t type = 0;
+        uint32_t count = 0;
+        if(!reader.read(entryOffset, tag, bigEndian) || !reader.read(entryOffset + 2, type, bigEndian) || !reader.read(entryOffset + 4, count, bigEndian)) { return false; }
+
+        constexpr uint16_t kTypeShort = 3;
+        constexpr uint16_t kTypeLong = 4;
+        if(type != kTypeShort && type != kTypeLong) { continue; }
+
+        // Values that do not fit in the 4 byte field are stored elsewhere, only the first value is needed
+        uint64_t valueOffset = entryOffset + 8;
+        const uint64_t valueBytes = (type == kTypeShort) ? 2 : 4;
+        if(saturatingMultiply(count, valueBytes) > 4)
+        {
+            uint32_t pointer = 0;
+            if(!reader.read(valueOffset, pointer, bigEndian)) { return false; }
+            valueOffset = pointer;
+        }
+
+        uint32_t value = 0;
+        if(type == kTypeShort)
+        {
+            uint16_t shortValue = 0;
+            if(!reader.read(valueOffset, shortValue, bigEndian)) { return false; }
+            value = shortValue;
+        }
+        else if(!reader.read(valueOffset, value, bigEndian))
+        {
+            return false;
+        }
+
+        switch(tag)
+        {
+        case 256: image.width = value; foundWidth = true; break;
+        case 257: image.height = value; foundHeight = true; break;
+        case 258: bitsPerSample = value; break;
+        case 277: samplesPerPixel = value; break;
+        default: break;
+        }
+    }
+
+    if(!foundWidth || !foundHeight) { return false; }
+    if(!reader.read(ifdOffset + 2 + (uint64_t)entryCount * 12, image.nextIfdOffset, bigEndian)) { return false; }
+
+    const uint64_t bytesPerSample = std::max<uint64_t>((bitsPerSample + 7) / 8, 1);
+    // Decoders widen 3 channel data to 4
+    const uint64_t channelCount = (samplesPerPixel == 3) ? 4 : samplesPerPixel;
+    image.bitsPerPixel = saturatingMultiply(saturatingMultiply(channelCount, bytesPerSample), 8);
+    return true;
+}
+
+bool probeTiff(FileReader& reader, TextureProbe& probe)
+{
+    std::array<char, 2> byteOrder{};
+    if(!reader.read(0, byteOrder.data(), byteOrder.size())) { return false; }
+
+    const bool bigEndian = byteOrder[0] == 'M';
+
+    uint32_t ifdOffset = 0;
+    if(!reader.read(4, ifdOffset, bigEndian) || ifdOffset == 0) { return false; }
+
+    // Every directory in the chain is an image a decoder may allocate, pages and reduced resolution copies alike.
+    // A chain that loops or is too long to walk cannot be bounded.
+    constexpr size_t kMaxImages = 4096;
+    std::vector<uint32_t> ifdOffsets;
+
+    while(ifdOffset != 0)
+    {
+        if(ifdOffsets.size() == kMaxImages || std::ranges::find(ifdOffsets, ifdOffset) != ifdOffsets.end()) { return false; }
+        ifdOffsets.push_back(ifdOffset);
+
+        TiffImage image;
+        if(!readTiffImage(reader, ifdOffset, bigEndian, image)) { return false; }
+
+        if(ifdOffsets.size() == 1)
+        {
+            probe.width = image.width;
+            probe.height = image.height;
+        }
+
+        probe.decodedBytes = saturatingAdd(probe.decodedBytes, surfaceBytes(image.width, image.height, 1, image.bitsPerPixel, 0));
+        ifdOffset = image.nextIfdOffset;
+    }
+
+    return true;
+}
+#endif
+}
+
+uint64_t TextureProbe::pixelCount() const
+{
+    return saturatingMultiply(saturatingMultiply(saturatingMultiply(saturatingMultiply(width, height), depth), arraySize), faces);
+}
+
+std::optional<TextureProbe> probeTexture(const std::filesystem::path& filePath)
+{
+    FileReader reader(filePath);
+    if(!reader.valid()) { return std::nullopt; }
+
+    std::array<uint8_t, 12> magic{};
+    reader.read(0, magic.data(), std::min<uint64_t>(magic.size(), reader.size()));
+
+    const auto startsWith = [&magic](std::initializer_list<uint8_t> bytes)
+    {
+        return std::equal(bytes.begin(), bytes.end(), magic.begin());
+    };
+
+    TextureProbe probe;
+    probe.fileBytes = reader.size();
+
+    bool probed = false;
+
+    if(false) {}
+#ifdef TEXIMP_ENABLE_BITMAP
+    else if(startsWith({'B', 'M'}))
+    {
+        probe.fileFormat = teximp::FileFormat::Bitmap;
+        probed = probeBitmap(reader, probe);
+    }
+#endif
+#ifdef TEXIMP_ENABLE_DDS
+    else if(startsWith({'D', 'D', 'S', ' '}))
+    {
+        probe.fileFormat = teximp::FileFormat::Dds;
+        probed = probeDds(reader, probe);
+    }
+#endif
+#ifdef TEXIMP_ENABLE_EXR
+    else if(startsWith({0x76, 0x2f, 0x31, 0x01}))
+    {
+        probe.fileFormat = teximp::FileFormat::Exr;
+        probed = probeExr(reader, probe);
+    }
+#endif
+#ifdef TEXIMP_ENABLE_JPEG
+    else if(startsWith({0xff, 0xd8, 0xff}))
+    {
+        probe.fileFormat = teximp::FileFormat::Jpeg;
+        probed = probeJpeg(reader, probe);
+    }
+#endif
+#ifdef TEXIMP_ENABLE_KTX
+    else if(startsWith({0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n'}))
+    {
+        probe.fileFormat = teximp::FileFormat::Ktx;
+        probed = probeKtx(reader, probe);
+    }
+#endif
+#ifdef TEXIMP_ENABLE_PNG
+    else if(startsWith({0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'}))
+    {
+        probe.fileFormat = teximp::FileFormat::Png;
+        probed = probePng(reader, probe);
+    }
+#endif
+#ifdef TEXIMP_ENABLE_TIFF
+    else if(startsWith({'I', 'I', 42, 0}) || startsWith({'M', 'M', 0, 42}))
+    {
+        probe.fileFormat = teximp::FileFormat::Tiff;
+        probed = probeTiff(reader, probe);
+    }
+#endif
+#ifdef TEXIMP_ENABLE_TARGA
+    else
+    {
+        // Targa has no signature at the start of the file
+        std::string extension = filePath.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)std::tolower((unsigned char)c); });
+
+        if(extension == ".tga")
+        {
+            probe.fileFormat = teximp::FileFormat::Targa;
+            probed = probeTarga(reader, probe);
+        }
+    }
+#endif
+
+    if(!probed) { return std::nullopt; }
+
+    return probe;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <teximp/teximp.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+// What a file declares about itself in its header, read without touching any pixel data. Nothing is checked
+// against the actual file contents. These are the sizes a decoder would trust when allocating.
+struct TextureProbe
+{
+    teximp::FileFormat fileFormat = teximp::FileFormat::Count;
+    uint64_t width = 0;
+    uint64_t height = 0;
+    uint64_t depth = 1;
+    uint64_t arraySize = 1;
+    uint64_t faces = 1;
+    uint64_t mips = 1;
+    uint64_t fileBytes = 0;
+
+    // Upper bound on the memory of the decoded texture, including every mip, face and array slice. Every level of a
+    // tiled EXR and every image in a TIFF's directory chain is counted. Files that cannot be bounded are not probed.
+    uint64_t decodedBytes = 0;
+
+    // Pixels in the top mip of every face and array slice. Saturates instead of overflowing.
+    uint64_t pixelCount() const;
+};
+
+std::optional<TextureProbe> probeTexture(const std::filesystem::path& filePath);
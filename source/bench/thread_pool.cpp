@@ -0,0 +1,51 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int threadCount)
+{
+    mThreads.reserve(threadCount);
+
+    for(int i = 0; i < threadCount; ++i)
+    {
+        mThreads.emplace_back([this](std::stop_token stopToken) { run(stopToken); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    for(std::jthread& thread : mThreads)
+    {
+        thread.request_stop();
+    }
+
+    mThreads.clear();
+}
+
+void ThreadPool::post(std::function<void()> task)
+{
+    {
+        std::scoped_lock lock(mMutex);
+        mTasks.push_back(std::move(task));
+    }
+
+    mCondition.notify_one();
+}
+
+void ThreadPool::run(std::stop_token stopToken)
+{
+    while(true)
+    {
+        std::function<void()> task;
+
+        {
+            std::unique_lock lock(mMutex);
+
+            // wait returns false when stop was requested and there is nothing left to run
+            if(!mCondition.wait(lock, stopToken, [this]() { return !mTasks.empty(); }) && mTasks.empty()) { return; }
+
+            task = std::move(mTasks.front());
+            mTasks.pop_front();
+        }
+
+        task();
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+// Fixed size pool of worker threads running posted tasks in FIFO order. Tasks still queued when the pool is
+// destroyed are run before the workers exit.
+class ThreadPool
+{
+public:
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void post(std::function<void()> task);
+
+    int threadCount() const { return (int)mThreads.size(); }
+
+private:
+    void run(std::stop_token stopToken);
+
+    std::mutex mMutex;
+    std::condition_variable_any mCondition;
+    std::deque<std::function<void()>> mTasks;
+    std::vector<std::jthread> mThreads;
+};
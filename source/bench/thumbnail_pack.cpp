@@ -0,0 +1,353 @@
+#include "thumbnail_pack.h"
+
+#include "cache_file.h"
+#include "content_hash.h"
+#include "mapped_texture.h"
+#include "staging_format.h"
+#include "thread_pool.h"
+
+#include <gpufmt/format.h>
+#include <teximp/teximp.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+namespace
+{
+constexpr std::array<char, 4> kPackMagic = {'T', 'X', 'T', 'P'};
+// Bump whenever the layout below or the thumbnails' pixels change, it is part of every key
+constexpr uint32_t kPackVersion = 1;
+constexpr uint64_t kDataAlignment = 4096;
+
+// Written and read with the native layout, only little endian hosts are supported
+struct PackHeader
+{
+    std::array<char, 4> magic;
+    uint32_t version;
+    uint32_t thumbnailSize;
+    uint32_t reserved;
+    uint64_t entryCount;
+    uint64_t dataOffset;
+    uint64_t fileSize;
+};
+
+// Sorted by key. Entry i's thumbnail is at the start of slot i, width and height are 0 for files that could not
+// be made into a thumbnail.
+struct PackEntry
+{
+    std::array<uint64_t, 2> key;
+    uint32_t width;
+    uint32_t height;
+};
+
+static_assert(std::endian::native == std::endian::little);
+static_assert(sizeof(PackHeader) == 40);
+static_assert(sizeof(PackEntry) == 24);
+
+uint64_t slotBytes(int thumbnailSize)
+{
+    return (uint64_t)thumbnailSize * (uint64_t)thumbnailSize * 4;
+}
+
+uint8_t linearToSrgb8(float value)
+{
+    value = std::clamp(value, 0.0f, 1.0f);
+    const float encoded = (value <= 0.0031308f) ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+    return (uint8_t)(encoded * 255.0f + 0.5f);
+}
+
+cputex::TextureView thumbnailView(int width, int height, std::span<const std::byte> pixels)
+{
+    cputex::TextureParams params;
+    params.format = gpufmt::Format::R8G8B8A8_SRGB;
+    params.dimension = cputex::TextureDimension::Texture2D;
+    params.extent = cputex::Extent{width, height, 1};
+    return cputex::TextureView(params, pixels.first((size_t)width * height * 4));
+}
+}
+
+std::optional<ThumbnailKey> computeThumbnailKey(const std::filesystem::path& filePath, const ThumbnailOptions& options)
+{
+    MappedFile file;
+    if(!file.open(filePath)) { return std::nullopt; }
+
+    ThumbnailKey hash = {kPackVersion, ((uint64_t)options.size << 8) | (uint64_t)options.filter};
+    hash = hashString(options.importerVersion, hash);
+    return hashBytes(file.data(), hash);
+}
+
+std::optional<Thumbnail> makeThumbnail(const cputex::TextureView& texture, int size, ResampleFilter filter)
+{
+    const gpufmt::FormatInfo& formatInfo = gpufmt::formatInfo(texture.format());
+    if(formatInfo.blockCompressed || formatInfo.blockByteSize == 0 || size < 1) { return std::nullopt; }
+
+    const cputex::CountType mip = previewMip(texture.extent(), texture.mips(), size);
+    const cputex::Extent extent = cputex::calculateMipExtent(texture.extent(), mip);
+    const std::span<const std::byte> surface = texture.getMipSurfaceData(0, 0, mip);
+
+    const size_t rowBytes = (size_t)extent.x * formatInfo.blockByteSize;
+    if(extent.x < 1 || extent.y < 1 || surface.size() < rowBytes * extent.y) { return std::nullopt; }
+
+    Thumbnail thumbnail;
+    const int longestSide = std::max(extent.x, extent.y);
+    const int thumbnailSide = std::min(longestSide, size);
+    thumbnail.width = std::max((int)std::lround((double)extent.x * thumbnailSide / longestSide), 1);
+    thumbnail.height = std::max((int)std::lround((double)extent.y * thumbnailSide / longestSide), 1);
+
+    ImageResampler resampler(extent.x, extent.y, thumbnail.width, thumbnail.height, filter);
+    std::vector<float> row((size_t)extent.x * 4);
+
+    for(int y = 0; y < extent.y; ++y)
+    {
+        if(!convertToLinearRgba(surface.subspan(y * rowBytes, rowBytes), texture.format(), row, true)) { return std::nullopt; }
+
+        // Transparent pixels must not bleed their color into their neighbors
+        for(size_t i = 0; i < row.size(); i += 4)
+        {
+            row[i + 0] *= row[i + 3];
+            row[i + 1] *= row[i + 3];
+            row[i + 2] *= row[i + 3];
+        }
+
+        resampler.addRow(row);
+    }
+
+    const std::span<const float> pixels = resampler.pixels();
+    thumbnail.pixels.resize(pixels.size());
+
+    for(size_t i = 0; i < pixels.size(); i += 4)
+    {
+        const float alpha = pixels[i + 3];
+        const float unpremultiply = (alpha > 0.0f) ? 1.0f / alpha : 0.0f;
+
+        thumbnail.pixels[i + 0] = (std::byte)linearToSrgb8(pixels[i + 0] * unpremultiply);
+        thumbnail.pixels[i + 1] = (std::byte)linearToSrgb8(pixels[i + 1] * unpremultiply);
+        thumbnail.pixels[i + 2] = (std::byte)linearToSrgb8(pixels[i + 2] * unpremultiply);
+        thumbnail.pixels[i + 3] = (std::byte)(uint8_t)(std::clamp(alpha, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    return thumbnail;
+}
+
+std::optional<cputex::TextureView> ThumbnailPack::find(const ThumbnailKey& key) const
+{
+    const std::optional<size_t> entryIndex = findEntry(key);
+    if(!entryIndex) { return std::nullopt; }
+
+    return thumbnail(*entryIndex);
+}
+
+std::optional<size_t> ThumbnailPack::findEntry(const ThumbnailKey& key) const
+{
+    const std::byte* const entries = mMappedFile.data().data() + sizeof(PackHeader);
+
+    size_t first = 0;
+    size_t last = mEntryCount;
+
+    while(first < last)
+    {
+        const size_t middle = first + (last - first) / 2;
+
+        PackEntry entry;
+        std::memcpy(&entry, entries + middle * sizeof(PackEntry), sizeof(entry));
+
+        if(entry.key == key) { return middle; }
+
+        if(entry.key < key) { first = middle + 1; }
+        else { last = middle; }
+    }
+
+    return std::nullopt;
+}
+
+std::optional<cputex::TextureView> ThumbnailPack::thumbnail(size_t entryIndex) const
+{
+    PackEntry entry;
+    std::memcpy(&entry, mMappedFile.data().data() + sizeof(PackHeader) + entryIndex * sizeof(PackEntry), sizeof(entry));
+
+    if(entry.width == 0 || entry.height == 0 || entry.width > (uint32_t)mThumbnailSize || entry.height > (uint32_t)mThumbnailSize) { return std::nullopt; }
+
+    const std::span<const std::byte> slot = mMappedFile.data().subspan(mDataOffset + entryIndex * slotBytes(mThumbnailSize), slotBytes(mThumbnailSize));
+    return thumbnailView((int)entry.width, (int)entry.height, slot);
+}
+
+std::optional<ThumbnailPack> openThumbnailPack(const std::filesystem::path& packPath)
+{
+    ThumbnailPack pack;
+    if(!pack.mMappedFile.open(packPath)) { return std::nullopt; }
+
+    const std::span<const std::byte> file = pack.mMappedFile.data();
+    if(file.size() < sizeof(PackHeader)) { return std::nullopt; }
+
+    PackHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if(header.magic != kPackMagic || header.version != kPackVersion || header.fileSize != file.size()) { return std::nullopt; }
+    if(header.thumbnailSize < 1 || header.thumbnailSize > 4096) { return std::nullopt; }
+
+    // Every slot has to be inside the file before anything is trusted
+    const uint64_t slotSize = slotBytes((int)header.thumbnailSize);
+    if(header.dataOffset > file.size() || header.entryCount > (file.size() - header.dataOffset) / slotSize) { return std::nullopt; }
+
+    // The entries sit between the header and the data, with entryCount bounded above this cannot overflow
+    if(header.dataOffset < sizeof(PackHeader) + header.entryCount * sizeof(PackEntry)) { return std::nullopt; }
+
+    pack.mThumbnailSize = (int)header.thumbnailSize;
+    pack.mEntryCount = (size_t)header.entryCount;
+    pack.mDataOffset = header.dataOffset;
+    return pack;
+}
+
+ThumbnailPackUpdate updateThumbnailPack(const std::filesystem::path& packPath, std::span<const std::filesystem::path> filePaths,
+                                        const ThumbnailOptions& options)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const int threadCount = std::max(options.threadCount, 1);
+
+    ThumbnailPackUpdate update;
+    update.fileCount = (int)filePaths.size();
+
+    std::optional<ThumbnailPack> previousPack = openThumbnailPack(packPath);
+    if(previousPack && previousPack->thumbnailSize() != options.size) { previousPack.reset(); }
+
+    // Hashing reads every file, which is the least an update can do to find the changed ones
+    std::vector<std::optional<ThumbnailKey>> keys(filePaths.size());
+    {
+        ThreadPool threadPool(threadCount);
+
+        for(size_t fileIndex = 0; fileIndex < filePaths.size(); ++fileIndex)
+        {
+            threadPool.post([&, fileIndex]() { keys[fileIndex] = computeThumbnailKey(filePaths[fileIndex], options); });
+        }
+    }
+
+    // Copies of a file share one entry, made from the first of them
+    std::vector<std::pair<ThumbnailKey, size_t>> keyedFiles;
+    for(size_t fileIndex = 0; fileIndex < filePaths.size(); ++fileIndex)
+    {
+        if(keys[fileIndex]) { keyedFiles.emplace_back(*keys[fileIndex], fileIndex); }
+        else { ++update.failedCount; }
+    }
+
+    std::ranges::stable_sort(keyedFiles, {}, &std::pair<ThumbnailKey, size_t>::first);
+    const auto duplicates = std::ranges::unique(keyedFiles, {}, &std::pair<ThumbnailKey, size_t>::first);
+    keyedFiles.erase(duplicates.begin(), duplicates.end());
+
+    PackHeader header = {};
+    header.magic = kPackMagic;
+    header.version = kPackVersion;
+    header.thumbnailSize = (uint32_t)options.size;
+    header.entryCount = keyedFiles.size();
+    header.dataOffset = alignUp(sizeof(PackHeader) + keyedFiles.size() * sizeof(PackEntry), kDataAlignment);
+    header.fileSize = header.dataOffset + keyedFiles.size() * slotBytes(options.size);
+
+    std::vector<PackEntry> entries(keyedFiles.size());
+
+    // Two processes can update the same pack at once, the temporary name keeps their partial files apart until the rename
+    const std::filesystem::path temporaryPath = temporaryPathFor(packPath);
+
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if(!file) { return update; }
+    }
+
+    std::error_code ec;
+    std::filesystem::resize_file(temporaryPath, header.fileSize, ec);
+
+    std::fstream file(temporaryPath, std::ios::binary | std::ios::in | std::ios::out);
+
+    if(ec || !file)
+    {
+        file.close();
+        std::filesystem::remove(temporaryPath, ec);
+        return update;
+    }
+
+    {
+        std::mutex mutex;
+        ThreadPool threadPool(threadCount);
+
+        for(size_t entryIndex = 0; entryIndex < keyedFiles.size(); ++entryIndex)
+        {
+            threadPool.post([&, entryIndex]()
+                {
+                    const auto& [key, fileIndex] = keyedFiles[entryIndex];
+                    PackEntry& entry = entries[entryIndex];
+                    entry.key = key;
+
+                    std::optional<Thumbnail> thumbnail;
+                    bool reused = false;
+
+                    if(const std::optional<size_t> previousEntry = previousPack ? previousPack->findEntry(key) : std::nullopt)
+                    {
+                        // Copied out of the mapping, which stays open until the new pack replaces it
+                        if(const std::optional<cputex::TextureView> previousThumbnail = previousPack->thumbnail(*previousEntry))
+                        {
+                            const std::span<const std::byte> pixels = previousThumbnail->getData();
+                            thumbnail = Thumbnail{previousThumbnail->extent().x, previousThumbnail->extent().y, std::vector<std::byte>(pixels.begin(), pixels.end())};
+                        }
+
+                        reused = true;
+                    }
+                    else
+                    {
+                        const teximp::TextureImportResult result = teximp::importTexture(filePaths[fileIndex]);
+
+                        if(result.importer != nullptr && result.importer->error() == teximp::TextureImportError::None &&
+                           !result.textureAllocator.getTextures().empty())
+                        {
+                            thumbnail = makeThumbnail(result.textureAllocator.getTextures()[0], options.size, options.filter);
+                        }
+                    }
+
+                    std::lock_guard lock(mutex);
+
+                    if(reused) { ++update.reusedCount; }
+                    else if(thumbnail) { ++update.computedCount; }
+                    else { ++update.failedCount; }
+
+                    if(!thumbnail) { return; }
+
+                    entry.width = (uint32_t)thumbnail->width;
+                    entry.height = (uint32_t)thumbnail->height;
+
+                    file.seekp((std::streamoff)(header.dataOffset + entryIndex * slotBytes(options.size)));
+                    file.write((const char*)thumbnail->pixels.data(), (std::streamsize)thumbnail->pixels.size());
+                });
+        }
+    }
+
+    file.seekp(0);
+    file.write((const char*)&header, sizeof(header));
+    file.write((const char*)entries.data(), (std::streamsize)(entries.size() * sizeof(PackEntry)));
+
+    if(!file)
+    {
+        file.close();
+        std::filesystem::remove(temporaryPath, ec);
+        return update;
+    }
+
+    file.close();
+
+    // Windows cannot replace a file that is still mapped
+    previousPack.reset();
+
+    std::filesystem::rename(temporaryPath, packPath, ec);
+
+    if(ec)
+    {
+        std::filesystem::remove(temporaryPath, ec);
+    }
+    else
+    {
+        update.written = true;
+    }
+
+    update.wallTime = std::chrono::steady_clock::now() - start;
+    return update;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "image_resample.h"
+#include "mapped_file.h"
+
+#include <cputex/definitions.h>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+struct ThumbnailOptions
+{
+    // Thumbnails fit in a square of this size and keep their aspect ratio. Smaller images are not scaled up.
+    int size = 128;
+    ResampleFilter filter = ResampleFilter::Lanczos3;
+    int threadCount = 4;
+    // Part of every key like the size and filter, so a new importer never reuses old thumbnails
+    std::string importerVersion;
+};
+
+// 128 bit hash of the source file's bytes and the options that change its thumbnail
+using ThumbnailKey = std::array<uint64_t, 2>;
+
+std::optional<ThumbnailKey> computeThumbnailKey(const std::filesystem::path& filePath, const ThumbnailOptions& options);
+
+struct Thumbnail
+{
+    int width = 0;
+    int height = 0;
+    // R8G8B8A8_SRGB, tightly packed
+    std::vector<std::byte> pixels;
+};
+
+// Scales the first array slice and face of a texture down to a thumbnail, starting from the smallest mip that is
+// still large enough. Pixels are filtered in linear space with premultiplied alpha, 8 bit UNORM color is taken to
+// be sRGB encoded like image files are. Returns nullopt for block compressed and every other format
+// convertToLinearRgba does not support.
+std::optional<Thumbnail> makeThumbnail(const cputex::TextureView& texture, int size, ResampleFilter filter);
+
+struct ThumbnailPackUpdate
+{
+    int fileCount = 0;
+    // Thumbnails made from new or changed files
+    int computedCount = 0;
+    // Entries copied from the previous pack, including files that could not be made into a thumbnail before
+    int reusedCount = 0;
+    // Files that could not be read, imported or made into a thumbnail in this update
+    int failedCount = 0;
+    bool written = false;
+    std::chrono::nanoseconds wallTime{0};
+};
+
+// Every thumbnail of a set of files in one file, meant to be mapped: a header, the keys sorted for binary search,
+// then a fixed size slot per key, page aligned. Every slot has room for the largest thumbnail, so a grid view maps
+// the pack once and finds any thumbnail with one binary search and no parsing. Files that could not be made into
+// a thumbnail keep their key with an empty thumbnail, so they are not retried until they change.
+class ThumbnailPack
+{
+public:
+    int thumbnailSize() const { return mThumbnailSize; }
+    size_t thumbnailCount() const { return mEntryCount; }
+
+    // R8G8B8A8_SRGB view into the mapping, valid for as long as the pack. Returns nullopt for keys not in the
+    // pack and for files that could not be made into a thumbnail.
+    std::optional<cputex::TextureView> find(const ThumbnailKey& key) const;
+
+private:
+    friend std::optional<ThumbnailPack> openThumbnailPack(const std::filesystem::path& packPath);
+    friend ThumbnailPackUpdate updateThumbnailPack(const std::filesystem::path& packPath, std::span<const std::filesystem::path> filePaths,
+                                                   const ThumbnailOptions& options);
+
+    // Index of the key's entry, whether or not it has a thumbnail
+    std::optional<size_t> findEntry(const ThumbnailKey& key) const;
+    std::optional<cputex::TextureView> thumbnail(size_t entryIndex) const;
+
+    MappedFile mMappedFile;
+    int mThumbnailSize = 0;
+    size_t mEntryCount = 0;
+    uint64_t mDataOffset = 0;
+};
+
+std::optional<ThumbnailPack> openThumbnailPack(const std::filesystem::path& packPath);
+
+// Writes the pack for the given files in parallel on options.threadCount threads. Every file is hashed, those
+// whose key is in the existing pack are copied over and only new and changed files are imported. Files no longer
+// listed are dropped. The new pack is written next to the old one and renamed over it, so readers never see a
+// partial pack.
+ThumbnailPackUpdate updateThumbnailPack(const std::filesystem::path& packPath, std::span<const std::filesystem::path> filePaths,
+                                        const ThumbnailOptions& options);
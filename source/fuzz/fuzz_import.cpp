@@ -0,0 +1,183 @@
+#include <teximp/teximp.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+// libFuzzer entry points for teximp::importTexture. The same source is built once per file format, selected
+// with TEXIMP_FUZZ_FORMAT_*, so every fuzzer only spends time on one decoder.
+//
+// Besides crashes, the fuzzers look for inputs that are slow to import. Any input that takes longer than
+// TEXIMP_FUZZ_SLOW_MS milliseconds (default 100), and any input that takes at least 1 ms and is 25% slower than
+// the slowest input before it, is copied to TEXIMP_FUZZ_SLOW_DIR (default fuzz_slow/<format>) to be kept as a
+// regression case.
+//
+// The harness also builds with AFL++ by configuring with CXX=afl-clang-fast++, which accepts
+// -fsanitize=fuzzer and drives LLVMFuzzerTestOneInput the same way.
+
+#if defined(TEXIMP_FUZZ_FORMAT_BITMAP)
+#ifndef TEXIMP_ENABLE_BITMAP
+#error The bitmap fuzzer requires TEXIMP_ENABLE_BITMAP
+#endif
+constexpr std::string_view kFormatName = "bitmap";
+constexpr std::string_view kExtension = ".bmp";
+#elif defined(TEXIMP_FUZZ_FORMAT_DDS)
+#ifndef TEXIMP_ENABLE_DDS
+#error The dds fuzzer requires TEXIMP_ENABLE_DDS
+#endif
+constexpr std::string_view kFormatName = "dds";
+constexpr std::string_view kExtension = ".dds";
+#elif defined(TEXIMP_FUZZ_FORMAT_EXR)
+#ifndef TEXIMP_ENABLE_EXR
+#error The exr fuzzer requires TEXIMP_ENABLE_EXR
+#endif
+constexpr std::string_view kFormatName = "exr";
+constexpr std::string_view kExtension = ".exr";
+#elif defined(TEXIMP_FUZZ_FORMAT_JPEG)
+#ifndef TEXIMP_ENABLE_JPEG
+#error The jpeg fuzzer requires TEXIMP_ENABLE_JPEG
+#endif
+constexpr std::string_view kFormatName = "jpeg";
+constexpr std::string_view kExtension = ".jpg";
+#elif defined(TEXIMP_FUZZ_FORMAT_KTX)
+#ifndef TEXIMP_ENABLE_KTX
+#error The ktx fuzzer requires TEXIMP_ENABLE_KTX
+#endif
+constexpr std::string_view kFormatName = "ktx";
+constexpr std::string_view kExtension = ".ktx";
+#elif defined(TEXIMP_FUZZ_FORMAT_PNG)
+#ifndef TEXIMP_ENABLE_PNG
+#error The png fuzzer requires TEXIMP_ENABLE_PNG
+#endif
+constexpr std::string_view kFormatName = "png";
+constexpr std::string_view kExtension = ".png";
+#elif defined(TEXIMP_FUZZ_FORMAT_TARGA)
+#ifndef TEXIMP_ENABLE_TARGA
+#error The targa fuzzer requires TEXIMP_ENABLE_TARGA
+#endif
+constexpr std::string_view kFormatName = "targa";
+constexpr std::string_view kExtension = ".tga";
+#elif defined(TEXIMP_FUZZ_FORMAT_TIFF)
+#ifndef TEXIMP_ENABLE_TIFF
+#error The tiff fuzzer requires TEXIMP_ENABLE_TIFF
+#endif
+constexpr std::string_view kFormatName = "tiff";
+constexpr std::string_view kExtension = ".tif";
+#else
+#error Define one of TEXIMP_FUZZ_FORMAT_* to select the format to fuzz
+#endif
+
+namespace
+{
+std::filesystem::path gInputPath;
+std::filesystem::path gSlowInputDirectory;
+std::chrono::milliseconds gSlowThreshold{100};
+std::chrono::nanoseconds gSlowest{0};
+
+int processId()
+{
+#ifdef _WIN32
+    return _getpid();
+#else
+    return (int)getpid();
+#endif
+}
+
+// Only used to give saved inputs stable, distinct names
+uint64_t fnv1a(const uint8_t* data, size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for(size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ data[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+void saveSlowInput(const uint8_t* data, size_t size, std::chrono::nanoseconds importTime)
+{
+    const long long milliseconds = (long long)std::chrono::duration_cast<std::chrono::milliseconds>(importTime).count();
+
+    char fileName[64];
+    std::snprintf(fileName, sizeof(fileName), "slow-%06lldms-%016llx", milliseconds, (unsigned long long)fnv1a(data, size));
+
+    std::error_code ec;
+    std::filesystem::create_directories(gSlowInputDirectory, ec);
+
+    const std::filesystem::path filePath = gSlowInputDirectory / (fileName + std::string(kExtension));
+    std::ofstream file(filePath, std::ios::binary);
+    file.write((const char*)data, (std::streamsize)size);
+
+    std::fprintf(stderr, "teximp_fuzz: %lld ms import saved to %s\n", milliseconds, filePath.string().c_str());
+}
+
+void removeInputFile()
+{
+    std::error_code ec;
+    std::filesystem::remove(gInputPath, ec);
+}
+}
+
+extern "C" int LLVMFuzzerInitialize(int*, char***)
+{
+    if(const char* slowDirectory = std::getenv("TEXIMP_FUZZ_SLOW_DIR"))
+    {
+        gSlowInputDirectory = slowDirectory;
+    }
+    else
+    {
+        gSlowInputDirectory = std::filesystem::path("fuzz_slow") / kFormatName;
+    }
+
+    if(const char* slowMilliseconds = std::getenv("TEXIMP_FUZZ_SLOW_MS"))
+    {
+        gSlowThreshold = std::chrono::milliseconds(std::max(std::atoi(slowMilliseconds), 1));
+    }
+
+    // importTexture takes a path, so every input goes through a file. The process id keeps parallel fuzzing
+    // jobs (-jobs/-workers) from overwriting each other's input.
+    gInputPath = std::filesystem::temp_directory_path() /
+                 ("teximp_fuzz_" + std::string(kFormatName) + "_" + std::to_string(processId()) + std::string(kExtension));
+    std::atexit(removeInputFile);
+
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    {
+        std::ofstream file(gInputPath, std::ios::binary | std::ios::trunc);
+        file.write((const char*)data, (std::streamsize)size);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    {
+        teximp::TextureImportResult result = teximp::importTexture(gInputPath);
+    }
+    const auto importTime = std::chrono::steady_clock::now() - start;
+
+    // Inputs just above the previous slowest are not interesting on their own, only keep ones that are at
+    // least a millisecond and 25% slower.
+    const bool newSlowest = importTime > std::chrono::milliseconds(1) && importTime > gSlowest + gSlowest / 4;
+    if(importTime > gSlowThreshold || newSlowest)
+    {
+        saveSlowInput(data, size, importTime);
+    }
+
+    gSlowest = std::max<std::chrono::nanoseconds>(gSlowest, importTime);
+
+    return 0;
+}
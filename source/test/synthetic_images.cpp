@@ -0,0 +1,844 @@
+#include "synthetic_images.h"
+
+#include "crc32.h"
+#include "half_float.h"
+#include "interlace_preview.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <span>
+#include <string>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace std::literals;
+
+namespace
+{
+class ByteWriter
+{
+public:
+    std::vector<std::byte> bytes;
+
+    size_t size() const { return bytes.size(); }
+
+    void u8(uint32_t value) { bytes.push_back((std::byte)value); }
+
+    void u16le(uint32_t value)
+    {
+        u8(value & 0xff);
+        u8((value >> 8) & 0xff);
+    }
+
+    void u32le(uint32_t value)
+    {
+        u16le(value & 0xffff);
+        u16le(value >> 16);
+    }
+
+    void u64le(uint64_t value)
+    {
+        u32le((uint32_t)value);
+        u32le((uint32_t)(value >> 32));
+    }
+
+    void u32be(uint32_t value)
+    {
+        u8(value >> 24);
+        u8((value >> 16) & 0xff);
+        u8((value >> 8) & 0xff);
+        u8(value & 0xff);
+    }
+
+    void f32le(float value) { u32le(std::bit_cast<uint32_t>(value)); }
+
+    void string(std::string_view value, bool nullTerminate)
+    {
+        for(char c : value) { u8((uint8_t)c); }
+        if(nullTerminate) { u8(0); }
+    }
+
+    void append(const std::vector<std::byte>& other) { bytes.insert(bytes.end(), other.begin(), other.end()); }
+
+    void patchU32le(size_t offset, uint32_t value)
+    {
+        for(int i = 0; i < 4; ++i)
+        {
+            bytes[offset + i] = (std::byte)((value >> (i * 8)) & 0xff);
+        }
+    }
+};
+
+int processId()
+{
+#ifdef _WIN32
+    return _getpid();
+#else
+    return (int)getpid();
+#endif
+}
+
+std::minstd_rand makeRandomEngine()
+{
+    // Fixed seed so every run benchmarks identical data
+    return std::minstd_rand(0x7e417e41);
+}
+
+int bitmapRowPitch(int width, int bitsPerPixel)
+{
+    return ((width * bitsPerPixel + 31) / 32) * 4;
+}
+
+void writeBitmapHeaders(ByteWriter& writer, int width, int height, int bitsPerPixel, uint32_t compression, uint32_t paletteSize, uint32_t extraHeaderBytes, uint32_t imageSize)
+{
+    constexpr uint32_t kFileHeaderSize = 14;
+    constexpr uint32_t kInfoHeaderSize = 40;
+    const uint32_t pixelOffset = kFileHeaderSize + kInfoHeaderSize + extraHeaderBytes + paletteSize * 4;
+
+    writer.string("BM", false);
+    writer.u32le(pixelOffset + imageSize);
+    writer.u32le(0);
+    writer.u32le(pixelOffset);
+
+    writer.u32le(kInfoHeaderSize);
+    writer.u32le(width);
+    writer.u32le(height); // positive height, stored bottom up
+    writer.u16le(1);
+    writer.u16le(bitsPerPixel);
+    writer.u32le(compression);
+    writer.u32le(imageSize);
+    writer.u32le(2835);
+    writer.u32le(2835);
+    writer.u32le(paletteSize);
+    writer.u32le(0);
+}
+
+uint32_t adler32(const std::vector<std::byte>& data)
+{
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for(std::byte value : data)
+    {
+        a = (a + (uint32_t)value) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+void writePngChunk(ByteWriter& writer, std::string_view type, const std::vector<std::byte>& data)
+{
+    writer.u32be((uint32_t)data.size());
+    const size_t crcStart = writer.size();
+    writer.string(type, false);
+    writer.append(data);
+    writer.u32be(crc32(std::span(writer.bytes).subspan(crcStart)));
+}
+
+// Wraps the data in a zlib stream made of stored deflate blocks. Inflating it is little more than a copy,
+// which keeps inflate from dominating benchmarks aimed at the filtering stage.
+std::vector<std::byte> zlibStore(const std::vector<std::byte>& data)
+{
+    constexpr size_t kMaxStoredBlockSize = 65535;
+
+    ByteWriter writer;
+    writer.u8(0x78);
+    writer.u8(0x01);
+
+    size_t offset = 0;
+    do
+    {
+        const size_t blockSize = std::min(kMaxStoredBlockSize, data.size() - offset);
+        const bool finalBlock = offset + blockSize == data.size();
+
+        writer.u8(finalBlock ? 1 : 0);
+        writer.u16le((uint32_t)blockSize);
+        writer.u16le((uint32_t)~blockSize & 0xffff);
+        writer.bytes.insert(writer.bytes.end(), data.begin() + offset, data.begin() + offset + blockSize);
+
+        offset += blockSize;
+    } while(offset < data.size());
+
+    writer.u32be(adler32(data));
+    return std::move(writer.bytes);
+}
+
+// Deflate writes bits from the least significant end and Huffman codes starting with their most significant bit
+class DeflateBitWriter
+{
+public:
+    explicit DeflateBitWriter(ByteWriter& writer)
+        : mWriter(writer)
+    {}
+
+    void bits(uint32_t value, int count)
+    {
+        mBitBuffer |= value << mBitCount;
+        mBitCount += count;
+
+        while(mBitCount >= 8)
+        {
+            mWriter.u8(mBitBuffer & 0xff);
+            mBitBuffer >>= 8;
+            mBitCount -= 8;
+        }
+    }
+
+    void code(uint32_t value, int length)
+    {
+        uint32_t reversed = 0;
+        for(int bit = 0; bit < length; ++bit)
+        {
+            reversed |= ((value >> bit) & 1) << (length - 1 - bit);
+        }
+
+        bits(reversed, length);
+    }
+
+    void flush()
+    {
+        if(mBitCount > 0) { mWriter.u8(mBitBuffer & 0xff); }
+
+        mBitBuffer = 0;
+        mBitCount = 0;
+    }
+
+private:
+    ByteWriter& mWriter;
+    uint32_t mBitBuffer = 0;
+    int mBitCount = 0;
+};
+
+void writeFixedLiteral(DeflateBitWriter& bitWriter, uint32_t symbol)
+{
+    if(symbol < 144) { bitWriter.code(0x30 + symbol, 8); }
+    else if(symbol < 256) { bitWriter.code(0x190 + symbol - 144, 9); }
+    else if(symbol < 280) { bitWriter.code(symbol - 256, 7); }
+    else { bitWriter.code(0xc0 + symbol - 280, 8); }
+}
+
+void writeFixedMatch(DeflateBitWriter& bitWriter, uint32_t length, uint32_t distance)
+{
+    constexpr std::array<uint16_t, 29> kLengthBases = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    constexpr std::array<uint8_t, 29> kLengthExtraBits = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    constexpr std::array<uint16_t, 30> kDistanceBases = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    constexpr std::array<uint8_t, 30> kDistanceExtraBits = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    size_t lengthCode = kLengthBases.size() - 1;
+    while(kLengthBases[lengthCode] > length) { --lengthCode; }
+
+    size_t distanceCode = kDistanceBases.size() - 1;
+    while(kDistanceBases[distanceCode] > distance) { --distanceCode; }
+
+    writeFixedLiteral(bitWriter, 257 + (uint32_t)lengthCode);
+    bitWriter.bits(length - kLengthBases[lengthCode], kLengthExtraBits[lengthCode]);
+    bitWriter.code((uint32_t)distanceCode, 5);
+    bitWriter.bits(distance - kDistanceBases[distanceCode], kDistanceExtraBits[distanceCode]);
+}
+
+// A zlib stream in a single block of fixed Huffman codes, with greedy LZ77 matches found through a one entry hash
+// table. Far from zlib's ratio, but inflating it takes the same symbol decoding and match copies.
+std::vector<std::byte> zlibDeflate(const std::vector<std::byte>& data)
+{
+    constexpr size_t kMinMatch = 3;
+    constexpr size_t kMaxMatch = 258;
+    constexpr size_t kWindowSize = 32768;
+    constexpr size_t kHashBits = 15;
+
+    ByteWriter writer;
+    writer.u8(0x78);
+    writer.u8(0x01);
+
+    DeflateBitWriter bitWriter(writer);
+    // final block, fixed Huffman codes
+    bitWriter.bits(1, 1);
+    bitWriter.bits(1, 2);
+
+    std::vector<uint32_t> lastPositions((size_t)1 << kHashBits, UINT32_MAX);
+    const auto hash = [&data](size_t position)
+    {
+        const uint32_t value = (uint32_t)data[position] | ((uint32_t)data[position + 1] << 8) | ((uint32_t)data[position + 2] << 16);
+        return (value * 2654435761u) >> (32 - kHashBits);
+    };
+
+    size_t position = 0;
+    while(position < data.size())
+    {
+        size_t matchLength = 0;
+        size_t matchDistance = 0;
+
+        if(position + kMinMatch <= data.size())
+        {
+            const uint32_t hashValue = hash(position);
+            const uint32_t candidate = lastPositions[hashValue];
+            lastPositions[hashValue] = (uint32_t)position;
+
+            if(candidate != UINT32_MAX && position - candidate <= kWindowSize)
+            {
+                const size_t maxLength = std::min(kMaxMatch, data.size() - position);
+                while(matchLength < maxLength && data[candidate + matchLength] == data[position + matchLength])
+                {
+                    ++matchLength;
+                }
+                matchDistance = position - candidate;
+            }
+        }
+
+        if(matchLength >= kMinMatch)
+        {
+            writeFixedMatch(bitWriter, (uint32_t)matchLength, (uint32_t)matchDistance);
+            position += matchLength;
+        }
+        else
+        {
+            writeFixedLiteral(bitWriter, (uint32_t)data[position]);
+            ++position;
+        }
+    }
+
+    // end of block
+    writeFixedLiteral(bitWriter, 256);
+    bitWriter.flush();
+
+    writer.u32be(adler32(data));
+    return std::move(writer.bytes);
+}
+
+// A non-interlaced image is one pass over every pixel
+constexpr std::array<Adam7Pass, 1> kNonInterlacedPasses = {{{0, 0, 1, 1}}};
+
+int pngChannelCount(PngColorType colorType)
+{
+    switch(colorType)
+    {
+    case PngColorType::Gray: return 1;
+    case PngColorType::GrayAlpha: return 2;
+    case PngColorType::Rgb: return 3;
+    case PngColorType::Rgba: return 4;
+    }
+
+    return 0;
+}
+
+uint8_t paethPredictor(int left, int up, int upLeft)
+{
+    const int estimate = left + up - upLeft;
+    const int leftDistance = std::abs(estimate - left);
+    const int upDistance = std::abs(estimate - up);
+    const int upLeftDistance = std::abs(estimate - upLeft);
+
+    if(leftDistance <= upDistance && leftDistance <= upLeftDistance) { return (uint8_t)left; }
+    if(upDistance <= upLeftDistance) { return (uint8_t)up; }
+    return (uint8_t)upLeft;
+}
+
+// The straightforward per byte reference of what the decoder vectorizes
+void unfilterPngRow(PngFilter filter, std::vector<uint8_t>& row, const std::vector<uint8_t>& previousRow, size_t filterBytes)
+{
+    for(size_t i = 0; i < row.size(); ++i)
+    {
+        const int left = (i >= filterBytes) ? row[i - filterBytes] : 0;
+        const int up = previousRow[i];
+        const int upLeft = (i >= filterBytes) ? previousRow[i - filterBytes] : 0;
+
+        int prediction = 0;
+        switch(filter)
+        {
+        case PngFilter::None: prediction = 0; break;
+        case PngFilter::Sub: prediction = left; break;
+        case PngFilter::Up: prediction = up; break;
+        case PngFilter::Average: prediction = (left + up) / 2; break;
+        case PngFilter::Paeth: prediction = paethPredictor(left, up, upLeft); break;
+        }
+
+        row[i] = (uint8_t)(row[i] + prediction);
+    }
+}
+
+// Any byte sequence is valid filtered data, so random rows exercise the unfilter without having to run the
+// filter forward first. With unfilter set the same rows are reversed to what they decode to and stored with the
+// None filter instead.
+std::vector<std::byte> makePngScanlines(const PngParams& params, bool unfilter)
+{
+    const int bitsPerPixel = pngChannelCount(params.colorType) * params.bitDepth;
+    // Filters work on bytes, pixels smaller than a byte count as one
+    const size_t filterBytes = (size_t)std::max(1, bitsPerPixel / 8);
+    const std::span<const Adam7Pass> passes = params.interlaced ? std::span<const Adam7Pass>(kAdam7Passes) : std::span<const Adam7Pass>(kNonInterlacedPasses);
+
+    ByteWriter scanlines;
+    auto random = makeRandomEngine();
+    std::vector<uint8_t> row;
+    std::vector<uint8_t> previousRow;
+
+    for(const Adam7Pass& pass : passes)
+    {
+        // Passes of small images can be empty, those have no rows at all
+        const int passWidth = (params.width - pass.xStart + pass.xStep - 1) / pass.xStep;
+        const int passHeight = (params.height - pass.yStart + pass.yStep - 1) / pass.yStep;
+        if(passWidth <= 0 || passHeight <= 0) { continue; }
+
+        const size_t rowBytes = ((size_t)passWidth * bitsPerPixel + 7) / 8;
+        row.resize(rowBytes);
+        previousRow.assign(rowBytes, 0);
+
+        for(int y = 0; y < passHeight; ++y)
+        {
+            for(uint8_t& value : row)
+            {
+                value = random() & 0xff;
+            }
+
+            if(unfilter)
+            {
+                unfilterPngRow(params.filter, row, previousRow, filterBytes);
+                previousRow = row;
+            }
+
+            scanlines.u8((uint8_t)(unfilter ? PngFilter::None : params.filter));
+            for(uint8_t value : row)
+            {
+                scanlines.u8(value);
+            }
+        }
+    }
+
+    return std::move(scanlines.bytes);
+}
+
+std::vector<std::byte> makePngFile(const PngParams& params, const std::vector<std::byte>& imageData)
+{
+    ByteWriter header;
+    header.u32be(params.width);
+    header.u32be(params.height);
+    header.u8(params.bitDepth);
+    header.u8((uint8_t)params.colorType);
+    header.u8(0); // deflate
+    header.u8(0); // adaptive filtering
+    header.u8(params.interlaced ? 1 : 0);
+
+    ByteWriter writer;
+    writer.bytes = {(std::byte)0x89, (std::byte)'P', (std::byte)'N', (std::byte)'G', (std::byte)'\r', (std::byte)'\n', (std::byte)0x1a, (std::byte)'\n'};
+    writePngChunk(writer, "IHDR", header.bytes);
+    writePngChunk(writer, "IDAT", imageData);
+    writePngChunk(writer, "IEND", {});
+
+    return std::move(writer.bytes);
+}
+
+void writeExrAttribute(ByteWriter& writer, std::string_view name, std::string_view type, uint32_t size)
+{
+    writer.string(name, true);
+    writer.string(type, true);
+    writer.u32le(size);
+}
+}
+
+std::vector<std::byte> makePalettedBitmap(int width, int height, int bitsPerPixel)
+{
+    const uint32_t paletteSize = 1u << bitsPerPixel;
+    const int rowPitch = bitmapRowPitch(width, bitsPerPixel);
+
+    ByteWriter writer;
+    writeBitmapHeaders(writer, width, height, bitsPerPixel, 0, paletteSize, 0, rowPitch * height);
+
+    for(uint32_t i = 0; i < paletteSize; ++i)
+    {
+        const uint32_t intensity = (i * 255) / (paletteSize - 1);
+        writer.u8(intensity);
+        writer.u8(255 - intensity);
+        writer.u8((intensity * 7) & 0xff);
+        writer.u8(0);
+    }
+
+    auto random = makeRandomEngine();
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < rowPitch; ++x)
+        {
+            writer.u8(random() & 0xff);
+        }
+    }
+
+    return std::move(writer.bytes);
+}
+
+std::vector<std::byte> makeRle8Bitmap(int width, int height)
+{
+    ByteWriter pixels;
+    auto random = makeRandomEngine();
+
+    for(int y = 0; y < height; ++y)
+    {
+        int x = 0;
+        while(x < width)
+        {
+            // Mix of short and long runs, the short ones keep the decoder from turning into a memset
+            const int runLength = std::min(width - x, (int)(1 + random() % 32));
+            pixels.u8(runLength);
+            pixels.u8(random() & 0xff);
+            x += runLength;
+        }
+
+        // end of line
+        pixels.u8(0);
+        pixels.u8(0);
+    }
+
+    // end of bitmap
+    pixels.u8(0);
+    pixels.u8(1);
+
+    constexpr uint32_t kBiRle8 = 1;
+
+    ByteWriter writer;
+    writeBitmapHeaders(writer, width, height, 8, kBiRle8, 256, 0, (uint32_t)pixels.size());
+
+    for(uint32_t i = 0; i < 256; ++i)
+    {
+        writer.u8(i);
+        writer.u8(i);
+        writer.u8(255 - i);
+        writer.u8(0);
+    }
+
+    writer.append(pixels.bytes);
+    return std::move(writer.bytes);
+}
+
+std::vector<std::byte> makeBitfieldsBitmap(int width, int height, int bitsPerPixel)
+{
+    constexpr uint32_t kBiBitfields = 3;
+    const int rowPitch = bitmapRowPitch(width, bitsPerPixel);
+
+    ByteWriter writer;
+    writeBitmapHeaders(writer, width, height, bitsPerPixel, kBiBitfields, 0, 12, rowPitch * height);
+
+    if(bitsPerPixel == 16)
+    {
+        // 5:6:5
+        writer.u32le(0xf800);
+        writer.u32le(0x07e0);
+        writer.u32le(0x001f);
+    }
+    else
+    {
+        // 10:10:10, which no native format matches and forces the generic unpack path
+        writer.u32le(0x3ff00000);
+        writer.u32le(0x000ffc00);
+        writer.u32le(0x000003ff);
+    }
+
+    auto random = makeRandomEngine();
+    for(int y = 0; y < height; ++y)
+    {
+        for(int x = 0; x < rowPitch; ++x)
+        {
+            writer.u8(random() & 0xff);
+        }
+    }
+
+    return std::move(writer.bytes);
+}
+
+std::vector<std::byte> makePng(const PngParams& params)
+{
+    return makePngFile(params, zlibStore(makePngScanlines(params, false)));
+}
+
+std::vector<std::byte> makeUnfilteredPng(const PngParams& params)
+{
+    return makePngFile(params, zlibStore(makePngScanlines(params, true)));
+}
+
+std::vector<std::byte> makeDeflatedPng(int width, int height)
+{
+    constexpr size_t kBytesPerPixel = 4;
+    const size_t rowBytes = (size_t)width * kBytesPerPixel;
+
+    // Gradients with a little noise, Sub filtered, so the deflate stream mixes literals with short and long matches
+    // like photographs and rendered textures do
+    ByteWriter scanlines;
+    auto random = makeRandomEngine();
+    std::vector<uint8_t> row(rowBytes);
+
+    for(int y = 0; y < height; ++y)
+    {
+        for(size_t i = 0; i < rowBytes; ++i)
+        {
+            const size_t x = i / kBytesPerPixel;
+            const size_t component = i % kBytesPerPixel;
+            row[i] = (component == 3) ? 255 : (uint8_t)(x * (component + 1) / 4 + (size_t)y / 2 + random() % 3);
+        }
+
+        scanlines.u8((uint8_t)PngFilter::Sub);
+        for(size_t i = 0; i < rowBytes; ++i)
+        {
+            scanlines.u8((uint8_t)(row[i] - ((i >= kBytesPerPixel) ? row[i - kBytesPerPixel] : 0)));
+        }
+    }
+
+    return makePngFile({width, height, PngColorType::Rgba, 8, PngFilter::Sub, false}, zlibDeflate(scanlines.bytes));
+}
+
+std::vector<std::byte> makeExr(int width, int height, ExrPixelType pixelType)
+{
+    // Channels have to be listed in alphabetical order
+    constexpr std::array kChannelNames = {"A"sv, "B"sv, "G"sv, "R"sv};
+    const uint32_t bytesPerSample = (pixelType == ExrPixelType::Half) ? 2 : 4;
+
+    ByteWriter writer;
+    writer.u32le(20000630); // magic
+    writer.u32le(2);        // version 2, single part scanline image
+
+    writeExrAttribute(writer, "channels", "chlist", (uint32_t)(kChannelNames.size() * 18 + 1));
+    for(std::string_view name : kChannelNames)
+    {
+        writer.string(name, true);
+        writer.u32le((uint32_t)pixelType);
+        writer.u32le(0); // pLinear + reserved
+        writer.u32le(1); // xSampling
+        writer.u32le(1); // ySampling
+    }
+    writer.u8(0);
+
+    writeExrAttribute(writer, "compression", "compression", 1);
+    writer.u8(0); // NO_COMPRESSION, one scanline per chunk
+
+    for(std::string_view windowName : {"dataWindow"sv, "displayWindow"sv})
+    {
+        writeExrAttribute(writer, windowName, "box2i", 16);
+        writer.u32le(0);
+        writer.u32le(0);
+        writer.u32le(width - 1);
+        writer.u32le(height - 1);
+    }
+
+    writeExrAttribute(writer, "lineOrder", "lineOrder", 1);
+    writer.u8(0); // INCREASING_Y
+
+    writeExrAttribute(writer, "pixelAspectRatio", "float", 4);
+    writer.f32le(1.0f);
+
+    writeExrAttribute(writer, "screenWindowCenter", "v2f", 8);
+    writer.f32le(0.0f);
+    writer.f32le(0.0f);
+
+    writeExrAttribute(writer, "screenWindowWidth", "float", 4);
+    writer.f32le(1.0f);
+
+    writer.u8(0); // end of header
+
+    const uint32_t scanlineSize = (uint32_t)(width * kChannelNames.size() * bytesPerSample);
+    const uint64_t offsetTableEnd = writer.size() + (uint64_t)height * 8;
+    for(int y = 0; y < height; ++y)
+    {
+        writer.u64le(offsetTableEnd + (uint64_t)y * (8 + scanlineSize));
+    }
+
+    std::uniform_real_distribution<float> distribution(0.0f, 4.0f);
+    auto random = makeRandomEngine();
+
+    for(int y = 0; y < height; ++y)
+    {
+        writer.u32le(y);
+        writer.u32le(scanlineSize);
+
+        for(size_t channel = 0; channel < kChannelNames.size(); ++channel)
+        {
+            for(int x = 0; x < width; ++x)
+            {
+                const float value = distribution(random);
+
+                if(pixelType == ExrPixelType::Half)
+                {
+                    writer.u16le(floatToHalf(value));
+                }
+                else
+                {
+                    writer.f32le(value);
+                }
+            }
+        }
+    }
+
+    return std::move(writer.bytes);
+}
+
+std::vector<std::byte> makeBcDds(int width, int height, BcFormat format, int mips)
+{
+    constexpr uint32_t kDdsdCaps = 0x1;
+    constexpr uint32_t kDdsdHeight = 0x2;
+    constexpr uint32_t kDdsdWidth = 0x4;
+    constexpr uint32_t kDdsdPixelFormat = 0x1000;
+    constexpr uint32_t kDdsdMipMapCount = 0x20000;
+    constexpr uint32_t kDdsdLinearSize = 0x80000;
+    constexpr uint32_t kDdpfFourCC = 0x4;
+    constexpr uint32_t kDdsCapsComplex = 0x8;
+    constexpr uint32_t kDdsCapsTexture = 0x1000;
+    constexpr uint32_t kDdsCapsMipMap = 0x400000;
+
+    if(mips == 0)
+    {
+        mips = std::bit_width((uint32_t)std::max(width, height));
+    }
+
+    const uint32_t blockSize = (format == BcFormat::Bc1) ? 8 : 16;
+    const auto mipBlockCount = [&](int mip)
+    {
+        return (uint32_t)(((std::max(width >> mip, 1) + 3) / 4) * ((std::max(height >> mip, 1) + 3) / 4));
+    };
+
+    uint32_t blockCount = 0;
+    for(int mip = 0; mip < mips; ++mip)
+    {
+        blockCount += mipBlockCount(mip);
+    }
+
+    ByteWriter writer;
+    writer.string("DDS ", false);
+    writer.u32le(124);
+    writer.u32le(kDdsdCaps | kDdsdHeight | kDdsdWidth | kDdsdPixelFormat | kDdsdLinearSize | ((mips > 1) ? kDdsdMipMapCount : 0));
+    writer.u32le(height);
+    writer.u32le(width);
+    writer.u32le(mipBlockCount(0) * blockSize);
+    writer.u32le(0); // depth
+    writer.u32le(mips);
+    for(int i = 0; i < 11; ++i) { writer.u32le(0); }
+
+    writer.u32le(32);
+    writer.u32le(kDdpfFourCC);
+    writer.string((format == BcFormat::Bc1) ? "DXT1" : "DXT5", false);
+    for(int i = 0; i < 5; ++i) { writer.u32le(0); }
+
+    writer.u32le(kDdsCapsTexture | ((mips > 1) ? kDdsCapsComplex | kDdsCapsMipMap : 0));
+    for(int i = 0; i < 4; ++i) { writer.u32le(0); }
+
+    auto random = makeRandomEngine();
+    for(uint32_t i = 0; i < blockCount * blockSize; ++i)
+    {
+        writer.u8(random() & 0xff);
+    }
+
+    return std::move(writer.bytes);
+}
+
+std::vector<std::byte> makeRgb565Dds(int width, int height)
+{
+    constexpr uint32_t kDdsdCaps = 0x1;
+    constexpr uint32_t kDdsdHeight = 0x2;
+    constexpr uint32_t kDdsdWidth = 0x4;
+    constexpr uint32_t kDdsdPitch = 0x8;
+    constexpr uint32_t kDdsdPixelFormat = 0x1000;
+    constexpr uint32_t kDdpfRgb = 0x40;
+    constexpr uint32_t kDdsCapsTexture = 0x1000;
+
+    ByteWriter writer;
+    writer.string("DDS ", false);
+    writer.u32le(124);
+    writer.u32le(kDdsdCaps | kDdsdHeight | kDdsdWidth | kDdsdPitch | kDdsdPixelFormat);
+    writer.u32le(height);
+    writer.u32le(width);
+    writer.u32le(width * 2);
+    writer.u32le(0); // depth
+    writer.u32le(1); // mip count
+    for(int i = 0; i < 11; ++i) { writer.u32le(0); }
+
+    writer.u32le(32);
+    writer.u32le(kDdpfRgb);
+    writer.u32le(0); // fourCC
+    writer.u32le(16);
+    writer.u32le(0xf800);
+    writer.u32le(0x07e0);
+    writer.u32le(0x001f);
+    writer.u32le(0);
+
+    writer.u32le(kDdsCapsTexture);
+    for(int i = 0; i < 4; ++i) { writer.u32le(0); }
+
+    auto random = makeRandomEngine();
+    for(int i = 0; i < width * height * 2; ++i)
+    {
+        writer.u8(random() & 0xff);
+    }
+
+    return std::move(writer.bytes);
+}
+
+std::vector<std::byte> makeTarga(int width, int height, bool topLeftOrigin, bool runLengthEncoded)
+{
+    constexpr uint8_t kImageTypeTrueColor = 2;
+    constexpr uint8_t kImageTypeRleTrueColor = 10;
+
+    ByteWriter writer;
+    writer.u8(0); // id length
+    writer.u8(0); // no color map
+    writer.u8(runLengthEncoded ? kImageTypeRleTrueColor : kImageTypeTrueColor);
+    for(int i = 0; i < 5; ++i) { writer.u8(0); }
+    writer.u16le(0); // x origin
+    writer.u16le(0); // y origin
+    writer.u16le(width);
+    writer.u16le(height);
+    writer.u8(32);
+    writer.u8(8 | (topLeftOrigin ? 0x20 : 0));
+
+    auto random = makeRandomEngine();
+
+    if(!runLengthEncoded)
+    {
+        for(int i = 0; i < width * height * 4; ++i)
+        {
+            writer.u8(random() & 0xff);
+        }
+    }
+    else
+    {
+        for(int y = 0; y < height; ++y)
+        {
+            int x = 0;
+            while(x < width)
+            {
+                const int packetLength = std::min(width - x, (int)(1 + random() % 64));
+                const bool repeatPacket = (random() & 1) != 0;
+
+                writer.u8((repeatPacket ? 0x80 : 0) | (packetLength - 1));
+
+                const int literalCount = repeatPacket ? 1 : packetLength;
+                for(int i = 0; i < literalCount * 4; ++i)
+                {
+                    writer.u8(random() & 0xff);
+                }
+
+                x += packetLength;
+            }
+        }
+    }
+
+    return std::move(writer.bytes);
+}
+
+std::filesystem::path syntheticImageDirectory()
+{
+    // test_main removes the directory at exit, the process id keeps concurrent test runs out of each other's inputs
+    static const std::filesystem::path directory = std::filesystem::temp_directory_path() / ("teximp_test_" + std::to_string(processId()));
+    return directory;
+}
+
+std::filesystem::path writeSyntheticImage(std::string_view fileName, const std::vector<std::byte>& contents)
+{
+    const std::filesystem::path directory = syntheticImageDirectory();
+    std::filesystem::create_directories(directory);
+
+    const std::filesystem::path filePath = directory / fileName;
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    file.write((const char*)contents.data(), (std::streamsize)contents.size());
+
+    return filePath;
+}
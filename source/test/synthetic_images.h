@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cputex/definitions.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// Minimal encoders for generating inputs of any size. Each one only writes the subset of its format needed to
+// drive a specific decoder path, so benchmarks can isolate that path without depending on the image corpus.
+
+enum class PngFilter : uint8_t
+{
+    None,
+    Sub,
+    Up,
+    Average,
+    Paeth
+};
+
+enum class PngColorType : uint8_t
+{
+    Gray = 0,
+    Rgb = 2,
+    GrayAlpha = 4,
+    Rgba = 6
+};
+
+struct PngParams
+{
+    int width = 0;
+    int height = 0;
+    PngColorType colorType = PngColorType::Rgba;
+    // 1, 2 and 4 only for gray
+    int bitDepth = 8;
+    PngFilter filter = PngFilter::None;
+    // Adam7, every pass is filtered on its own
+    bool interlaced = false;
+};
+
+enum class ExrPixelType
+{
+    Half = 1,
+    Float = 2
+};
+
+enum class BcFormat
+{
+    Bc1,
+    Bc3
+};
+
+std::vector<std::byte> makePalettedBitmap(int width, int height, int bitsPerPixel);
+std::vector<std::byte> makeRle8Bitmap(int width, int height);
+std::vector<std::byte> makeBitfieldsBitmap(int width, int height, int bitsPerPixel);
+std::vector<std::byte> makePng(const PngParams& params);
+// The pixels makePng(params) decodes to, stored with the None filter on every row. Both must decode identically.
+std::vector<std::byte> makeUnfilteredPng(const PngParams& params);
+// RGBA8 image content compressed with real deflate, for benchmarking inflate. The other PNGs use stored blocks.
+std::vector<std::byte> makeDeflatedPng(int width, int height);
+std::vector<std::byte> makeExr(int width, int height, ExrPixelType pixelType);
+// A full mip chain down to 1x1 when mips is 0
+std::vector<std::byte> makeBcDds(int width, int height, BcFormat format, int mips = 1);
+// Legacy header with R5G6B5 masks
+std::vector<std::byte> makeRgb565Dds(int width, int height);
+std::vector<std::byte> makeTarga(int width, int height, bool topLeftOrigin, bool runLengthEncoded);
+
+std::filesystem::path syntheticImageDirectory();
+std::filesystem::path writeSyntheticImage(std::string_view fileName, const std::vector<std::byte>& contents);
+
+// A 2D texture whose data, every mip included, holds fill(i) at element i when viewed as an array of T
+template<class T, class Fill>
+cputex::UniqueTexture makeTexture(gpufmt::Format format, int width, int height, int mips, Fill fill)
+{
+    cputex::TextureParams params;
+    params.format = format;
+    params.dimension = cputex::TextureDimension::Texture2D;
+    params.extent = cputex::Extent{width, height, 1};
+    params.mips = mips;
+
+    cputex::UniqueTexture texture(params);
+    const std::span<T> data = texture.accessData<T>();
+
+    for(size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = fill(i);
+    }
+
+    return texture;
+}
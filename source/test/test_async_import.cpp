@@ -0,0 +1,73 @@
+#include "async_import.h"
+#include "synthetic_images.h"
+#include "thread_pool.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <teximp/teximp.h>
+
+#include <coroutine>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+// Starts running immediately and owns nothing, enough to drive a single co_await
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+DetachedTask importWithCoroutine(fs::path filePath, ThreadPool& threadPool, std::promise<teximp::TextureImportResult>& promise)
+{
+    promise.set_value(co_await importTextureAwaitable(std::move(filePath), threadPool));
+}
+}
+
+#ifdef TEXIMP_ENABLE_BITMAP
+TEST_CASE("import texture async", "[async]")
+{
+    const fs::path filePath = writeSyntheticImage("async.bmp", makePalettedBitmap(64, 64, 8));
+    ThreadPool threadPool(4);
+
+    SECTION("future")
+    {
+        std::vector<std::future<teximp::TextureImportResult>> imports;
+        for(int i = 0; i < 16; ++i)
+        {
+            imports.push_back(importTextureAsync(filePath, threadPool));
+        }
+
+        for(std::future<teximp::TextureImportResult>& import : imports)
+        {
+            const teximp::TextureImportResult result = import.get();
+            REQUIRE(result.importer != nullptr);
+            CHECK(result.importer->error() == teximp::TextureImportError::None);
+        }
+    }
+
+    SECTION("coroutine")
+    {
+        std::promise<teximp::TextureImportResult> promise;
+        std::future<teximp::TextureImportResult> future = promise.get_future();
+
+        importWithCoroutine(filePath, threadPool, promise);
+
+        const teximp::TextureImportResult result = future.get();
+        REQUIRE(result.importer != nullptr);
+        CHECK(result.importer->error() == teximp::TextureImportError::None);
+    }
+}
+#endif
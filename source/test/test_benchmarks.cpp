@@ -0,0 +1,244 @@
+#include "half_float.h"
+#include "interlace_preview.h"
+#include "synthetic_images.h"
+
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <teximp/teximp.h>
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// Kernel level benchmarks. Each importer test case generates inputs that funnel the importer into one hot loop.
+// The importer only takes a path, so opening and reading the file stays inside an import's timed region. Every
+// import is paired with a read of the same file, warm in the page cache, and the difference between the two is
+// the decode. Kernels that live in this tree are timed on buffers in memory. Run them with the teximp_benchmarks
+// target.
+
+namespace fs = std::filesystem;
+
+namespace
+{
+void checkImport(const fs::path& filePath, int width, int height)
+{
+    teximp::TextureImportResult result = teximp::importTexture(filePath);
+
+    REQUIRE(result.importer != nullptr);
+    REQUIRE(result.importer->error() == teximp::TextureImportError::None);
+    REQUIRE(result.textureAllocator.getTextures().size() == 1);
+
+    const cputex::TextureView texture = result.textureAllocator.getTextures()[0];
+    CHECK(texture.extent().x == width);
+    CHECK(texture.extent().y == height);
+}
+
+// Opens and reads the whole file, the floor under every import of it
+size_t readFile(const fs::path& filePath)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    std::vector<char> bytes(fs::file_size(filePath));
+    file.read(bytes.data(), (std::streamsize)bytes.size());
+    return (size_t)file.gcount();
+}
+
+void benchmarkImport(const std::string& name, const fs::path& filePath)
+{
+    BENCHMARK(name + " import")
+    {
+        return teximp::importTexture(filePath);
+    };
+
+    BENCHMARK(name + " read")
+    {
+        return readFile(filePath);
+    };
+}
+
+std::string sizeSuffix(int size)
+{
+    return " " + std::to_string(size) + "x" + std::to_string(size);
+}
+}
+
+#ifdef TEXIMP_ENABLE_BITMAP
+TEST_CASE("palette expansion", "[benchmark][bitmap]")
+{
+    const int size = GENERATE(64, 256, 1024);
+    const int bitsPerPixel = GENERATE(1, 4, 8);
+
+    const std::string name = "pal" + std::to_string(bitsPerPixel) + sizeSuffix(size);
+    const fs::path filePath = writeSyntheticImage(name + ".bmp", makePalettedBitmap(size, size, bitsPerPixel));
+
+    checkImport(filePath, size, size);
+    benchmarkImport(name, filePath);
+}
+
+TEST_CASE("bitmap rle", "[benchmark][bitmap]")
+{
+    const int size = GENERATE(64, 256, 1024);
+
+    const std::string name = "rle8" + sizeSuffix(size);
+    const fs::path filePath = writeSyntheticImage(name + ".bmp", makeRle8Bitmap(size, size));
+
+    checkImport(filePath, size, size);
+    benchmarkImport(name, filePath);
+}
+
+TEST_CASE("bitfield unpack", "[benchmark][bitmap]")
+{
+    const int size = GENERATE(64, 256, 1024);
+    const int bitsPerPixel = GENERATE(16, 32);
+
+    const std::string name = "bitfields" + std::to_string(bitsPerPixel) + sizeSuffix(size);
+    const fs::path filePath = writeSyntheticImage(name + ".bmp", makeBitfieldsBitmap(size, size, bitsPerPixel));
+
+    checkImport(filePath, size, size);
+    benchmarkImport(name, filePath);
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_EXR
+// Half and float channels. The half to float kernel itself is timed in memory by "half kernels".
+TEST_CASE("exr channels", "[benchmark][exr]")
+{
+    const int size = GENERATE(64, 256, 1024);
+    const ExrPixelType pixelType = GENERATE(ExrPixelType::Half, ExrPixelType::Float);
+
+    const std::string name = ((pixelType == ExrPixelType::Half) ? "exr half" : "exr float") + sizeSuffix(size);
+    const fs::path filePath = writeSyntheticImage(name + ".exr", makeExr(size, size, pixelType));
+
+    checkImport(filePath, size, size);
+    benchmarkImport(name, filePath);
+}
+#endif
+
+// The conversions the staging and HDR reduction paths run on every half texture, one RGBA megapixel
+TEST_CASE("half kernels", "[benchmark][half]")
+{
+    constexpr size_t kCount = 1024 * 1024 * 4;
+
+    std::vector<float> floats(kCount);
+    for(size_t i = 0; i < kCount; ++i)
+    {
+        floats[i] = (float)(i % 4099) / 64.0f;
+    }
+
+    std::vector<std::byte> halves(kCount * 2);
+
+    BENCHMARK(halfConversionIsVectorized() ? "float to half f16c" : "float to half scalar")
+    {
+        floatsToHalves(floats, halves);
+        return halves[0];
+    };
+
+    BENCHMARK(halfConversionIsVectorized() ? "half to float f16c" : "half to float scalar")
+    {
+        halvesToFloats(halves, floats);
+        return floats[0];
+    };
+}
+
+// The preview an interlaced decode hands out after its first pass fills all but 1/64 of the image, the most of any
+// pass, so this bounds what the callbacks add to a decode. One RGBA megapixel.
+TEST_CASE("adam7 preview", "[benchmark][interlace]")
+{
+    constexpr int kSize = 1024;
+    constexpr size_t kPixelBytes = 4;
+
+    std::vector<std::byte> image((size_t)kSize * kSize * kPixelBytes);
+
+    BENCHMARK("adam7 preview first pass")
+    {
+        fillAdam7Preview(image, kSize, kSize, kPixelBytes, 1);
+        return image[0];
+    };
+
+    BENCHMARK("adam7 preview sixth pass")
+    {
+        fillAdam7Preview(image, kSize, kSize, kPixelBytes, 6);
+        return image[0];
+    };
+}
+
+#ifdef TEXIMP_ENABLE_PNG
+TEST_CASE("png unfilter", "[benchmark][png]")
+{
+    constexpr std::array kFilterNames = {"none", "sub", "up", "average", "paeth"};
+
+    const int size = GENERATE(64, 256, 1024);
+    const int bitDepth = GENERATE(8, 16);
+    const PngFilter filter = GENERATE(PngFilter::None, PngFilter::Sub, PngFilter::Up, PngFilter::Average, PngFilter::Paeth);
+
+    const std::string name = std::string(kFilterNames[(size_t)filter]) + " rgba" + std::to_string(bitDepth) + sizeSuffix(size);
+    const fs::path filePath = writeSyntheticImage(name + ".png", makePng({size, size, PngColorType::Rgba, bitDepth, filter}));
+
+    checkImport(filePath, size, size);
+    benchmarkImport(name, filePath);
+}
+
+// Every pixel size the unfilter kernels specialize on, 1 to 8 bytes, and Adam7's short rows
+TEST_CASE("png unfilter pixel sizes", "[benchmark][png]")
+{
+    constexpr std::array kFilterNames = {"none", "sub", "up", "average", "paeth"};
+    constexpr int kSize = 1024;
+
+    const auto [layoutName, colorType, bitDepth] = GENERATE(std::tuple{"gray8", PngColorType::Gray, 8},
+                                                            std::tuple{"gray16", PngColorType::Gray, 16},
+                                                            std::tuple{"rgb8", PngColorType::Rgb, 8},
+                                                            std::tuple{"rgb16", PngColorType::Rgb, 16});
+    const PngFilter filter = GENERATE(PngFilter::Sub, PngFilter::Average, PngFilter::Paeth);
+    const bool interlaced = GENERATE(false, true);
+
+    const std::string name = std::string(kFilterNames[(size_t)filter]) + " " + layoutName + (interlaced ? " adam7" : "") + sizeSuffix(kSize);
+    const fs::path filePath = writeSyntheticImage(name + ".png", makePng({kSize, kSize, colorType, bitDepth, filter, interlaced}));
+
+    checkImport(filePath, kSize, kSize);
+    benchmarkImport(name, filePath);
+}
+
+// Inflate bound imports, the baseline for comparing inflate backends. Rows are Sub filtered, "sub rgba8" above is
+// the same image size with inflate reduced to a copy.
+TEST_CASE("png inflate", "[benchmark][png]")
+{
+    const int size = GENERATE(64, 256, 1024);
+
+    const std::string name = "deflated rgba8" + sizeSuffix(size);
+    const fs::path filePath = writeSyntheticImage(name + ".png", makeDeflatedPng(size, size));
+
+    checkImport(filePath, size, size);
+    benchmarkImport(name, filePath);
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_TARGA
+TEST_CASE("targa rle", "[benchmark][targa]")
+{
+    const int size = GENERATE(64, 256, 1024);
+
+    const std::string name = "rle32" + sizeSuffix(size);
+    const fs::path filePath = writeSyntheticImage(name + ".tga", makeTarga(size, size, true, true));
+
+    checkImport(filePath, size, size);
+    benchmarkImport(name, filePath);
+}
+
+TEST_CASE("vertical flip", "[benchmark][targa]")
+{
+    const int size = GENERATE(64, 256, 1024);
+    const bool topLeftOrigin = GENERATE(true, false);
+
+    // The top left origin case needs no flip and is the baseline the bottom left case is compared against
+    const std::string name = (topLeftOrigin ? "top left" : "bottom left") + sizeSuffix(size);
+    const fs::path filePath = writeSyntheticImage(name + ".tga", makeTarga(size, size, topLeftOrigin, false));
+
+    checkImport(filePath, size, size);
+    benchmarkImport(name, filePath);
+}
+#endif
@@ -0,0 +1,52 @@
+#include "crc32.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace
+{
+uint32_t bitwiseCrc32(std::span<const std::byte> bytes, uint32_t crc)
+{
+    crc = ~crc;
+    for(const std::byte value : bytes)
+    {
+        crc ^= (uint32_t)value;
+        for(int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 1) ? 0xedb88320u ^ (crc >> 1) : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+}
+
+TEST_CASE("crc32", "[crc32]")
+{
+    constexpr std::string_view kCheck = "123456789";
+    CHECK(crc32(std::as_bytes(std::span(kCheck))) == 0xcbf43926u);
+    CHECK(crc32({}) == 0);
+
+    std::vector<std::byte> data(4096 + 64);
+    uint32_t state = 1;
+    for(std::byte& value : data)
+    {
+        state = state * 1103515245u + 12345u;
+        value = (std::byte)(state >> 24);
+    }
+
+    // Every length around the 16 and 64 byte folding steps, from unaligned starts, with a running CRC passed in
+    for(size_t offset = 0; offset < 16; ++offset)
+    {
+        for(size_t size = 0; size + offset <= data.size(); size += (size < 300) ? 1 : 61)
+        {
+            const std::span<const std::byte> bytes = std::span(data).subspan(offset, size);
+            REQUIRE(crc32(bytes, (uint32_t)size) == bitwiseCrc32(bytes, (uint32_t)size));
+        }
+    }
+
+    CHECK(crc32(std::span(data).subspan(1000), crc32(std::span(data).first(1000))) == crc32(data));
+}
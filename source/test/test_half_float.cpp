@@ -0,0 +1,74 @@
+#include "half_float.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <vector>
+
+TEST_CASE("half special values", "[half]")
+{
+    CHECK(floatToHalf(std::numeric_limits<float>::infinity()) == 0x7c00);
+    CHECK(floatToHalf(-std::numeric_limits<float>::infinity()) == 0xfc00);
+    CHECK(floatToHalf(std::numeric_limits<float>::denorm_min()) == 0x0000);
+    CHECK(floatToHalf(-std::numeric_limits<float>::denorm_min()) == 0x8000);
+
+    // NaNs are quieted and keep the top of their payload
+    CHECK(floatToHalf(std::numeric_limits<float>::quiet_NaN()) == 0x7e00);
+    CHECK(floatToHalf(std::bit_cast<float>(0x7f800001u)) == 0x7e00);
+    CHECK(floatToHalf(std::bit_cast<float>(0xff802000u)) == 0xfe01);
+
+    CHECK(std::isinf(halfToFloat(0x7c00)));
+    CHECK(std::bit_cast<uint32_t>(halfToFloat(0x7c01)) == 0x7fc02000u);
+    CHECK(std::bit_cast<uint32_t>(halfToFloat(0x8000)) == 0x80000000u);
+    CHECK(halfToFloat(0x0001) == std::ldexp(1.0f, -24));
+    CHECK(halfToFloat(0x03ff) == std::ldexp(1023.0f, -24));
+}
+
+TEST_CASE("bulk half conversion", "[half]")
+{
+    // Every half, plus a few so the vector loop leaves a tail
+    constexpr size_t kCount = 65536 + 5;
+
+    std::vector<std::byte> halves(kCount * 2);
+    for(size_t i = 0; i < kCount; ++i)
+    {
+        const uint16_t half = (uint16_t)i;
+        std::memcpy(halves.data() + i * 2, &half, sizeof(half));
+    }
+
+    std::vector<float> floats(kCount);
+    halvesToFloats(halves, floats);
+
+    for(size_t i = 0; i < kCount; ++i)
+    {
+        REQUIRE(std::bit_cast<uint32_t>(floats[i]) == std::bit_cast<uint32_t>(halfToFloat((uint16_t)i)));
+    }
+
+    // Floats around every half, rounding ties, denormals, overflow and NaN payloads included. Starting at an odd
+    // offset keeps the accesses unaligned.
+    std::vector<float> source;
+    for(uint32_t half = 0; half < 0x10000; half += 7)
+    {
+        const uint32_t bits = std::bit_cast<uint32_t>(halfToFloat((uint16_t)half));
+        for(const uint32_t offset : {0u, 1u, 0xfffu, 0x1000u, 0x1001u, 0x1fffu})
+        {
+            source.push_back(std::bit_cast<float>(bits + offset));
+        }
+    }
+
+    std::vector<std::byte> converted(source.size() * 2 + 1);
+    const std::span<std::byte> destination = std::span(converted).subspan(1);
+    floatsToHalves(source, destination);
+
+    for(size_t i = 0; i < source.size(); ++i)
+    {
+        uint16_t half;
+        std::memcpy(&half, destination.data() + i * 2, sizeof(half));
+        REQUIRE(half == floatToHalf(source[i]));
+    }
+}
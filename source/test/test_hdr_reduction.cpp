@@ -0,0 +1,155 @@
+#include "hdr_reduction.h"
+#include "staging_format.h"
+#include "synthetic_images.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cputex/definitions.h>
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace
+{
+// A smooth gradient with a bright spot, like a sky, for RGBA32F texture data. A negative alpha ramps alpha with x.
+auto skyGradient(int width, int height, float alpha, float scale)
+{
+    return [=](size_t i)
+    {
+        const float x = (float)((i / 4) % (size_t)width) / (float)width;
+        const float y = (float)((i / 4) / (size_t)width) / (float)height;
+
+        switch(i % 4)
+        {
+        case 0: return scale * (0.2f + x * y * 40.0f);
+        case 1: return scale * (0.3f + x * 10.0f);
+        case 2: return scale * (0.5f + y * 3.0f);
+        default: return (alpha < 0.0f) ? x : alpha;
+        }
+    };
+}
+}
+
+TEST_CASE("b10g11r11 packing", "[hdr]")
+{
+    CHECK(unpackB10G11R11(packB10G11R11({1.0f, 0.5f, 2.0f})) == std::array{1.0f, 0.5f, 2.0f});
+    CHECK(unpackB10G11R11(packB10G11R11({65024.0f, 0.0f, 64512.0f})) == std::array{65024.0f, 0.0f, 64512.0f});
+
+    // Ties round to even
+    CHECK(unpackB10G11R11(packB10G11R11({1.0f + std::ldexp(1.0f, -7), 0.0f, 0.0f}))[0] == 1.0f);
+    CHECK(unpackB10G11R11(packB10G11R11({1.0f + 3.0f * std::ldexp(1.0f, -7), 0.0f, 0.0f}))[0] == 1.0f + std::ldexp(1.0f, -5));
+
+    CHECK(packB10G11R11({-1.0f, std::numeric_limits<float>::quiet_NaN(), 0.0f}) == 0);
+    CHECK(std::isinf(unpackB10G11R11(packB10G11R11({std::numeric_limits<float>::infinity(), 0.0f, 0.0f}))[0]));
+    CHECK(std::isinf(unpackB10G11R11(packB10G11R11({70000.0f, 0.0f, 0.0f}))[0]));
+
+    // Every finite value survives a round trip, denormals included
+    for(uint32_t value = 0; value < (31u << 6); ++value)
+    {
+        REQUIRE(packB10G11R11({unpackB10G11R11(value)[0], 0.0f, 0.0f}) == value);
+    }
+
+    for(uint32_t value = 0; value < (31u << 5); ++value)
+    {
+        REQUIRE(packB10G11R11({0.0f, 0.0f, unpackB10G11R11(value << 22)[2]}) == value << 22);
+    }
+}
+
+TEST_CASE("e5b9g9r9 packing", "[hdr]")
+{
+    CHECK(unpackE5B9G9R9(packE5B9G9R9({1.0f, 0.5f, 0.25f})) == std::array{1.0f, 0.5f, 0.25f});
+    CHECK(unpackE5B9G9R9(packE5B9G9R9({65408.0f, 0.0f, 0.0f}))[0] == 65408.0f);
+    CHECK(unpackE5B9G9R9(packE5B9G9R9({1.0e9f, 0.0f, 0.0f}))[0] == 65408.0f);
+    CHECK(packE5B9G9R9({-1.0f, std::numeric_limits<float>::quiet_NaN(), 0.0f}) == 0);
+
+    // Rounding up to the next power of two moves the shared exponent
+    const std::array<float, 3> roundedUp = unpackE5B9G9R9(packE5B9G9R9({2.0f - std::ldexp(1.0f, -10), 0.0f, 0.0f}));
+    CHECK(roundedUp[0] == 2.0f);
+
+    // Components share the brightest one's exponent
+    const std::array<float, 3> shared = unpackE5B9G9R9(packE5B9G9R9({100.0f, 0.01f, 1.0f}));
+    CHECK(shared[0] == 100.0f);
+    CHECK(shared[1] == 0.0f);
+    CHECK(std::abs(shared[2] - 1.0f) <= 0.125f);
+}
+
+TEST_CASE("choose hdr reduction", "[hdr]")
+{
+    HdrReductionOptions options;
+
+    SECTION("opaque content packs")
+    {
+        const cputex::UniqueTexture texture = makeTexture<float>(gpufmt::Format::R32G32B32A32_SFLOAT, 64, 32, 1, skyGradient(64, 32, 1.0f, 1.0f));
+
+        const std::optional<HdrReduction> reduction = chooseHdrReduction(texture, options);
+        REQUIRE(reduction);
+        CHECK(reduction->format == gpufmt::Format::E5B9G9R9_UFLOAT_PACK32);
+        CHECK(reduction->maxRelativeError > 0.0f);
+        CHECK(reduction->maxRelativeError <= std::ldexp(1.0f, -9));
+        CHECK(reduction->maxAbsoluteError > 0.0f);
+
+        const cputex::TextureView view = texture;
+        std::vector<std::byte> destination(view.sizeInBytes() / 4);
+        REQUIRE(reduceHdrPixels(view.getData(), view.format(), destination, reduction->format));
+
+        const std::span<const float> source = view.getData<float>();
+        uint32_t packed = 0;
+        std::memcpy(&packed, destination.data() + 4 * 100, sizeof(packed));
+        CHECK(packed == packE5B9G9R9({source[400], source[401], source[402]}));
+    }
+
+    SECTION("alpha needs half")
+    {
+        const cputex::UniqueTexture texture = makeTexture<float>(gpufmt::Format::R32G32B32A32_SFLOAT, 64, 32, 1, skyGradient(64, 32, -1.0f, 1.0f));
+
+        const std::optional<HdrReduction> reduction = chooseHdrReduction(texture, options);
+        REQUIRE(reduction);
+        CHECK(reduction->format == gpufmt::Format::R16G16B16A16_SFLOAT);
+        CHECK(reduction->maxRelativeError <= std::ldexp(1.0f, -11));
+
+        const cputex::TextureView view = texture;
+        std::vector<std::byte> destination(view.sizeInBytes() / 2);
+        REQUIRE(reduceHdrPixels(view.getData(), view.format(), destination, reduction->format));
+
+        uint16_t half = 0;
+        std::memcpy(&half, destination.data() + 8 * 10 + 6, sizeof(half));
+        CHECK(half == floatToHalf(view.getData<float>()[4 * 10 + 3]));
+    }
+
+    SECTION("beyond half range is kept")
+    {
+        const cputex::UniqueTexture texture = makeTexture<float>(gpufmt::Format::R32G32B32A32_SFLOAT, 16, 16, 1, skyGradient(16, 16, -1.0f, 10000.0f));
+
+        const std::optional<HdrReduction> reduction = chooseHdrReduction(texture, options);
+        REQUIRE(reduction);
+        CHECK(reduction->format == gpufmt::Format::UNDEFINED);
+        CHECK(std::isinf(reduction->maxRelativeError));
+    }
+
+    SECTION("tight bound")
+    {
+        options.maxRelativeError = 0.0f;
+
+        const cputex::UniqueTexture texture = makeTexture<float>(gpufmt::Format::R32G32B32A32_SFLOAT, 16, 16, 1, skyGradient(16, 16, 1.0f, 1.0f));
+
+        const std::optional<HdrReduction> reduction = chooseHdrReduction(texture, options);
+        REQUIRE(reduction);
+        CHECK(reduction->format == gpufmt::Format::UNDEFINED);
+    }
+
+    SECTION("other formats")
+    {
+        cputex::TextureParams params;
+        params.format = gpufmt::Format::R8G8B8A8_UNORM;
+        params.dimension = cputex::TextureDimension::Texture2D;
+        params.extent = cputex::Extent{4, 4, 1};
+
+        CHECK_FALSE(chooseHdrReduction(cputex::UniqueTexture(params), options));
+    }
+}
@@ -0,0 +1,97 @@
+#include "image_resample.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <cmath>
+#include <span>
+#include <vector>
+
+namespace
+{
+std::vector<float> resample(const std::vector<float>& source, int sourceWidth, int sourceHeight, int width, int height, ResampleFilter filter)
+{
+    ImageResampler resampler(sourceWidth, sourceHeight, width, height, filter);
+
+    for(int y = 0; y < sourceHeight; ++y)
+    {
+        resampler.addRow(std::span(source).subspan((size_t)y * sourceWidth * 4, (size_t)sourceWidth * 4));
+    }
+
+    const std::span<const float> pixels = resampler.pixels();
+    return std::vector<float>(pixels.begin(), pixels.end());
+}
+}
+
+TEST_CASE("box filter averages whole pixels", "[resample]")
+{
+    // 4x2 to 2x1, every destination pixel is the mean of a 2x2 block
+    std::vector<float> source(4 * 2 * 4);
+    for(size_t i = 0; i < source.size(); ++i)
+    {
+        source[i] = (float)i;
+    }
+
+    const std::vector<float> pixels = resample(source, 4, 2, 2, 1, ResampleFilter::Box);
+    REQUIRE(pixels.size() == 2 * 4);
+
+    for(int x = 0; x < 2; ++x)
+    {
+        for(int component = 0; component < 4; ++component)
+        {
+            const auto at = [&](int sourceX, int sourceY) { return source[(size_t)(sourceY * 4 + sourceX) * 4 + component]; };
+            const float expected = (at(x * 2, 0) + at(x * 2 + 1, 0) + at(x * 2, 1) + at(x * 2 + 1, 1)) / 4.0f;
+            CHECK(std::abs(pixels[(size_t)x * 4 + component] - expected) <= 1e-4f);
+        }
+    }
+}
+
+TEST_CASE("resampling keeps constant images constant", "[resample]")
+{
+    const ResampleFilter filter = GENERATE(ResampleFilter::Box, ResampleFilter::Lanczos3);
+    // Fractional factors down and up, the weights at the edges are clipped and renormalized
+    const auto [width, height] = GENERATE(std::pair{10, 7}, std::pair{1, 1}, std::pair{50, 40});
+
+    const std::vector<float> source = [&]()
+    {
+        std::vector<float> values(37 * 23 * 4);
+        for(size_t i = 0; i < values.size(); i += 4)
+        {
+            values[i + 0] = 0.25f;
+            values[i + 1] = 0.5f;
+            values[i + 2] = 0.75f;
+            values[i + 3] = 1.0f;
+        }
+        return values;
+    }();
+
+    const std::vector<float> pixels = resample(source, 37, 23, width, height, filter);
+    REQUIRE(pixels.size() == (size_t)width * height * 4);
+
+    for(size_t i = 0; i < pixels.size(); i += 4)
+    {
+        CHECK(std::abs(pixels[i + 0] - 0.25f) <= 1e-5f);
+        CHECK(std::abs(pixels[i + 1] - 0.5f) <= 1e-5f);
+        CHECK(std::abs(pixels[i + 2] - 0.75f) <= 1e-5f);
+        CHECK(std::abs(pixels[i + 3] - 1.0f) <= 1e-5f);
+    }
+}
+
+TEST_CASE("resampling to the same size copies", "[resample]")
+{
+    const ResampleFilter filter = GENERATE(ResampleFilter::Box, ResampleFilter::Lanczos3);
+
+    std::vector<float> source(9 * 5 * 4);
+    for(size_t i = 0; i < source.size(); ++i)
+    {
+        source[i] = (float)((i * 37) % 101) / 100.0f;
+    }
+
+    const std::vector<float> pixels = resample(source, 9, 5, 9, 5, filter);
+    REQUIRE(pixels.size() == source.size());
+
+    for(size_t i = 0; i < pixels.size(); ++i)
+    {
+        CHECK(std::abs(pixels[i] - source[i]) <= 1e-5f);
+    }
+}
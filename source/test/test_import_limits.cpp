@@ -0,0 +1,217 @@
+#include "import_limits.h"
+#include "synthetic_images.h"
+#include "texture_probe.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <teximp/teximp.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+void patchU32le(std::vector<std::byte>& contents, size_t offset, uint32_t value)
+{
+    for(size_t i = 0; i < 4; ++i)
+    {
+        contents[offset + i] = (std::byte)((value >> (i * 8)) & 0xff);
+    }
+}
+
+// Inserts a tiles attribute into an EXR header, it is the only thing telling the probe about levels
+std::vector<std::byte> withExrTiles(std::vector<std::byte> contents, uint8_t mode)
+{
+    constexpr std::string_view kAttribute("tiles\0tiledesc\0", 15);
+
+    std::vector<std::byte> attribute(kAttribute.size() + 4 + 9);
+    std::memcpy(attribute.data(), kAttribute.data(), kAttribute.size());
+    patchU32le(attribute, kAttribute.size(), 9);
+    patchU32le(attribute, kAttribute.size() + 4, 16);
+    patchU32le(attribute, kAttribute.size() + 8, 16);
+    attribute.back() = (std::byte)mode;
+
+    contents.insert(contents.begin() + 8, attribute.begin(), attribute.end());
+    return contents;
+}
+
+// Only the directories of a little endian TIFF, each one an RGBA8 image of the given size, enough for the probe
+std::vector<std::byte> makeTiffDirectories(const std::vector<std::pair<uint16_t, uint16_t>>& sizes, bool loopBack)
+{
+    constexpr size_t kDirectoryBytes = 2 + 3 * 12 + 4;
+    std::vector<std::byte> contents(8 + sizes.size() * kDirectoryBytes);
+
+    const auto patchU16le = [&contents](size_t offset, uint16_t value)
+    {
+        contents[offset] = (std::byte)(value & 0xff);
+        contents[offset + 1] = (std::byte)(value >> 8);
+    };
+
+    std::memcpy(contents.data(), "II*\0", 4);
+    patchU32le(contents, 4, 8);
+
+    for(size_t i = 0; i < sizes.size(); ++i)
+    {
+        const size_t offset = 8 + i * kDirectoryBytes;
+        patchU16le(offset, 3);
+
+        const std::array<std::pair<uint16_t, uint16_t>, 3> entries = {{{256, sizes[i].first}, {257, sizes[i].second}, {277, 4}}};
+        for(size_t entry = 0; entry < entries.size(); ++entry)
+        {
+            const size_t entryOffset = offset + 2 + entry * 12;
+            patchU16le(entryOffset, entries[entry].first);
+            patchU16le(entryOffset + 2, 3); // SHORT
+            patchU32le(contents, entryOffset + 4, 1);
+            patchU16le(entryOffset + 8, entries[entry].second);
+        }
+
+        const bool last = i + 1 == sizes.size();
+        patchU32le(contents, offset + 2 + entries.size() * 12, last ? (loopBack ? 8 : 0) : (uint32_t)(offset + kDirectoryBytes));
+    }
+
+    return contents;
+}
+}
+
+#ifdef TEXIMP_ENABLE_BITMAP
+TEST_CASE("probe bitmap", "[limits][bitmap]")
+{
+    const std::optional<TextureProbe> probe = probeTexture(writeSyntheticImage("probe.bmp", makePalettedBitmap(33, 17, 8)));
+
+    REQUIRE(probe.has_value());
+    CHECK(probe->fileFormat == teximp::FileFormat::Bitmap);
+    CHECK(probe->width == 33);
+    CHECK(probe->height == 17);
+    CHECK(probe->decodedBytes == 33 * 17 * 4);
+}
+
+TEST_CASE("limits reject declared sizes", "[limits][bitmap]")
+{
+    // Same shape as bmpsuite's reallybig.bmp: a small file declaring a huge image
+    std::vector<std::byte> contents = makePalettedBitmap(16, 16, 8);
+    patchU32le(contents, 18, 3000000);
+    patchU32le(contents, 22, 2000000);
+
+    const fs::path filePath = writeSyntheticImage("reallybig.bmp", contents);
+    const std::optional<TextureProbe> probe = probeTexture(filePath);
+    REQUIRE(probe.has_value());
+
+    CHECK(checkImportLimits(*probe, ImportLimits{}) == ImportLimitError::None);
+    CHECK(checkImportLimits(*probe, ImportLimits{.maxPixels = 1 << 24}) == ImportLimitError::TooManyPixels);
+    CHECK(checkImportLimits(*probe, ImportLimits{.maxBytes = 1 << 30}) == ImportLimitError::TooManyBytes);
+    CHECK(checkImportLimits(*probe, ImportLimits{.maxDecompressedRatio = 1000.0}) == ImportLimitError::DecompressedRatioTooHigh);
+
+    // The same limits must let a file through when its header is honest
+    const std::optional<TextureProbe> honestProbe = probeTexture(writeSyntheticImage("honest.bmp", makePalettedBitmap(256, 256, 8)));
+    REQUIRE(honestProbe.has_value());
+    CHECK(checkImportLimits(*honestProbe, ImportLimits{.maxPixels = 1 << 24, .maxBytes = 1 << 30, .maxDecompressedRatio = 1000.0}) == ImportLimitError::None);
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_DDS
+TEST_CASE("probe dds", "[limits][dds]")
+{
+    const std::optional<TextureProbe> probe = probeTexture(writeSyntheticImage("probe.dds", makeBcDds(64, 32, BcFormat::Bc1)));
+
+    REQUIRE(probe.has_value());
+    CHECK(probe->fileFormat == teximp::FileFormat::Dds);
+    CHECK(probe->width == 64);
+    CHECK(probe->height == 32);
+    CHECK(probe->decodedBytes == (64 / 4) * (32 / 4) * 8);
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_EXR
+TEST_CASE("probe exr", "[limits][exr]")
+{
+    const std::optional<TextureProbe> probe = probeTexture(writeSyntheticImage("probe.exr", makeExr(40, 30, ExrPixelType::Half)));
+
+    REQUIRE(probe.has_value());
+    CHECK(probe->fileFormat == teximp::FileFormat::Exr);
+    CHECK(probe->width == 40);
+    CHECK(probe->height == 30);
+    CHECK(probe->decodedBytes == 40 * 30 * 4 * 2);
+}
+
+TEST_CASE("probe exr levels", "[limits][exr]")
+{
+    const std::vector<std::byte> contents = makeExr(40, 30, ExrPixelType::Half);
+    constexpr uint64_t kPixelBytes = 4 * 2;
+
+    SECTION("mipmap rounding down")
+    {
+        const std::optional<TextureProbe> probe = probeTexture(writeSyntheticImage("probe mipmap.exr", withExrTiles(contents, 0x01)));
+        REQUIRE(probe.has_value());
+        CHECK(probe->mips == 6);
+        CHECK(probe->decodedBytes == (40 * 30 + 20 * 15 + 10 * 7 + 5 * 3 + 2 * 1 + 1 * 1) * kPixelBytes);
+    }
+
+    SECTION("mipmap rounding up")
+    {
+        const std::optional<TextureProbe> probe = probeTexture(writeSyntheticImage("probe mipmap up.exr", withExrTiles(contents, 0x11)));
+        REQUIRE(probe.has_value());
+        CHECK(probe->mips == 7);
+        CHECK(probe->decodedBytes == (40 * 30 + 20 * 15 + 10 * 8 + 5 * 4 + 3 * 2 + 2 * 1 + 1 * 1) * kPixelBytes);
+    }
+
+    SECTION("ripmap and unknown level modes")
+    {
+        const uint8_t mode = GENERATE(0x02, 0x0f);
+
+        const std::optional<TextureProbe> probe = probeTexture(writeSyntheticImage("probe ripmap.exr", withExrTiles(contents, mode)));
+        REQUIRE(probe.has_value());
+        CHECK(probe->decodedBytes == (40 + 20 + 10 + 5 + 2 + 1) * (30 + 15 + 7 + 3 + 1) * kPixelBytes);
+    }
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_PNG
+TEST_CASE("probe png", "[limits][png]")
+{
+    const std::optional<TextureProbe> probe = probeTexture(writeSyntheticImage("probe.png", makePng({300, 70, PngColorType::Rgba, 16, PngFilter::None})));
+
+    REQUIRE(probe.has_value());
+    CHECK(probe->fileFormat == teximp::FileFormat::Png);
+    CHECK(probe->width == 300);
+    CHECK(probe->height == 70);
+    CHECK(probe->decodedBytes == 300 * 70 * 8);
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_TARGA
+TEST_CASE("probe targa", "[limits][targa]")
+{
+    const std::optional<TextureProbe> probe = probeTexture(writeSyntheticImage("probe.tga", makeTarga(64, 48, false, true)));
+
+    REQUIRE(probe.has_value());
+    CHECK(probe->fileFormat == teximp::FileFormat::Targa);
+    CHECK(probe->width == 64);
+    CHECK(probe->height == 48);
+    CHECK(probe->decodedBytes == 64 * 48 * 4);
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_TIFF
+TEST_CASE("probe tiff counts every directory", "[limits][tiff]")
+{
+    const std::optional<TextureProbe> probe = probeTexture(writeSyntheticImage("probe.tif", makeTiffDirectories({{64, 32}, {32, 16}, {100, 100}}, false)));
+
+    REQUIRE(probe.has_value());
+    CHECK(probe->fileFormat == teximp::FileFormat::Tiff);
+    CHECK(probe->width == 64);
+    CHECK(probe->height == 32);
+    CHECK(probe->decodedBytes == (64 * 32 + 32 * 16 + 100 * 100) * 4);
+
+    // A directory chain that loops cannot be bounded
+    CHECK_FALSE(probeTexture(writeSyntheticImage("probe loop.tif", makeTiffDirectories({{64, 32}, {32, 16}}, true))).has_value());
+}
+#endif
@@ -0,0 +1,44 @@
+#include "import_pipeline.h"
+#include "synthetic_images.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+#ifdef TEXIMP_ENABLE_BITMAP
+TEST_CASE("import pipeline", "[pipeline]")
+{
+    std::vector<fs::path> filePaths;
+    for(int i = 0; i < 24; ++i)
+    {
+        filePaths.push_back(writeSyntheticImage("pipeline" + std::to_string(i) + ".bmp", makePalettedBitmap(32 + i, 16, 8)));
+    }
+
+    // Missing files fail in decode and must not stall the stages after it
+    filePaths.push_back(syntheticImageDirectory() / "pipeline_missing.bmp");
+
+    ImportPipelineOptions options;
+    options.readThreadCount = 2;
+    options.decodeThreadCount = 3;
+    options.queueDepth = 2;
+
+    const ImportPipelineResult result = runImportPipeline(filePaths, options);
+
+    CHECK(result.importCount == 25);
+    CHECK(result.errorCount == 1);
+    CHECK(result.stages[(size_t)ImportPipelineStage::Read].itemCount == 25);
+    CHECK(result.stages[(size_t)ImportPipelineStage::Stage].itemCount == 24);
+
+    uint64_t expectedBytes = 0;
+    for(int i = 0; i < 24; ++i)
+    {
+        expectedBytes += (32 + i) * 16 * 4;
+    }
+
+    CHECK(result.stagedBytes >= expectedBytes);
+}
+#endif
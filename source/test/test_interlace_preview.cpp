@@ -0,0 +1,91 @@
+#include "interlace_preview.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr size_t kPixelBytes = 3;
+
+// Every pixel distinct, so a preview pixel copied from the wrong place shows
+std::vector<std::byte> makeImage(int width, int height)
+{
+    std::vector<std::byte> image((size_t)width * height * kPixelBytes);
+    for(size_t i = 0; i < image.size(); ++i)
+    {
+        image[i] = (std::byte)(i * 7 + i / 256);
+    }
+    return image;
+}
+}
+
+TEST_CASE("adam7 pass extents", "[interlace]")
+{
+    constexpr std::array<std::array<int, 2>, 5> kSizes = {{{1, 1}, {3, 2}, {8, 8}, {37, 23}, {64, 1}}};
+
+    for(const std::array<int, 2>& size : kSizes)
+    {
+        INFO(std::to_string(size[0]) + "x" + std::to_string(size[1]));
+
+        int pixelCount = 0;
+        for(int pass = 0; pass < (int)kAdam7Passes.size(); ++pass)
+        {
+            pixelCount += adam7PassWidth(size[0], pass) * adam7PassHeight(size[1], pass);
+        }
+        CHECK(pixelCount == size[0] * size[1]);
+    }
+
+    // A single pixel is all in the first pass
+    CHECK(adam7PassWidth(1, 0) == 1);
+    CHECK(adam7PassWidth(1, 1) == 0);
+    CHECK(adam7PassHeight(1, 2) == 0);
+    CHECK(adam7PassWidth(37, 5) == 18);
+    CHECK(adam7PassHeight(23, 6) == 11);
+}
+
+TEST_CASE("adam7 preview after each pass", "[interlace]")
+{
+    constexpr std::array<int, 7> kBlockWidths = {8, 4, 4, 2, 2, 1, 1};
+    constexpr std::array<int, 7> kBlockHeights = {8, 8, 4, 4, 2, 2, 1};
+    // Widths that end mid block and images smaller than the first block
+    constexpr std::array<std::array<int, 2>, 4> kSizes = {{{1, 1}, {5, 3}, {37, 23}, {64, 16}}};
+
+    for(const std::array<int, 2>& size : kSizes)
+    {
+        const int width = size[0];
+        const int height = size[1];
+        const std::vector<std::byte> original = makeImage(width, height);
+        int callbackCount = 0;
+
+        replayAdam7Passes(original, width, height, kPixelBytes, [&](std::span<const std::byte> preview, int completedPasses)
+            {
+                INFO(std::to_string(width) + "x" + std::to_string(height) + " pass " + std::to_string(completedPasses));
+                CHECK(completedPasses == ++callbackCount);
+
+                bool matches = true;
+                for(int y = 0; y < height && matches; ++y)
+                {
+                    for(int x = 0; x < width && matches; ++x)
+                    {
+                        const int decodedX = x - x % kBlockWidths[completedPasses - 1];
+                        const int decodedY = y - y % kBlockHeights[completedPasses - 1];
+                        matches = std::memcmp(preview.data() + ((size_t)y * width + x) * kPixelBytes,
+                                              original.data() + ((size_t)decodedY * width + decodedX) * kPixelBytes, kPixelBytes) == 0;
+                    }
+                }
+                CHECK(matches);
+
+                if(completedPasses == 7)
+                {
+                    CHECK(std::ranges::equal(preview, original));
+                }
+            });
+
+        CHECK(callbackCount == 7);
+    }
+}
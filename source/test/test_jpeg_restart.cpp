@@ -0,0 +1,229 @@
+#include "jpeg_restart.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace
+{
+struct JpegSkeletonParams
+{
+    int width = 64;
+    int height = 48;
+    // Sampling factors of each component, 0x22 is 2x2
+    std::vector<uint8_t> sampling = {0x22, 0x11, 0x11};
+    uint8_t frameMarker = 0xc0;
+    uint16_t restartInterval = 5;
+    int segmentCount = 3;
+    // Number of the restart marker after each segment, RST0 to RST7 in turn when empty
+    std::vector<int> restartMarkers;
+    bool secondScan = false;
+    bool endOfImage = true;
+};
+
+struct JpegSkeleton
+{
+    std::vector<std::byte> bytes;
+    std::vector<std::array<uint64_t, 2>> segmentRanges;
+};
+
+// Marker structure of a baseline JPEG with made up entropy coded data. Tables are left out, only the markers the
+// restart scan looks at are written. Every segment has a stuffed 0xFF byte and some fill.
+JpegSkeleton makeJpegSkeleton(const JpegSkeletonParams& params)
+{
+    JpegSkeleton skeleton;
+    std::vector<std::byte>& bytes = skeleton.bytes;
+
+    const auto u8 = [&](uint32_t value) { bytes.push_back((std::byte)value); };
+    const auto u16 = [&](uint32_t value) { u8(value >> 8); u8(value & 0xff); };
+
+    u16(0xffd8);
+
+    // APP0 with a few payload bytes, skipped by length
+    u16(0xffe0);
+    u16(2 + 5);
+    for(const char c : {'J', 'F', 'I', 'F', '\0'}) { u8((uint8_t)c); }
+
+    u16(0xff00 | params.frameMarker);
+    u16(8 + 3 * (uint32_t)params.sampling.size());
+    u8(8);
+    u16(params.height);
+    u16(params.width);
+    u8((uint32_t)params.sampling.size());
+    for(size_t i = 0; i < params.sampling.size(); ++i)
+    {
+        u8((uint32_t)i + 1);
+        u8(params.sampling[i]);
+        u8(0);
+    }
+
+    if(params.restartInterval != 0)
+    {
+        u16(0xffdd);
+        u16(4);
+        u16(params.restartInterval);
+    }
+
+    const auto scan = [&]()
+    {
+        u16(0xffda);
+        u16(6 + 2 * (uint32_t)params.sampling.size());
+        u8((uint32_t)params.sampling.size());
+        for(size_t i = 0; i < params.sampling.size(); ++i)
+        {
+            u8((uint32_t)i + 1);
+            u8(0);
+        }
+        u8(0);
+        u8(63);
+        u8(0);
+
+        for(int segment = 0; segment < params.segmentCount; ++segment)
+        {
+            const uint64_t start = bytes.size();
+
+            for(int i = 0; i < 20 + segment; ++i)
+            {
+                u8((uint32_t)(segment * 37 + i * 11) % 255);
+            }
+            u16(0xff00);
+            u8(0x5a);
+
+            skeleton.segmentRanges.push_back({start, bytes.size() - start});
+
+            if(segment + 1 < params.segmentCount)
+            {
+                const int restart = params.restartMarkers.empty() ? segment % 8 : params.restartMarkers[segment];
+                // Fill in front of the marker
+                u8(0xff);
+                u16(0xffd0 + (uint32_t)restart);
+            }
+        }
+    };
+
+    scan();
+
+    if(params.secondScan)
+    {
+        scan();
+    }
+
+    if(params.endOfImage)
+    {
+        u16(0xffd9);
+    }
+
+    return skeleton;
+}
+}
+
+TEST_CASE("jpeg restart segments", "[jpeg]")
+{
+    SECTION("interleaved 4:2:0")
+    {
+        // 16x16 MCUs, 4 by 3 of them, in segments of 5, 5 and 2
+        const JpegSkeleton skeleton = makeJpegSkeleton({});
+
+        const std::optional<JpegRestartLayout> layout = findJpegRestartSegments(skeleton.bytes);
+        REQUIRE(layout.has_value());
+        CHECK(layout->restartInterval == 5);
+        CHECK(layout->mcusPerRow == 4);
+        CHECK(layout->mcuRows == 3);
+        REQUIRE(layout->segments.size() == 3);
+
+        for(size_t i = 0; i < 3; ++i)
+        {
+            CHECK(layout->segments[i].offset == skeleton.segmentRanges[i][0]);
+            // The fill byte in front of a marker stays with the segment
+            CHECK(layout->segments[i].size == skeleton.segmentRanges[i][1] + ((i < 2) ? 1 : 0));
+            CHECK(layout->segments[i].firstMcu == i * 5);
+        }
+
+        CHECK(layout->segments[0].mcuCount == 5);
+        CHECK(layout->segments[2].mcuCount == 2);
+    }
+
+    SECTION("restart markers wrap around")
+    {
+        JpegSkeletonParams params;
+        params.width = 80;
+        params.height = 80;
+        params.sampling = {0x11};
+        params.restartInterval = 10;
+        params.segmentCount = 10;
+
+        const std::optional<JpegRestartLayout> layout = findJpegRestartSegments(makeJpegSkeleton(params).bytes);
+        REQUIRE(layout.has_value());
+        CHECK(layout->mcusPerRow == 10);
+        CHECK(layout->mcuRows == 10);
+        CHECK(layout->segments.size() == 10);
+        CHECK(layout->segments[9].firstMcu == 90);
+    }
+
+    SECTION("extended sequential")
+    {
+        JpegSkeletonParams params;
+        params.frameMarker = 0xc1;
+
+        CHECK(findJpegRestartSegments(makeJpegSkeleton(params).bytes).has_value());
+    }
+}
+
+TEST_CASE("jpeg restart segments fall back to serial decoding", "[jpeg]")
+{
+    JpegSkeletonParams params;
+
+    SECTION("no restart interval")
+    {
+        params.restartInterval = 0;
+        params.segmentCount = 1;
+    }
+
+    SECTION("progressive")
+    {
+        params.frameMarker = 0xc2;
+    }
+
+    SECTION("arithmetic coded")
+    {
+        params.frameMarker = 0xc9;
+    }
+
+    SECTION("restart markers out of sequence")
+    {
+        params.restartMarkers = {0, 2};
+    }
+
+    SECTION("missing restart marker")
+    {
+        params.segmentCount = 2;
+    }
+
+    SECTION("more than one scan")
+    {
+        params.secondScan = true;
+    }
+
+    SECTION("truncated")
+    {
+        params.endOfImage = false;
+    }
+
+    CHECK_FALSE(findJpegRestartSegments(makeJpegSkeleton(params).bytes).has_value());
+}
+
+TEST_CASE("jpeg restart segments reject other files", "[jpeg]")
+{
+    CHECK_FALSE(findJpegRestartSegments({}).has_value());
+    CHECK_FALSE(findJpegRestartSegments(std::vector<std::byte>(100, std::byte{0xff})).has_value());
+
+    // Cut off anywhere before the end of image
+    const std::vector<std::byte> bytes = makeJpegSkeleton({}).bytes;
+    for(size_t size = 0; size < bytes.size(); ++size)
+    {
+        CHECK_FALSE(findJpegRestartSegments(std::span(bytes).first(size)).has_value());
+    }
+}
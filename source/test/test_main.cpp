@@ -0,0 +1,15 @@
+#include "synthetic_images.h"
+
+#include <catch2/catch_session.hpp>
+
+#include <filesystem>
+
+int main(int argc, char* argv[])
+{
+    const int result = Catch::Session().run(argc, argv);
+
+    std::error_code ec;
+    std::filesystem::remove_all(syntheticImageDirectory(), ec);
+
+    return result;
+}
@@ -0,0 +1,111 @@
+#include "mapped_texture.h"
+#include "synthetic_images.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+#ifdef TEXIMP_ENABLE_DDS
+TEST_CASE("map dds", "[mapped][dds]")
+{
+    const BcFormat format = GENERATE(BcFormat::Bc1, BcFormat::Bc3);
+    const std::vector<std::byte> contents = makeBcDds(64, 32, format);
+    const fs::path filePath = writeSyntheticImage("mapped.dds", contents);
+
+    const std::optional<MappedTexture> mappedTexture = mapTexture(filePath);
+    REQUIRE(mappedTexture.has_value());
+
+    const cputex::TextureView& texture = mappedTexture->texture();
+    CHECK(texture.format() == ((format == BcFormat::Bc1) ? gpufmt::Format::BC1_RGBA_UNORM_BLOCK : gpufmt::Format::BC3_UNORM_BLOCK));
+    CHECK(texture.extent().x == 64);
+    CHECK(texture.extent().y == 32);
+    CHECK(texture.mips() == 1);
+
+    // The blocks follow the 128 byte header
+    const std::span<const std::byte> payload = std::span(contents).subspan(128);
+    REQUIRE(texture.sizeInBytes() == payload.size());
+    CHECK(std::ranges::equal(texture.getData(), payload));
+}
+
+TEST_CASE("map dds keeps 16 bit formats packed", "[mapped][dds]")
+{
+    const std::vector<std::byte> contents = makeRgb565Dds(16, 8);
+
+    const std::optional<MappedTexture> mappedTexture = mapTexture(writeSyntheticImage("mapped_565.dds", contents));
+    REQUIRE(mappedTexture.has_value());
+
+    const cputex::TextureView& texture = mappedTexture->texture();
+    CHECK(texture.format() == gpufmt::Format::R5G6B5_UNORM_PACK16);
+    REQUIRE(texture.sizeInBytes() == 16 * 8 * 2);
+    CHECK(std::ranges::equal(texture.getData(), std::span(contents).subspan(128)));
+}
+
+TEST_CASE("map dds preview skips larger mips", "[mapped][dds]")
+{
+    // 256x128 BC1 down to 1x1, 9 mips
+    const std::vector<std::byte> contents = makeBcDds(256, 128, BcFormat::Bc1, 0);
+    const fs::path filePath = writeSyntheticImage("mapped_mips.dds", contents);
+
+    SECTION("smallest mip at least as large as the target")
+    {
+        const std::optional<MappedTexture> mappedTexture = mapTexture(filePath, 64);
+        REQUIRE(mappedTexture.has_value());
+
+        const cputex::TextureView& texture = mappedTexture->texture();
+        CHECK(texture.extent().x == 64);
+        CHECK(texture.extent().y == 32);
+        CHECK(texture.mips() == 7);
+
+        // Mips 0 and 1 are 64x32 and 32x16 blocks of 8 bytes
+        const std::span<const std::byte> payload = std::span(contents).subspan(128 + 64 * 32 * 8 + 32 * 16 * 8);
+        REQUIRE(texture.sizeInBytes() == payload.size());
+        CHECK(std::ranges::equal(texture.getData(), payload));
+    }
+
+    SECTION("textures smaller than the target keep every mip")
+    {
+        const std::optional<MappedTexture> mappedTexture = mapTexture(filePath, 1024);
+        REQUIRE(mappedTexture.has_value());
+        CHECK(mappedTexture->texture().extent().x == 256);
+        CHECK(mappedTexture->texture().mips() == 9);
+    }
+}
+
+TEST_CASE("preview mip", "[mapped]")
+{
+    // 300x200 halves to 150x100, 75x50, 37x25, ...
+    const cputex::Extent extent{300, 200, 1};
+
+    CHECK(previewMip(extent, 9, 0) == 0);
+    CHECK(previewMip(extent, 9, 300) == 0);
+    CHECK(previewMip(extent, 9, 301) == 0);
+    CHECK(previewMip(extent, 9, 100) == 1);
+    CHECK(previewMip(extent, 9, 75) == 2);
+    CHECK(previewMip(extent, 9, 1) == 8);
+    // Never past the last mip the file has
+    CHECK(previewMip(extent, 2, 1) == 1);
+}
+
+TEST_CASE("map dds rejects truncated files", "[mapped][dds]")
+{
+    std::vector<std::byte> contents = makeBcDds(64, 64, BcFormat::Bc1);
+    contents.resize(contents.size() - 1);
+
+    CHECK_FALSE(mapTexture(writeSyntheticImage("mapped_truncated.dds", contents)).has_value());
+}
+#endif
+
+#ifdef TEXIMP_ENABLE_BITMAP
+TEST_CASE("map leaves other formats to the importer", "[mapped][bitmap]")
+{
+    CHECK_FALSE(mapTexture(writeSyntheticImage("mapped.bmp", makePalettedBitmap(16, 16, 8))).has_value());
+}
+#endif
@@ -0,0 +1,45 @@
+#include "memory_budget.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <thread>
+#include <vector>
+
+TEST_CASE("memory budget admits a request larger than the budget when idle", "[budget]")
+{
+    MemoryBudget budget(100);
+
+    budget.acquire(250);
+    CHECK(budget.inFlightBytes() == 100);
+
+    budget.release(250);
+    CHECK(budget.inFlightBytes() == 0);
+}
+
+TEST_CASE("memory budget bounds concurrent requests", "[budget]")
+{
+    MemoryBudget budget(100);
+
+    std::vector<std::jthread> threads;
+
+    for(int threadIndex = 0; threadIndex < 8; ++threadIndex)
+    {
+        threads.emplace_back([&budget, threadIndex]()
+            {
+                const uint64_t bytes = 10 + threadIndex * 10;
+
+                for(int i = 0; i < 200; ++i)
+                {
+                    budget.acquire(bytes);
+                    std::this_thread::yield();
+                    budget.release(bytes);
+                }
+            });
+    }
+
+    threads.clear();
+
+    CHECK(budget.inFlightBytes() == 0);
+    CHECK(budget.peakBytes() <= 100);
+    CHECK(budget.peakBytes() >= 80);
+}
@@ -0,0 +1,96 @@
+#include "palette_texture.h"
+#include "synthetic_images.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cputex/definitions.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+
+namespace
+{
+// Short runs of one color, like indexed images tend to have
+auto colorRuns(int colorCount)
+{
+    return [colorCount](size_t i) { return (uint32_t)((i / 3) % (size_t)colorCount) * 0x01030507u; };
+}
+}
+
+TEST_CASE("palettize texture", "[palette]")
+{
+    const cputex::UniqueTexture texture = makeTexture<uint32_t>(gpufmt::Format::B8G8R8A8_SRGB, 37, 20, 3, colorRuns(256));
+
+    const std::optional<PalettizedTexture> palettized = palettize(texture);
+    REQUIRE(palettized);
+
+    CHECK(palettized->colorCount == 256);
+    CHECK(palettized->indices.format() == gpufmt::Format::R8_UINT);
+    CHECK(palettized->indices.sizeInBytes() * 4 == texture.sizeInBytes());
+    CHECK(palettized->palette.format() == gpufmt::Format::B8G8R8A8_SRGB);
+    CHECK(palettized->palette.extent().x == 256);
+    CHECK(palettized->palette.extent().y == 1);
+
+    const cputex::TextureView view = texture;
+
+    for(cputex::CountType mip = 0; mip < view.mips(); ++mip)
+    {
+        const cputex::Extent mipExtent = cputex::calculateMipExtent(view.extent(), mip);
+        const std::span<const std::byte> surface = view.getMipSurfaceData(0, 0, mip);
+
+        for(int y = 0; y < mipExtent.y; ++y)
+        {
+            for(int x = 0; x < mipExtent.x; ++x)
+            {
+                const std::array<std::byte, 4> texel = samplePalettized(*palettized, 0, 0, mip, x, y);
+                REQUIRE(std::memcmp(texel.data(), surface.data() + ((size_t)y * mipExtent.x + x) * 4, texel.size()) == 0);
+            }
+        }
+    }
+}
+
+TEST_CASE("palettize unused palette entries", "[palette]")
+{
+    const cputex::UniqueTexture texture = makeTexture<uint32_t>(gpufmt::Format::R8G8B8A8_UNORM, 8, 8, 1, colorRuns(3));
+
+    const std::optional<PalettizedTexture> palettized = palettize(texture);
+    REQUIRE(palettized);
+
+    CHECK(palettized->colorCount == 3);
+
+    const std::span<const std::byte> palette = palettized->palette.getData();
+    for(size_t i = 3 * 4; i < palette.size(); ++i)
+    {
+        REQUIRE(palette[i] == std::byte{0});
+    }
+}
+
+TEST_CASE("palettize rejects", "[palette]")
+{
+    SECTION("too many colors")
+    {
+        CHECK_FALSE(palettize(makeTexture<uint32_t>(gpufmt::Format::R8G8B8A8_UNORM, 40, 40, 1, colorRuns(257))));
+    }
+
+    SECTION("too many colors across mips")
+    {
+        cputex::UniqueTexture texture = makeTexture<uint32_t>(gpufmt::Format::R8G8B8A8_UNORM, 32, 32, 2, colorRuns(256));
+        // The smallest mip is the last subresource
+        texture.accessData<uint32_t>().back() = 0xfefefefe;
+
+        CHECK_FALSE(palettize(texture));
+    }
+
+    SECTION("unsupported format")
+    {
+        cputex::TextureParams params;
+        params.format = gpufmt::Format::R16G16B16A16_SFLOAT;
+        params.dimension = cputex::TextureDimension::Texture2D;
+        params.extent = cputex::Extent{4, 4, 1};
+
+        CHECK_FALSE(palettize(cputex::UniqueTexture(params)));
+    }
+}
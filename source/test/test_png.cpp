@@ -0,0 +1,83 @@
+#include "synthetic_images.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <teximp/teximp.h>
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+#ifdef TEXIMP_ENABLE_PNG
+namespace
+{
+struct PngLayout
+{
+    PngColorType colorType;
+    int bitDepth;
+};
+
+// Pixels of 1 to 8 bytes and the sub byte gray depths, where the filters step a whole byte
+constexpr std::array kPngLayouts = {PngLayout{PngColorType::Gray, 1},
+                                    PngLayout{PngColorType::Gray, 2},
+                                    PngLayout{PngColorType::Gray, 4},
+                                    PngLayout{PngColorType::Gray, 8},
+                                    PngLayout{PngColorType::Gray, 16},
+                                    PngLayout{PngColorType::GrayAlpha, 8},
+                                    PngLayout{PngColorType::Rgb, 8},
+                                    PngLayout{PngColorType::GrayAlpha, 16},
+                                    PngLayout{PngColorType::Rgba, 8},
+                                    PngLayout{PngColorType::Rgb, 16},
+                                    PngLayout{PngColorType::Rgba, 16}};
+
+void requireImported(teximp::TextureImportResult& result)
+{
+    REQUIRE(result.importer != nullptr);
+    REQUIRE(result.importer->error() == teximp::TextureImportError::None);
+    REQUIRE(result.textureAllocator.getTextures().size() == 1);
+}
+}
+
+// The filtered image and its unfiltered twin only decode alike if every filter kernel matches the per byte
+// reference in synthetic_images.cpp, whatever format the importer hands the pixels out in
+TEST_CASE("png unfilter matches reference", "[png]")
+{
+    constexpr std::array kFilters = {PngFilter::Sub, PngFilter::Up, PngFilter::Average, PngFilter::Paeth};
+    // Widths that leave vector tails and Adam7 passes without pixels
+    constexpr std::array<std::array<int, 2>, 3> kSizes = {{{1, 1}, {5, 3}, {37, 23}}};
+
+    for(const PngLayout& layout : kPngLayouts)
+    {
+        for(const PngFilter filter : kFilters)
+        {
+            for(const bool interlaced : {false, true})
+            {
+                for(const std::array<int, 2>& size : kSizes)
+                {
+                    const PngParams params = {size[0], size[1], layout.colorType, layout.bitDepth, filter, interlaced};
+                    const std::string name = "unfilter " + std::to_string((int)layout.colorType) + "_" + std::to_string(layout.bitDepth) + "_" +
+                                             std::to_string((int)filter) + (interlaced ? "_adam7_" : "_") +
+                                             std::to_string(size[0]) + "x" + std::to_string(size[1]);
+                    INFO(name);
+
+                    teximp::TextureImportResult filtered = teximp::importTexture(writeSyntheticImage(name + ".png", makePng(params)));
+                    teximp::TextureImportResult unfiltered = teximp::importTexture(writeSyntheticImage(name + " none.png", makeUnfilteredPng(params)));
+                    requireImported(filtered);
+                    requireImported(unfiltered);
+
+                    const cputex::TextureView filteredTexture = filtered.textureAllocator.getTextures()[0];
+                    const cputex::TextureView unfilteredTexture = unfiltered.textureAllocator.getTextures()[0];
+
+                    REQUIRE(filteredTexture.format() == unfilteredTexture.format());
+                    REQUIRE(filteredTexture.extent().x == size[0]);
+                    REQUIRE(filteredTexture.extent().y == size[1]);
+                    REQUIRE(std::ranges::equal(filteredTexture.getData(), unfilteredTexture.getData()));
+                }
+            }
+        }
+    }
+}
+#endif
@@ -0,0 +1,144 @@
+#include "read_ahead.h"
+#include "synthetic_images.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The test target is built without io_uring, so these run the thread pool fallback
+
+namespace fs = std::filesystem;
+
+namespace
+{
+constexpr uint64_t kMiB = 1024 * 1024;
+
+std::vector<fs::path> writeFiles(const std::string& name, const std::vector<uint64_t>& sizes)
+{
+    std::vector<fs::path> filePaths;
+
+    for(size_t i = 0; i < sizes.size(); ++i)
+    {
+        filePaths.push_back(writeSyntheticImage(name + " " + std::to_string(i) + ".bin", std::vector<std::byte>(sizes[i], std::byte{0x5a})));
+    }
+
+    return filePaths;
+}
+
+uint64_t sum(const std::vector<uint64_t>& sizes)
+{
+    uint64_t total = 0;
+    for(const uint64_t size : sizes)
+    {
+        total += size;
+    }
+    return total;
+}
+}
+
+TEST_CASE("read ahead reads every file once", "[readahead]")
+{
+    const std::vector<uint64_t> sizes = {0, 1, 4096, 300 * 1024, kMiB, 17, 3 * kMiB, 256 * 1024, 5, 700 * 1024};
+    std::vector<fs::path> filePaths = writeFiles("read ahead once", sizes);
+
+    // Failing to open counts as read, so a missing file must not stall the files after it
+    filePaths.insert(filePaths.begin() + 3, fs::path(filePaths[0]).replace_filename("read ahead missing.bin"));
+
+    ReadAheadOptions options;
+    options.maxFilesInFlight = 3;
+    options.fallbackThreadCount = 2;
+
+    ReadAhead readAhead(filePaths, options);
+
+    for(size_t i = 0; i < filePaths.size(); ++i)
+    {
+        readAhead.waitUntilRead(i);
+        readAhead.release(i);
+    }
+
+    CHECK(readAhead.bytesRead() == sum(sizes));
+}
+
+TEST_CASE("read ahead stays within its byte budget", "[readahead]")
+{
+    ReadAheadOptions options;
+    options.maxFilesInFlight = 16;
+    options.maxBytesInFlight = 3 * kMiB;
+
+    SECTION("files smaller than the budget")
+    {
+        const std::vector<uint64_t> sizes(12, kMiB);
+        const std::vector<fs::path> filePaths = writeFiles("read ahead budget", sizes);
+
+        ReadAhead readAhead(filePaths, options);
+
+        for(size_t i = 0; i < filePaths.size(); ++i)
+        {
+            readAhead.waitUntilRead(i);
+
+            // Holding on to the first file until three are read puts a full budget in flight at once
+            while(i == 0 && readAhead.bytesRead() < options.maxBytesInFlight)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            CHECK(readAhead.peakBytesInFlight() <= options.maxBytesInFlight);
+
+            readAhead.release(i);
+        }
+
+        CHECK(readAhead.peakBytesInFlight() == options.maxBytesInFlight);
+        CHECK(readAhead.bytesRead() == sum(sizes));
+    }
+
+    SECTION("a file larger than the budget is read on its own")
+    {
+        const std::vector<uint64_t> sizes = {kMiB, 5 * kMiB, kMiB};
+        const std::vector<fs::path> filePaths = writeFiles("read ahead oversized", sizes);
+
+        ReadAhead readAhead(filePaths, options);
+
+        for(size_t i = 0; i < filePaths.size(); ++i)
+        {
+            readAhead.waitUntilRead(i);
+            readAhead.release(i);
+        }
+
+        CHECK(readAhead.peakBytesInFlight() == 5 * kMiB);
+        CHECK(readAhead.bytesRead() == sum(sizes));
+    }
+}
+
+TEST_CASE("read ahead stops with files unread", "[readahead]")
+{
+    const std::vector<uint64_t> sizes(64, 256 * 1024);
+    const std::vector<fs::path> filePaths = writeFiles("read ahead stop", sizes);
+
+    ReadAheadOptions options;
+    options.maxFilesInFlight = 4;
+
+    uint64_t bytesRead = 0;
+
+    {
+        ReadAhead readAhead(filePaths, options);
+
+        // Nothing is released, so the read ahead is blocked on its file limit when it is destroyed
+        readAhead.waitUntilRead(0);
+        readAhead.waitUntilRead(1);
+
+        bytesRead = readAhead.bytesRead();
+    }
+
+    CHECK(bytesRead >= 2 * 256 * 1024);
+    CHECK(bytesRead <= (uint64_t)options.maxFilesInFlight * 256 * 1024);
+
+    // Destroyed while every file could still start, none of them may keep it from stopping
+    options.maxFilesInFlight = 64;
+    {
+        ReadAhead readAhead(filePaths, options);
+    }
+}
@@ -0,0 +1,403 @@
+#include "staging_format.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace
+{
+std::vector<std::byte> toBytes(std::span<const uint8_t> values)
+{
+    std::vector<std::byte> bytes(values.size());
+    std::memcpy(bytes.data(), values.data(), values.size());
+    return bytes;
+}
+
+std::vector<uint16_t> toHalves(std::span<const std::byte> bytes)
+{
+    std::vector<uint16_t> values(bytes.size() / 2);
+    std::memcpy(values.data(), bytes.data(), bytes.size());
+    return values;
+}
+}
+
+TEST_CASE("half conversion", "[staging]")
+{
+    CHECK(floatToHalf(0.0f) == 0x0000);
+    CHECK(floatToHalf(-0.0f) == 0x8000);
+    CHECK(floatToHalf(1.0f) == 0x3c00);
+    CHECK(floatToHalf(-2.0f) == 0xc000);
+    CHECK(floatToHalf(65504.0f) == 0x7bff);
+    CHECK(floatToHalf(65520.0f) == 0x7c00);
+    CHECK(floatToHalf(std::numeric_limits<float>::infinity()) == 0x7c00);
+    CHECK(floatToHalf(std::ldexp(1.0f, -24)) == 0x0001);
+    CHECK(floatToHalf(std::ldexp(1.0f, -25)) == 0x0000);
+    // Ties round to even
+    CHECK(floatToHalf(1.0f + std::ldexp(1.0f, -11)) == 0x3c00);
+    CHECK(floatToHalf(1.0f + 3.0f * std::ldexp(1.0f, -11)) == 0x3c02);
+
+    CHECK((floatToHalf(std::numeric_limits<float>::quiet_NaN()) & 0x7fff) > 0x7c00);
+
+    for(uint32_t value = 0; value < 0x7c00; ++value)
+    {
+        REQUIRE(floatToHalf(halfToFloat((uint16_t)value)) == value);
+    }
+}
+
+TEST_CASE("staged formats", "[staging]")
+{
+    CHECK(stagedFormat(gpufmt::Format::B8G8R8A8_UNORM, StagingFormat::Native) == gpufmt::Format::B8G8R8A8_UNORM);
+    CHECK(stagedFormat(gpufmt::Format::B8G8R8A8_UNORM, StagingFormat::Rgba8) == gpufmt::Format::R8G8B8A8_UNORM);
+    CHECK(stagedFormat(gpufmt::Format::B8G8R8A8_SRGB, StagingFormat::Rgba8) == gpufmt::Format::R8G8B8A8_SRGB);
+    CHECK(stagedFormat(gpufmt::Format::R32G32B32A32_SFLOAT, StagingFormat::Rgba16Float) == gpufmt::Format::R16G16B16A16_SFLOAT);
+    CHECK(stagedFormat(gpufmt::Format::BC7_UNORM_BLOCK, StagingFormat::Rgba8) == gpufmt::Format::BC7_UNORM_BLOCK);
+    CHECK(stagedFormat(gpufmt::Format::E5B9G9R9_UFLOAT_PACK32, StagingFormat::Rgba8) == gpufmt::Format::UNDEFINED);
+}
+
+TEST_CASE("convert pixels", "[staging]")
+{
+    SECTION("bgra8 to rgba8")
+    {
+        const std::array<uint8_t, 8> source = {1, 2, 3, 4, 5, 6, 7, 8};
+        std::vector<std::byte> destination(8);
+
+        REQUIRE(convertPixels(toBytes(source), gpufmt::Format::B8G8R8A8_UNORM, destination, gpufmt::Format::R8G8B8A8_UNORM));
+        CHECK(destination == toBytes(std::array<uint8_t, 8>{3, 2, 1, 4, 7, 6, 5, 8}));
+    }
+
+    SECTION("r8 to rgba8")
+    {
+        const std::array<uint8_t, 2> source = {10, 20};
+        std::vector<std::byte> destination(8);
+
+        REQUIRE(convertPixels(toBytes(source), gpufmt::Format::R8_UNORM, destination, gpufmt::Format::R8G8B8A8_UNORM));
+        CHECK(destination == toBytes(std::array<uint8_t, 8>{10, 0, 0, 255, 20, 0, 0, 255}));
+    }
+
+    SECTION("rgba32f to rgba8 clamps")
+    {
+        const std::array<float, 4> source = {-1.0f, 0.5f, 2.0f, 1.0f};
+        std::vector<std::byte> destination(4);
+
+        REQUIRE(convertPixels(std::as_bytes(std::span(source)), gpufmt::Format::R32G32B32A32_SFLOAT, destination, gpufmt::Format::R8G8B8A8_UNORM));
+        CHECK(destination == toBytes(std::array<uint8_t, 4>{0, 128, 255, 255}));
+    }
+
+    SECTION("srgb to rgba16f linearizes color but not alpha")
+    {
+        const std::array<uint8_t, 4> source = {0, 188, 255, 188};
+        std::vector<std::byte> destination(8);
+
+        REQUIRE(convertPixels(toBytes(source), gpufmt::Format::R8G8B8A8_SRGB, destination, gpufmt::Format::R16G16B16A16_SFLOAT));
+
+        const std::vector<uint16_t> halves = toHalves(destination);
+        CHECK(halves[0] == floatToHalf(0.0f));
+        CHECK(std::abs(halfToFloat(halves[1]) - 0.5f) < 0.01f);
+        CHECK(halves[2] == floatToHalf(1.0f));
+        CHECK(halves[3] == floatToHalf(188.0f / 255.0f));
+    }
+
+    SECTION("mismatched sizes")
+    {
+        const std::array<uint8_t, 4> source = {1, 2, 3, 4};
+        std::vector<std::byte> destination(7);
+
+        CHECK_FALSE(convertPixels(toBytes(source), gpufmt::Format::R8G8B8A8_UNORM, destination, gpufmt::Format::R16G16B16A16_SFLOAT));
+    }
+}
+
+TEST_CASE("channel analysis", "[staging]")
+{
+    SECTION("gray with opaque alpha")
+    {
+        const std::array<uint8_t, 8> pixels = {10, 10, 10, 255, 200, 200, 200, 255};
+        ChannelAnalysis analysis(gpufmt::Format::R8G8B8A8_UNORM);
+
+        REQUIRE(analysis.supported());
+        CHECK(analysis.add(toBytes(pixels)));
+
+        const ChannelContent content = analysis.content();
+        CHECK(content.opaque);
+        CHECK(content.grayscale);
+        CHECK(content.constant == std::array{false, false, false, true});
+        CHECK(content.constantValues[3] == 255);
+    }
+
+    SECTION("color with alpha stops early")
+    {
+        const std::array<uint8_t, 8> pixels = {10, 20, 30, 0, 10, 20, 30, 255};
+        ChannelAnalysis analysis(gpufmt::Format::B8G8R8A8_UNORM);
+
+        CHECK_FALSE(analysis.add(toBytes(pixels)));
+
+        const ChannelContent content = analysis.content();
+        CHECK_FALSE(content.opaque);
+        CHECK_FALSE(content.grayscale);
+        // RGBA order, not memory order
+        CHECK(content.constant == std::array{true, true, true, false});
+        CHECK(content.constantValues == std::array<uint8_t, 4>{30, 20, 10, 0});
+    }
+
+    SECTION("surfaces are combined")
+    {
+        ChannelAnalysis analysis(gpufmt::Format::R8G8B8_UNORM);
+
+        CHECK(analysis.add(toBytes(std::array<uint8_t, 3>{5, 5, 5})));
+        CHECK(analysis.add(toBytes(std::array<uint8_t, 3>{7, 7, 7})));
+
+        const ChannelContent content = analysis.content();
+        CHECK(content.opaque);
+        CHECK(content.grayscale);
+        CHECK_FALSE(content.constant[0]);
+    }
+
+    SECTION("gray across block boundaries")
+    {
+        std::vector<uint8_t> pixels(10000 * 4);
+        for(size_t i = 0; i < pixels.size(); ++i)
+        {
+            pixels[i] = (uint8_t)(i / 4);
+        }
+
+        ChannelAnalysis analysis(gpufmt::Format::R8G8B8A8_UNORM);
+        CHECK(analysis.add(toBytes(pixels)));
+        CHECK(analysis.content().grayscale);
+        CHECK_FALSE(analysis.content().opaque);
+
+        pixels[9999 * 4 + 1] ^= 1;
+
+        ChannelAnalysis changedAnalysis(gpufmt::Format::R8G8B8A8_UNORM);
+        CHECK_FALSE(changedAnalysis.add(toBytes(pixels)));
+        CHECK_FALSE(changedAnalysis.content().grayscale);
+    }
+
+    SECTION("unsupported formats")
+    {
+        ChannelAnalysis analysis(gpufmt::Format::R16G16B16A16_SFLOAT);
+
+        CHECK_FALSE(analysis.supported());
+        CHECK_FALSE(analysis.content().opaque);
+    }
+}
+
+TEST_CASE("narrow formats", "[staging]")
+{
+    ChannelContent content;
+    content.constant = {false, false, false, true};
+    content.constantValues = {0, 0, 0, 255};
+
+    SECTION("gray")
+    {
+        const std::optional<FormatNarrowing> narrowing = narrowFormat(gpufmt::Format::R8G8B8A8_SRGB, content);
+
+        REQUIRE(narrowing);
+        CHECK(narrowing->format == gpufmt::Format::R8_SRGB);
+        CHECK(narrowing->swizzle == "rrr1");
+
+        const std::array<uint8_t, 8> source = {10, 10, 10, 255, 200, 200, 200, 255};
+        std::vector<std::byte> destination(2);
+
+        REQUIRE(narrowPixels(toBytes(source), gpufmt::Format::R8G8B8A8_SRGB, destination, *narrowing));
+        CHECK(destination == toBytes(std::array<uint8_t, 2>{10, 200}));
+    }
+
+    SECTION("gray with alpha")
+    {
+        content.opaque = false;
+        content.constant[3] = false;
+
+        const std::optional<FormatNarrowing> narrowing = narrowFormat(gpufmt::Format::B8G8R8A8_UNORM, content);
+
+        REQUIRE(narrowing);
+        CHECK(narrowing->format == gpufmt::Format::R8G8_UNORM);
+        CHECK(narrowing->swizzle == "rrrg");
+
+        const std::array<uint8_t, 8> source = {10, 10, 10, 0, 200, 200, 200, 128};
+        std::vector<std::byte> destination(4);
+
+        REQUIRE(narrowPixels(toBytes(source), gpufmt::Format::B8G8R8A8_UNORM, destination, *narrowing));
+        CHECK(destination == toBytes(std::array<uint8_t, 4>{10, 0, 200, 128}));
+
+        // No two component format decodes sRGB gray and keeps alpha linear
+        CHECK_FALSE(narrowFormat(gpufmt::Format::B8G8R8A8_SRGB, content));
+        CHECK_FALSE(narrowFormat(gpufmt::Format::R8G8B8A8_SRGB, content));
+    }
+
+    SECTION("unused blue")
+    {
+        content.grayscale = false;
+        content.constant[2] = true;
+
+        const std::optional<FormatNarrowing> narrowing = narrowFormat(gpufmt::Format::B8G8R8A8_UNORM, content);
+
+        REQUIRE(narrowing);
+        CHECK(narrowing->format == gpufmt::Format::R8G8_UNORM);
+        CHECK(narrowing->swizzle == "rgba");
+
+        const std::array<uint8_t, 4> source = {0, 20, 30, 255};
+        std::vector<std::byte> destination(2);
+
+        REQUIRE(narrowPixels(toBytes(source), gpufmt::Format::B8G8R8A8_UNORM, destination, *narrowing));
+        CHECK(destination == toBytes(std::array<uint8_t, 2>{30, 20}));
+    }
+
+    SECTION("opaque color")
+    {
+        content.grayscale = false;
+
+        const std::optional<FormatNarrowing> narrowing = narrowFormat(gpufmt::Format::R8G8B8A8_UNORM, content);
+
+        REQUIRE(narrowing);
+        CHECK(narrowing->format == gpufmt::Format::B8G8R8X8_UNORM);
+
+        const std::array<uint8_t, 4> source = {10, 20, 30, 255};
+        std::vector<std::byte> destination(4);
+
+        REQUIRE(narrowPixels(toBytes(source), gpufmt::Format::R8G8B8A8_UNORM, destination, *narrowing));
+        CHECK(destination == toBytes(std::array<uint8_t, 4>{30, 20, 10, 255}));
+
+        // Already as narrow as it gets
+        CHECK_FALSE(narrowFormat(gpufmt::Format::B8G8R8X8_UNORM, content));
+        CHECK_FALSE(narrowFormat(gpufmt::Format::R8G8B8A8_SRGB, content));
+    }
+
+    SECTION("nothing to narrow")
+    {
+        content.grayscale = false;
+        content.opaque = false;
+
+        CHECK_FALSE(narrowFormat(gpufmt::Format::R8G8B8A8_UNORM, content));
+        CHECK_FALSE(narrowFormat(gpufmt::Format::R32G32B32A32_SFLOAT, ChannelContent{}));
+    }
+}
+
+TEST_CASE("narrow widened 16 bit content", "[staging]")
+{
+    // Widens the way importers do, by bit replication or by rounding
+    const auto widen = [](uint32_t value, int bits, bool replicate)
+    {
+        const uint32_t maxValue = (1u << bits) - 1;
+        if(!replicate || bits == 1) { return (uint8_t)((value * 255 + maxValue / 2) / maxValue); }
+        return (uint8_t)((value << (8 - bits)) | (value >> (2 * bits - 8)));
+    };
+
+    const bool replicate = GENERATE(true, false);
+
+    SECTION("r5g6b5")
+    {
+        std::vector<uint8_t> pixels;
+        std::vector<uint16_t> expected;
+
+        for(uint32_t value = 0; value < 64; ++value)
+        {
+            const uint32_t r = value % 32;
+            const uint32_t g = 63 - value;
+            const uint32_t b = (value * 7) % 32;
+
+            pixels.insert(pixels.end(), {widen(b, 5, replicate), widen(g, 6, replicate), widen(r, 5, replicate), 255});
+            expected.push_back((uint16_t)((r << 11) | (g << 5) | b));
+        }
+
+        ChannelAnalysis analysis(gpufmt::Format::B8G8R8A8_UNORM);
+        CHECK(analysis.add(toBytes(pixels)));
+
+        const std::optional<FormatNarrowing> narrowing = narrowFormat(gpufmt::Format::B8G8R8A8_UNORM, analysis.content());
+        REQUIRE(narrowing);
+        CHECK(narrowing->format == gpufmt::Format::R5G6B5_UNORM_PACK16);
+
+        std::vector<std::byte> destination(expected.size() * 2);
+        REQUIRE(narrowPixels(toBytes(pixels), gpufmt::Format::B8G8R8A8_UNORM, destination, *narrowing));
+        CHECK(toHalves(destination) == expected);
+    }
+
+    SECTION("a1r5g5b5")
+    {
+        std::vector<uint8_t> pixels;
+        std::vector<uint16_t> expected;
+
+        for(uint32_t value = 0; value < 64; ++value)
+        {
+            const uint32_t a = value % 2;
+            const uint32_t r = value % 32;
+            const uint32_t g = 31 - value % 32;
+            const uint32_t b = (value * 3) % 32;
+
+            pixels.insert(pixels.end(), {widen(r, 5, replicate), widen(g, 5, replicate), widen(b, 5, replicate), widen(a, 1, replicate)});
+            expected.push_back((uint16_t)((a << 15) | (r << 10) | (g << 5) | b));
+        }
+
+        ChannelAnalysis analysis(gpufmt::Format::R8G8B8A8_UNORM);
+        CHECK(analysis.add(toBytes(pixels)));
+
+        const std::optional<FormatNarrowing> narrowing = narrowFormat(gpufmt::Format::R8G8B8A8_UNORM, analysis.content());
+        REQUIRE(narrowing);
+        CHECK(narrowing->format == gpufmt::Format::A1R5G5B5_UNORM_PACK16);
+
+        std::vector<std::byte> destination(expected.size() * 2);
+        REQUIRE(narrowPixels(toBytes(pixels), gpufmt::Format::R8G8B8A8_UNORM, destination, *narrowing));
+        CHECK(toHalves(destination) == expected);
+    }
+
+    SECTION("a4r4g4b4")
+    {
+        std::vector<uint8_t> pixels;
+        std::vector<uint16_t> expected;
+
+        for(uint32_t value = 0; value < 16; ++value)
+        {
+            const uint32_t a = 15 - value;
+            const uint32_t r = value;
+            const uint32_t g = (value * 5) % 16;
+            const uint32_t b = (value * 3) % 16;
+
+            pixels.insert(pixels.end(), {widen(r, 4, replicate), widen(g, 4, replicate), widen(b, 4, replicate), widen(a, 4, replicate)});
+            expected.push_back((uint16_t)((a << 12) | (r << 8) | (g << 4) | b));
+        }
+
+        ChannelAnalysis analysis(gpufmt::Format::R8G8B8A8_UNORM);
+        CHECK(analysis.add(toBytes(pixels)));
+
+        const std::optional<FormatNarrowing> narrowing = narrowFormat(gpufmt::Format::R8G8B8A8_UNORM, analysis.content());
+        REQUIRE(narrowing);
+        CHECK(narrowing->format == gpufmt::Format::A4R4G4B4_UNORM_PACK16);
+
+        std::vector<std::byte> destination(expected.size() * 2);
+        REQUIRE(narrowPixels(toBytes(pixels), gpufmt::Format::R8G8B8A8_UNORM, destination, *narrowing));
+        CHECK(toHalves(destination) == expected);
+    }
+
+    SECTION("full 8 bit content")
+    {
+        std::vector<uint8_t> pixels;
+        for(uint32_t value = 0; value < 256; ++value)
+        {
+            pixels.insert(pixels.end(), {(uint8_t)value, (uint8_t)(255 - value), (uint8_t)(value * 7), 255});
+        }
+
+        ChannelAnalysis analysis(gpufmt::Format::R8G8B8A8_UNORM);
+        CHECK(analysis.add(toBytes(pixels)));
+
+        const std::optional<FormatNarrowing> narrowing = narrowFormat(gpufmt::Format::R8G8B8A8_UNORM, analysis.content());
+        REQUIRE(narrowing);
+        CHECK(narrowing->format == gpufmt::Format::B8G8R8X8_UNORM);
+    }
+
+    SECTION("srgb stays 8 bit")
+    {
+        const std::array<uint8_t, 4> pixels = {widen(3, 5, replicate), widen(9, 6, replicate), widen(17, 5, replicate), 255};
+
+        ChannelAnalysis analysis(gpufmt::Format::R8G8B8A8_SRGB);
+        analysis.add(toBytes(pixels));
+
+        CHECK(analysis.content().fitsBits == std::array<uint8_t, 4>{});
+        CHECK_FALSE(narrowFormat(gpufmt::Format::R8G8B8A8_SRGB, analysis.content()));
+    }
+}
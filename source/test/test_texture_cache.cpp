@@ -0,0 +1,208 @@
+#include "synthetic_images.h"
+#include "texture_cache.h"
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <cputex/definitions.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+bool sameTexture(const cputex::TextureView& a, const cputex::TextureView& b)
+{
+    return a.format() == b.format() &&
+        a.extent().x == b.extent().x &&
+        a.extent().y == b.extent().y &&
+        a.mips() == b.mips() &&
+        std::ranges::equal(a.getData(), b.getData());
+}
+
+fs::path makeCacheDirectory(std::string_view name)
+{
+    const fs::path directory = syntheticImageDirectory() / name;
+    fs::remove_all(directory);
+    return directory;
+}
+}
+
+TEST_CASE("texture cache round trip", "[cache]")
+{
+    const fs::path sourcePath = writeSyntheticImage("cache_source.bin", std::vector<std::byte>(1000, std::byte{42}));
+
+    TextureCacheOptions options;
+    options.directory = makeCacheDirectory("cache");
+    options.importerVersion = "test";
+
+    std::vector<cputex::UniqueTexture> textures;
+    textures.push_back(makeTexture<uint8_t>(gpufmt::Format::R8G8B8A8_UNORM, 13, 7, 3, [](size_t i) { return (uint8_t)(i * 31 + 7); }));
+    textures.push_back(makeTexture<uint8_t>(gpufmt::Format::R8G8B8A8_UNORM, 64, 64, 1, [](size_t) { return (uint8_t)0; }));
+
+    SECTION("uncompressed")
+    {
+        const TextureCache cache(options);
+
+        const std::optional<TextureCacheKey> key = cache.computeKey(sourcePath);
+        REQUIRE(key.has_value());
+        CHECK_FALSE(cache.find(*key).has_value());
+
+        REQUIRE(cache.store(*key, textures));
+
+        const std::optional<CachedTextures> cachedTextures = cache.find(*key);
+        REQUIRE(cachedTextures.has_value());
+        REQUIRE(cachedTextures->textures().size() == 2);
+        CHECK(sameTexture(cachedTextures->textures()[0], textures[0]));
+        CHECK(sameTexture(cachedTextures->textures()[1], textures[1]));
+    }
+
+    SECTION("compressed")
+    {
+        options.compress = true;
+        const TextureCache cache(options);
+
+        const std::optional<TextureCacheKey> key = cache.computeKey(sourcePath);
+        REQUIRE(key.has_value());
+        REQUIRE(cache.store(*key, textures));
+
+        const std::optional<CachedTextures> cachedTextures = cache.find(*key);
+        REQUIRE(cachedTextures.has_value());
+        REQUIRE(cachedTextures->textures().size() == 2);
+        CHECK(sameTexture(cachedTextures->textures()[0], textures[0]));
+        CHECK(sameTexture(cachedTextures->textures()[1], textures[1]));
+    }
+
+    SECTION("keys")
+    {
+        const TextureCache cache(options);
+        const std::optional<TextureCacheKey> key = cache.computeKey(sourcePath);
+
+        options.importerVersion = "other";
+        const std::optional<TextureCacheKey> otherVersionKey = TextureCache(options).computeKey(sourcePath);
+
+        std::vector<std::byte> changedContents(1000, std::byte{42});
+        changedContents[999] = std::byte{43};
+        const std::optional<TextureCacheKey> changedKey = cache.computeKey(writeSyntheticImage("cache_changed.bin", changedContents));
+
+        REQUIRE(key.has_value());
+        REQUIRE(otherVersionKey.has_value());
+        REQUIRE(changedKey.has_value());
+        CHECK(key->hash != otherVersionKey->hash);
+        CHECK(key->hash != changedKey->hash);
+    }
+
+    SECTION("hits refresh only stale entry times")
+    {
+        const TextureCache cache(options);
+
+        const std::optional<TextureCacheKey> key = cache.computeKey(sourcePath);
+        REQUIRE(key.has_value());
+        REQUIRE(cache.store(*key, textures));
+
+        const fs::path entryPath = options.directory / (key->toString() + ".texc");
+        const fs::file_time_type now = fs::file_time_type::clock::now();
+
+        // Read back, the file system may store times more coarsely than the clock
+        fs::last_write_time(entryPath, now - std::chrono::minutes(30));
+        const fs::file_time_type recent = fs::last_write_time(entryPath);
+        REQUIRE(cache.find(*key).has_value());
+        CHECK(fs::last_write_time(entryPath) == recent);
+
+        fs::last_write_time(entryPath, now - std::chrono::hours(2));
+        REQUIRE(cache.find(*key).has_value());
+        CHECK(fs::last_write_time(entryPath) > now - std::chrono::minutes(1));
+    }
+
+    SECTION("truncated entries are misses")
+    {
+        const TextureCache cache(options);
+
+        const std::optional<TextureCacheKey> key = cache.computeKey(sourcePath);
+        REQUIRE(key.has_value());
+        REQUIRE(cache.store(*key, textures));
+
+        const fs::path entryPath = options.directory / (key->toString() + ".texc");
+        REQUIRE(fs::exists(entryPath));
+        fs::resize_file(entryPath, fs::file_size(entryPath) - 1);
+
+        CHECK_FALSE(cache.find(*key).has_value());
+    }
+
+    SECTION("corrupt entries")
+    {
+        const std::optional<TextureCacheKey> key = TextureCache(options).computeKey(sourcePath);
+        REQUIRE(key.has_value());
+        REQUIRE(TextureCache(options).store(*key, textures));
+
+        const fs::path entryPath = options.directory / (key->toString() + ".texc");
+        const auto flipByte = [&entryPath](uintmax_t offset)
+        {
+            std::fstream file(entryPath, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekg((std::streamoff)offset);
+            const char value = (char)file.get();
+            file.seekp((std::streamoff)offset);
+            file.put((char)(value ^ 1));
+        };
+
+        const auto findWith = [&](CacheVerification verification)
+        {
+            TextureCacheOptions verifyingOptions = options;
+            verifyingOptions.verification = verification;
+            return TextureCache(verifyingOptions).find(*key).has_value();
+        };
+
+        SECTION("texture data")
+        {
+            // The last byte belongs to the second texture
+            flipByte(fs::file_size(entryPath) - 1);
+
+            CHECK_FALSE(findWith(CacheVerification::All));
+            CHECK(findWith(CacheVerification::Metadata));
+            CHECK(findWith(CacheVerification::None));
+        }
+
+        SECTION("metadata")
+        {
+            // The reserved field of the first texture record, which no bounds check looks at
+            flipByte(40 + 44);
+
+            CHECK_FALSE(findWith(CacheVerification::All));
+            CHECK_FALSE(findWith(CacheVerification::Metadata));
+            CHECK(findWith(CacheVerification::None));
+        }
+
+        // Caught even unverified, cputex must never see a format or dimension that does not exist
+        SECTION("record enums")
+        {
+            const uintmax_t recordField = GENERATE(40 + 0, 40 + 4);
+
+            std::fstream file(entryPath, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp((std::streamoff)recordField);
+            const uint32_t value = 0xffff;
+            file.write((const char*)&value, sizeof(value));
+            file.close();
+
+            CHECK_FALSE(findWith(CacheVerification::None));
+        }
+
+        // Still in bounds, but not where cputex puts the first texture's top mip
+        SECTION("subresource table")
+        {
+            std::fstream file(entryPath, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(40 + 2 * 80 + 8);
+            const uint64_t size = 0;
+            file.write((const char*)&size, sizeof(size));
+            file.close();
+
+            CHECK_FALSE(findWith(CacheVerification::None));
+        }
+    }
+}
@@ -0,0 +1,161 @@
+#include "synthetic_images.h"
+#include "thumbnail_pack.h"
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <cputex/definitions.h>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+// Fills RGBA8 texture data with the pixels repeated in order
+auto repeatPixels(std::vector<std::array<uint8_t, 4>> pixels)
+{
+    return [pixels = std::move(pixels)](size_t i) { return pixels[(i / 4) % pixels.size()][i % 4]; };
+}
+
+std::array<uint8_t, 4> thumbnailPixel(const Thumbnail& thumbnail, int x, int y)
+{
+    const size_t offset = ((size_t)y * thumbnail.width + x) * 4;
+    return {(uint8_t)thumbnail.pixels[offset], (uint8_t)thumbnail.pixels[offset + 1], (uint8_t)thumbnail.pixels[offset + 2], (uint8_t)thumbnail.pixels[offset + 3]};
+}
+}
+
+TEST_CASE("thumbnails are filtered in linear space", "[thumbnail]")
+{
+    // Black and white average to half the light, which sRGB encodes as 188, not 128
+    const cputex::UniqueTexture texture = makeTexture<uint8_t>(gpufmt::Format::R8G8B8A8_UNORM, 2, 1, 1, repeatPixels({{0, 0, 0, 255}, {255, 255, 255, 255}}));
+
+    const std::optional<Thumbnail> thumbnail = makeThumbnail(texture, 1, ResampleFilter::Box);
+    REQUIRE(thumbnail.has_value());
+    REQUIRE(thumbnail->width == 1);
+    REQUIRE(thumbnail->height == 1);
+    CHECK(thumbnailPixel(*thumbnail, 0, 0) == std::array<uint8_t, 4>{188, 188, 188, 255});
+}
+
+TEST_CASE("thumbnails do not bleed transparent colors", "[thumbnail]")
+{
+    const cputex::UniqueTexture texture = makeTexture<uint8_t>(gpufmt::Format::R8G8B8A8_UNORM, 2, 1, 1, repeatPixels({{255, 0, 0, 255}, {0, 255, 0, 0}}));
+
+    const std::optional<Thumbnail> thumbnail = makeThumbnail(texture, 1, ResampleFilter::Box);
+    REQUIRE(thumbnail.has_value());
+    CHECK(thumbnailPixel(*thumbnail, 0, 0) == std::array<uint8_t, 4>{255, 0, 0, 128});
+}
+
+TEST_CASE("thumbnails keep their aspect ratio", "[thumbnail]")
+{
+    const cputex::UniqueTexture wide = makeTexture<uint8_t>(gpufmt::Format::R8G8B8A8_UNORM, 300, 100, 1, repeatPixels({{10, 20, 30, 255}}));
+    const std::optional<Thumbnail> wideThumbnail = makeThumbnail(wide, 64, ResampleFilter::Lanczos3);
+    REQUIRE(wideThumbnail.has_value());
+    CHECK(wideThumbnail->width == 64);
+    CHECK(wideThumbnail->height == 21);
+    CHECK(wideThumbnail->pixels.size() == 64 * 21 * 4);
+    CHECK(thumbnailPixel(*wideThumbnail, 63, 20) == std::array<uint8_t, 4>{10, 20, 30, 255});
+
+    // Never scaled up
+    const cputex::UniqueTexture small = makeTexture<uint8_t>(gpufmt::Format::R8G8B8A8_UNORM, 16, 8, 1, repeatPixels({{10, 20, 30, 255}}));
+    const std::optional<Thumbnail> smallThumbnail = makeThumbnail(small, 64, ResampleFilter::Lanczos3);
+    REQUIRE(smallThumbnail.has_value());
+    CHECK(smallThumbnail->width == 16);
+    CHECK(smallThumbnail->height == 8);
+}
+
+// Hand written headers, 40 bytes: magic, version, size, reserved, then entry count, data offset and file size
+TEST_CASE("thumbnail pack rejects entries overlapping the header", "[thumbnail]")
+{
+    constexpr uint64_t kSlotSize = 32 * 32 * 4;
+
+    const auto writePack = [](uint64_t dataOffset, uint64_t fileSize)
+    {
+        std::vector<std::byte> bytes(fileSize);
+        const std::array<uint32_t, 4> words = {0x50545854, 1, 32, 0};
+        const std::array<uint64_t, 3> sizes = {1, dataOffset, fileSize};
+        std::memcpy(bytes.data(), words.data(), sizeof(words));
+        std::memcpy(bytes.data() + sizeof(words), sizes.data(), sizeof(sizes));
+        return writeSyntheticImage("thumbnails_handwritten.pack", bytes);
+    };
+
+    CHECK(openThumbnailPack(writePack(4096, 4096 + kSlotSize)).has_value());
+
+    // The single entry would be read from inside the header, and past its end with a larger count
+    CHECK_FALSE(openThumbnailPack(writePack(0, kSlotSize)).has_value());
+    CHECK_FALSE(openThumbnailPack(writePack(48, 48 + kSlotSize)).has_value());
+}
+
+#ifdef TEXIMP_ENABLE_BITMAP
+TEST_CASE("thumbnail pack updates only changed files", "[thumbnail]")
+{
+    const fs::path packPath = syntheticImageDirectory() / "thumbnails.pack";
+    fs::remove(packPath);
+
+    std::vector<fs::path> filePaths;
+    for(int i = 0; i < 6; ++i)
+    {
+        filePaths.push_back(writeSyntheticImage("thumbnail" + std::to_string(i) + ".bmp", makePalettedBitmap(40 + i * 20, 30, 8)));
+    }
+
+    // Imports, but is not an image, and a file that cannot be read at all
+    filePaths.push_back(writeSyntheticImage("thumbnail_garbage.bmp", std::vector<std::byte>(100, std::byte{7})));
+    filePaths.push_back(syntheticImageDirectory() / "thumbnail_missing.bmp");
+
+    ThumbnailOptions options;
+    options.size = 32;
+    options.threadCount = 3;
+    options.importerVersion = "test";
+
+    const ThumbnailPackUpdate first = updateThumbnailPack(packPath, filePaths, options);
+    CHECK(first.written);
+    CHECK(first.fileCount == 8);
+    CHECK(first.computedCount == 6);
+    CHECK(first.reusedCount == 0);
+    CHECK(first.failedCount == 2);
+
+    {
+        const std::optional<ThumbnailPack> pack = openThumbnailPack(packPath);
+        REQUIRE(pack.has_value());
+        CHECK(pack->thumbnailSize() == 32);
+        CHECK(pack->thumbnailCount() == 7);
+
+        for(int i = 0; i < 6; ++i)
+        {
+            const std::optional<ThumbnailKey> key = computeThumbnailKey(filePaths[i], options);
+            REQUIRE(key.has_value());
+
+            const std::optional<cputex::TextureView> thumbnail = pack->find(*key);
+            REQUIRE(thumbnail.has_value());
+            CHECK(thumbnail->format() == gpufmt::Format::R8G8B8A8_SRGB);
+            CHECK(thumbnail->extent().x == 32);
+            CHECK(thumbnail->extent().y == (30 * 32 + (40 + i * 20) / 2) / (40 + i * 20));
+        }
+
+        CHECK_FALSE(pack->find(*computeThumbnailKey(filePaths[6], options)).has_value());
+    }
+
+    // The garbage file is remembered as failed and not imported again
+    const ThumbnailPackUpdate unchanged = updateThumbnailPack(packPath, filePaths, options);
+    CHECK(unchanged.computedCount == 0);
+    CHECK(unchanged.reusedCount == 7);
+    CHECK(unchanged.failedCount == 1);
+
+    writeSyntheticImage("thumbnail2.bmp", makePalettedBitmap(64, 64, 8));
+
+    const ThumbnailPackUpdate changed = updateThumbnailPack(packPath, filePaths, options);
+    CHECK(changed.computedCount == 1);
+    CHECK(changed.reusedCount == 6);
+
+    // Another size is another set of keys
+    options.size = 16;
+    const ThumbnailPackUpdate resized = updateThumbnailPack(packPath, filePaths, options);
+    CHECK(resized.computedCount == 6);
+    CHECK(resized.reusedCount == 0);
+}
+#endif
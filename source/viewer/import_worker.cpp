@@ -0,0 +1,68 @@
+#include "import_worker.h"
+
+ImportWorker::ImportWorker()
+    : mThread([this](std::stop_token stopToken) { run(stopToken); })
+{
+}
+
+ImportWorker::~ImportWorker()
+{
+    mThread.request_stop();
+}
+
+void ImportWorker::request(std::filesystem::path filePath)
+{
+    std::optional<teximp::TextureImportResult> staleResult;
+
+    {
+        std::scoped_lock lock(mMutex);
+        mRequestStop.request_stop();
+        mRequestStop = std::stop_source();
+        mPendingPath = std::move(filePath);
+
+        // Destroyed outside the lock, freeing a large texture can take a while
+        staleResult = std::move(mResult);
+        mResult.reset();
+    }
+
+    mCondition.notify_one();
+}
+
+std::optional<teximp::TextureImportResult> ImportWorker::takeResult()
+{
+    std::scoped_lock lock(mMutex);
+
+    std::optional<teximp::TextureImportResult> result = std::move(mResult);
+    mResult.reset();
+    return result;
+}
+
+void ImportWorker::run(std::stop_token stopToken)
+{
+    while(!stopToken.stop_requested())
+    {
+        std::filesystem::path filePath;
+        std::stop_token requestStop;
+
+        {
+            std::unique_lock lock(mMutex);
+            if(!mCondition.wait(lock, stopToken, [this]() { return mPendingPath.has_value(); })) { return; }
+
+            filePath = std::move(*mPendingPath);
+            mPendingPath.reset();
+            requestStop = mRequestStop.get_token();
+        }
+
+        if(requestStop.stop_requested() || stopToken.stop_requested()) { continue; }
+
+        // Runs to completion even if the request is stopped part way through
+        teximp::TextureImportResult result = teximp::importTexture(filePath);
+
+        std::scoped_lock lock(mMutex);
+
+        // A newer request arrived or the worker is stopping, the result is dropped when it goes out of scope
+        if(requestStop.stop_requested() || stopToken.stop_requested()) { continue; }
+
+        mResult = std::move(result);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <teximp/teximp.h>
+
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+
+// Imports textures on a background thread so the UI keeps running while a large file decodes.
+//
+// Only the most recent request matters. Every request carries a stop token that the next request stops. A
+// request that has not started yet is replaced by the next one, and one that is stopped before the worker gets
+// to it is never imported.
+//
+// An import that is already decoding is NOT interrupted. teximp has no way to stop an import part way through,
+// so an abandoned decode runs to completion and only its result is dropped, as is the result of any import that
+// finishes after the worker is told to stop. Skipping through files costs at most one abandoned import rather
+// than one per file, and destroying the worker waits for an in-flight import to finish.
+class ImportWorker
+{
+public:
+    ImportWorker();
+    ~ImportWorker();
+
+    ImportWorker(const ImportWorker&) = delete;
+    ImportWorker& operator=(const ImportWorker&) = delete;
+
+    void request(std::filesystem::path filePath);
+
+    // Result of the latest request, once it has finished importing.
+    std::optional<teximp::TextureImportResult> takeResult();
+
+private:
+    void run(std::stop_token stopToken);
+
+    std::mutex mMutex;
+    std::condition_variable_any mCondition;
+    std::optional<std::filesystem::path> mPendingPath;
+    std::optional<teximp::TextureImportResult> mResult;
+    // Stopped by the next request
+    std::stop_source mRequestStop;
+
+    // Declared last so the thread starts after, and is joined before, everything it uses
+    std::jthread mThread;
+};
@@ -69,7 +69,8 @@ void Viewer::drawUI()
         const auto now = std::chrono::steady_clock::now();
         const auto delta = now - mLastAutoTime;
 
-        if(delta > mAutoPauseDuration)
+        // Wait for the current file to finish importing so auto mode never skips a file
+        if(delta > mAutoPauseDuration && !mImportPending)
         {
             mLastAutoTime = now;
 
@@ -156,7 +157,11 @@ void Viewer::drawUI()
         nextTestImage();
     }
 
-    if(mTextureData.valid())
+    if(mImportPending)
+    {
+        ImGui::TextUnformatted("Importing...");
+    }
+    else if(mTextureData.valid())
     {
         if(mTextureData.hasImportError())
         {
@@ -275,22 +280,38 @@ void Viewer::renderUpdate(ID3D12Device* d3dDevice, ID3D12GraphicsCommandList* d3
 
     mFreeQueue.erase(newEnd, mFreeQueue.end());
 
-    if(!mSelectionChanged) { return; }
+    if(mSelectionChanged)
+    {
+        mSelectionChanged = false;
+        const auto filePath = mBaseDirectory / kTestFiles[(size_t)mSelectedFileFormat][mSelectedTestFile];
 
-    mSelectionChanged = false;
-    const auto filePath = mBaseDirectory / kTestFiles[(size_t)mSelectedFileFormat][mSelectedTestFile];
+        for(auto& resource : mTextureData.resources)
+        {
+            resource.lastUsedFrame = mFrame;
+        }
 
-    for(auto& resource : mTextureData.resources)
-    {
-        resource.lastUsedFrame = mFrame;
+        mFreeQueue.insert(mFreeQueue.end(),
+            std::move_iterator(mTextureData.resources.begin()),
+            std::move_iterator(mTextureData.resources.end()));
+
+        mTextureData = {};
+
+        if(!mImportWorker)
+        {
+            mImportWorker = std::make_unique<ImportWorker>();
+        }
+
+        mImportWorker->request(filePath);
+        mImportPending = true;
     }
 
-    mFreeQueue.insert(mFreeQueue.end(),
-        std::move_iterator(mTextureData.resources.begin()),
-        std::move_iterator(mTextureData.resources.end()));
+    if(!mImportPending) { return; }
+
+    std::optional<teximp::TextureImportResult> importResult = mImportWorker->takeResult();
+    if(!importResult) { return; }
 
-    mTextureData = {};
-    mTextureData.importResult = teximp::importTexture(filePath);
+    mImportPending = false;
+    mTextureData.importResult = std::move(*importResult);
 
     if(mTextureData.importResult.importer->error() != teximp::TextureImportError::None) { return; }
 
@@ -1,11 +1,14 @@
 #pragma once
 
+#include "import_worker.h"
+
 #include <d3d12.h>
 #include <teximp/teximp.h>
 #include <wrl/client.h>
 
 #include <chrono>
 #include <filesystem>
+#include <memory>
 #include <set>
 #include <vector>
 
@@ -99,6 +102,8 @@ private:
     void createD3d12PipelineStates(ID3D12Device* d3dDevice);
 
     bool mSelectionChanged = true;
+    bool mImportPending = false;
+    std::unique_ptr<ImportWorker> mImportWorker;
     int64_t mFrame = 0;
     std::set<int> mAvailableDescriptorIndices;
     Microsoft::WRL::ComPtr<ID3D12RootSignature> mRootSignature;